@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstring>
+
 #include "include/lce/processor.hpp"
-#if defined(__AVX2__)
+#include "common/cpu.hpp"
+#if CPU_X86_SIMD
 #include <immintrin.h>
 #endif
 
@@ -36,35 +39,19 @@ namespace editor::chunk {
     }
 
 
-#if defined(__AVX2__)
-#define HAS_AVX2 1
-    static inline bool _chunk_has_byte_NEQ(const __m256i& v,
-                                          __m256i pattern) noexcept {
-        // v == pattern  → 0xFF bytes (cmp-true = 0xFF)
-        // v != pattern  → 0x00 somewhere → mask ≠ −1
-        __m256i cmp = _mm256_cmpeq_epi8(v, pattern);
-        return !_mm256_testc_si256(cmp, _mm256_set1_epi8(-1));
-    }
-#else
-#define HAS_AVX2 0
-#endif
-
-    /// Fast path for AVX2 (4 × 32 B = 128 B, unaligned OK)
+#if CPU_X86_SIMD
+    /// SSE2 path (8 × 16 B = 128 B, unaligned OK), every x86-64 CPU has it
     template<u8 V>
-    static inline bool _is_all_val_128_avx2(const u8* p) noexcept {
-#if HAS_AVX2
-        __m256i pattern = _mm256_set1_epi8(V);
-
-        for (int i = 0; i < 4; ++i) {
-            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i * 32));
-            if (_chunk_has_byte_NEQ(v, pattern)) return false;
+    static inline bool _is_all_val_128_sse2(const u8* p) noexcept {
+        const __m128i pattern = _mm_set1_epi8(static_cast<char>(V));
+        __m128i diff = _mm_setzero_si128();
+        for (int i = 0; i < 8; ++i) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 16));
+            diff = _mm_or_si128(diff, _mm_xor_si128(v, pattern));
         }
-        return true;
-#else
-        (void) p; // suppress “unused” when AVX2 absent
-        return false;
-#endif
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) == 0xFFFF;
     }
+#endif
 
     /// Portable scalar fallback (8 B at a time, no branches in loop)
     template<u8 V>
@@ -81,8 +68,8 @@ namespace editor::chunk {
     /// public wrapper
     /// checks if the next 128 bytes are all "0x00"
     static inline bool is_zero_128(const u8* p) noexcept {
-#if HAS_AVX2
-        return _is_all_val_128_avx2<0x00>(p);
+#if CPU_X86_SIMD
+        return _is_all_val_128_sse2<0x00>(p);
 #else
         return _is_all_val_128_scalar<0x00>(p);
 #endif
@@ -91,10 +78,104 @@ namespace editor::chunk {
     /// public wrapper
     /// checks if the next 128 bytes are all "0xFF"
     static inline bool is_ff_128(const u8* p) noexcept {
-#if HAS_AVX2
-        return _is_all_val_128_avx2<0xFF>(p);
+#if CPU_X86_SIMD
+        return _is_all_val_128_sse2<0xFF>(p);
 #else
         return _is_all_val_128_scalar<0xFF>(p);
 #endif
     }
-}
\ No newline at end of file
+
+
+    // #####################################################
+    // #               Page Scanning
+    // #####################################################
+
+
+    /// what a 128-byte page holds, the values are the ones light section headers use
+    enum ePageFill : u8 {
+        PAGE_MIXED = 0,
+        PAGE_ZERO = 128,
+        PAGE_FF = 129,
+    };
+
+
+    static inline void _scan_pages_scalar(c_u8* data, c_int count, u8* fills) noexcept {
+        for (int page = 0; page < count; page++, data += 128) {
+            u64 anyBits = 0, allBits = ~0ULL;
+            for (int i = 0; i < 128; i += 8) {
+                u64 word;
+                std::memcpy(&word, data + i, 8);
+                anyBits |= word;
+                allBits &= word;
+            }
+            fills[page] = anyBits == 0 ? PAGE_ZERO : allBits == ~0ULL ? PAGE_FF : PAGE_MIXED;
+        }
+    }
+
+
+#if CPU_X86_SIMD
+    static inline void _scan_pages_sse2(c_u8* data, c_int count, u8* fills) noexcept {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i ones = _mm_set1_epi8(-1);
+        for (int page = 0; page < count; page++, data += 128) {
+            __m128i anyBits = zero, allBits = ones;
+            for (int i = 0; i < 8; i++) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16));
+                anyBits = _mm_or_si128(anyBits, v);
+                allBits = _mm_and_si128(allBits, v);
+            }
+            c_bool isZero = _mm_movemask_epi8(_mm_cmpeq_epi8(anyBits, zero)) == 0xFFFF;
+            c_bool isFF = _mm_movemask_epi8(_mm_cmpeq_epi8(allBits, ones)) == 0xFFFF;
+            fills[page] = isZero ? PAGE_ZERO : isFF ? PAGE_FF : PAGE_MIXED;
+        }
+    }
+
+
+    CPU_TARGET_AVX2
+    static void _scan_pages_avx2(c_u8* data, c_int count, u8* fills) noexcept {
+        const __m256i ones = _mm256_set1_epi8(-1);
+        for (int page = 0; page < count; page++, data += 128) {
+            __m256i anyBits = _mm256_setzero_si256(), allBits = ones;
+            for (int i = 0; i < 4; i++) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i * 32));
+                anyBits = _mm256_or_si256(anyBits, v);
+                allBits = _mm256_and_si256(allBits, v);
+            }
+            c_bool isZero = _mm256_testz_si256(anyBits, anyBits);
+            c_bool isFF = _mm256_testc_si256(allBits, ones);
+            fills[page] = isZero ? PAGE_ZERO : isFF ? PAGE_FF : PAGE_MIXED;
+        }
+    }
+
+
+    CPU_TARGET_AVX512
+    static void _scan_pages_avx512(c_u8* data, c_int count, u8* fills) noexcept {
+        const __m512i ones = _mm512_set1_epi8(-1);
+        for (int page = 0; page < count; page++, data += 128) {
+            const __m512i a = _mm512_loadu_si512(data);
+            const __m512i b = _mm512_loadu_si512(data + 64);
+            c_bool isZero = _mm512_test_epi8_mask(a, a) == 0 && _mm512_test_epi8_mask(b, b) == 0;
+            c_bool isFF = _mm512_cmpneq_epi8_mask(_mm512_and_si512(a, b), ones) == 0;
+            fills[page] = isZero ? PAGE_ZERO : isFF ? PAGE_FF : PAGE_MIXED;
+        }
+    }
+#endif
+
+
+    /**
+     * Classifies count pages of 128 bytes as all zeros, all 0xFF or mixed, in one pass
+     * per page. Meant for whole light sections, so the instruction set is picked once per call.
+     */
+    static inline void scanPages(c_u8* data, c_int count, u8* fills) noexcept {
+#if CPU_X86_SIMD
+        switch (cmn::simdLevel()) {
+            case cmn::eSimdLevel::AVX512: _scan_pages_avx512(data, count, fills); return;
+            case cmn::eSimdLevel::AVX2: _scan_pages_avx2(data, count, fills); return;
+            case cmn::eSimdLevel::SCALAR: _scan_pages_scalar(data, count, fills); return;
+            default: _scan_pages_sse2(data, count, fills); return;
+        }
+#else
+        _scan_pages_scalar(data, count, fills);
+#endif
+    }
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+
+#include "include/lce/processor.hpp"
+#include "code/Chunk/chunkData.hpp"
+#include "common/cpu.hpp"
+#if CPU_X86_SIMD
+#include <immintrin.h>
+#endif
+
+
+/**
+ * Re-layout kernels for converting block, data and light arrays between eBlockOrder's.
+ * \n\n
+ * Every layout used by the chunk formats keeps either y or x contiguous, with the
+ * (z, x) column index running in the same direction. A conversion between a
+ * y-contiguous and an x-contiguous layout is then a set of 16x16 transposes, one
+ * per (16 y-values, z) tile. The tile offsets are computed at compile time from
+ * toIndex, so each conversion is a table walk followed by a fixed-size kernel.
+ */
+namespace editor::chunk::order {
+
+
+    static constexpr int TILE = 16;
+
+
+    template<eBlockOrder ORDER>
+    static constexpr i32 xStride() { return toIndex<ORDER>(1, 0, 0) - toIndex<ORDER>(0, 0, 0); }
+
+    template<eBlockOrder ORDER>
+    static constexpr i32 yStride() { return toIndex<ORDER>(0, 1, 0) - toIndex<ORDER>(0, 0, 0); }
+
+
+    struct Tile {
+        u32 src;
+        u32 dst;
+    };
+
+
+    /**
+     * Precomputed tile table for FROM -> TO over a column of the given height.
+     * Row r of a source tile is TILE contiguous elements starting at src + r * SRC_STRIDE,
+     * and becomes column r of the destination tile, whose rows start at dst + c * DST_STRIDE.
+     */
+    template<eBlockOrder FROM, eBlockOrder TO, int HEIGHT>
+    struct TransposePlan {
+        static constexpr bool FROM_Y_CONTIGUOUS = yStride<FROM>() == 1;
+
+        static_assert((FROM_Y_CONTIGUOUS && xStride<TO>() == 1) ||
+                      (xStride<FROM>() == 1 && yStride<TO>() == 1),
+                      "orders must swap the contiguous axis");
+
+        static constexpr i32 SRC_STRIDE = FROM_Y_CONTIGUOUS ? xStride<FROM>() : yStride<FROM>();
+        static constexpr i32 DST_STRIDE = FROM_Y_CONTIGUOUS ? yStride<TO>() : xStride<TO>();
+        static constexpr int TILE_COUNT = HEIGHT / TILE * 16;
+
+        static constexpr std::array<Tile, TILE_COUNT> TILES = [] {
+            std::array<Tile, TILE_COUNT> tiles{};
+            int index = 0;
+            for (int z = 0; z < 16; z++) {
+                for (int y = 0; y < HEIGHT; y += TILE) {
+                    tiles[index++] = {static_cast<u32>(toIndex<FROM>(0, y, z)),
+                                      static_cast<u32>(toIndex<TO>(0, y, z))};
+                }
+            }
+            return tiles;
+        }();
+    };
+
+
+    // #####################################################
+    // #               Tile Kernels
+    // #####################################################
+
+
+#if CPU_X86_SIMD
+    /// transposes 16 rows of 16 bytes in registers
+    static inline void transpose16x16(__m128i rows[16]) noexcept {
+        // four rounds of a perfect shuffle between the top and bottom halves
+        for (int round = 0; round < 4; round++) {
+            __m128i next[16];
+            for (int i = 0; i < 8; i++) {
+                next[i * 2] = _mm_unpacklo_epi8(rows[i], rows[i + 8]);
+                next[i * 2 + 1] = _mm_unpackhi_epi8(rows[i], rows[i + 8]);
+            }
+            for (int i = 0; i < 16; i++) { rows[i] = next[i]; }
+        }
+    }
+
+
+    /// 8 bytes of nibbles -> 16 bytes, low nibble first
+    static inline __m128i expandNibbles(c_u8* src) noexcept {
+        const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+        const __m128i mask = _mm_set1_epi8(0x0F);
+        const __m128i lo = _mm_and_si128(packed, mask);
+        const __m128i hi = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+        return _mm_unpacklo_epi8(lo, hi);
+    }
+
+
+    /// 16 bytes (each < 16) -> 8 bytes of nibbles, low nibble first
+    static inline void packNibbles(const __m128i values, u8* dst) noexcept {
+        const __m128i even = _mm_and_si128(values, _mm_set1_epi16(0x00FF));
+        const __m128i odd = _mm_srli_epi16(values, 8);
+        const __m128i merged = _mm_or_si128(even, _mm_slli_epi16(odd, 4));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(merged, merged));
+    }
+#endif
+
+
+    static inline void transposeTileBytes(c_u8* src, c_i32 srcStride, u8* dst, c_i32 dstStride) noexcept {
+#if CPU_X86_SIMD
+        __m128i rows[16];
+        for (int r = 0; r < TILE; r++) {
+            rows[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + r * srcStride));
+        }
+        transpose16x16(rows);
+        for (int c = 0; c < TILE; c++) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + c * dstStride), rows[c]);
+        }
+#else
+        for (int r = 0; r < TILE; r++) {
+            for (int c = 0; c < TILE; c++) {
+                dst[c * dstStride + r] = src[r * srcStride + c];
+            }
+        }
+#endif
+    }
+
+
+    /// strides and offsets are in nibbles, and always even
+    static inline void transposeTileNibbles(c_u8* src, c_i32 srcStride, u8* dst, c_i32 dstStride) noexcept {
+#if CPU_X86_SIMD
+        __m128i rows[16];
+        for (int r = 0; r < TILE; r++) {
+            rows[r] = expandNibbles(src + r * srcStride / 2);
+        }
+        transpose16x16(rows);
+        for (int c = 0; c < TILE; c++) {
+            packNibbles(rows[c], dst + c * dstStride / 2);
+        }
+#else
+        u8 values[TILE][TILE];
+        for (int r = 0; r < TILE; r++) {
+            c_u8* row = src + r * srcStride / 2;
+            for (int c = 0; c < TILE; c += 2) {
+                values[c][r] = row[c / 2] & 0x0F;
+                values[c + 1][r] = row[c / 2] >> 4;
+            }
+        }
+        for (int c = 0; c < TILE; c++) {
+            u8* row = dst + c * dstStride / 2;
+            for (int r = 0; r < TILE; r += 2) {
+                row[r / 2] = static_cast<u8>(values[c][r] | values[c][r + 1] << 4);
+            }
+        }
+#endif
+    }
+
+
+    // #####################################################
+    // #               Public
+    // #####################################################
+
+
+    /// re-lays out a byte per block array
+    template<eBlockOrder FROM, eBlockOrder TO, int HEIGHT>
+    static void transposeBytes(c_u8* src, u8* dst) noexcept {
+        using Plan = TransposePlan<FROM, TO, HEIGHT>;
+        for (const Tile& tile : Plan::TILES) {
+            transposeTileBytes(src + tile.src, Plan::SRC_STRIDE, dst + tile.dst, Plan::DST_STRIDE);
+        }
+    }
+
+
+    /// re-lays out a nibble per block array (data, block light and sky light)
+    template<eBlockOrder FROM, eBlockOrder TO, int HEIGHT>
+    static void transposeNibbles(c_u8* src, u8* dst) noexcept {
+        using Plan = TransposePlan<FROM, TO, HEIGHT>;
+        static_assert(Plan::SRC_STRIDE % 2 == 0 && Plan::DST_STRIDE % 2 == 0);
+        for (const Tile& tile : Plan::TILES) {
+            transposeTileNibbles(src + tile.src / 2, Plan::SRC_STRIDE,
+                                 dst + tile.dst / 2, Plan::DST_STRIDE);
+        }
+    }
+
+
+    /// dst[i] = ids[i] << 4 | nibble i of data, for layouts that already match
+    static void widenBlocks(c_u8* ids, c_u8* data, u16* dst, c_i32 count) noexcept {
+        i32 i = 0;
+#if CPU_X86_SIMD
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= count; i += 16) {
+            const __m128i id = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ids + i));
+            const __m128i nib = expandNibbles(data + i / 2);
+            const __m128i lo = _mm_or_si128(_mm_slli_epi16(_mm_unpacklo_epi8(id, zero), 4),
+                                            _mm_unpacklo_epi8(nib, zero));
+            const __m128i hi = _mm_or_si128(_mm_slli_epi16(_mm_unpackhi_epi8(id, zero), 4),
+                                            _mm_unpackhi_epi8(nib, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), lo);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), hi);
+        }
+#endif
+        for (; i < count; i++) {
+            dst[i] = static_cast<u16>(ids[i] << 4 | (data[i / 2] >> (i & 1) * 4 & 0x0F));
+        }
+    }
+
+
+    /// splits u16 blocks into their low byte and low nibble, for layouts that already match
+    static void narrowBlocks(const u16* src, u8* lowBytes, u8* data, c_i32 count) noexcept {
+        i32 i = 0;
+#if CPU_X86_SIMD
+        const __m128i byteMask = _mm_set1_epi16(0x00FF);
+        for (; i + 16 <= count; i += 16) {
+            const __m128i a = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), byteMask);
+            const __m128i b = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)), byteMask);
+            const __m128i bytes = _mm_packus_epi16(a, b);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lowBytes + i), bytes);
+            packNibbles(_mm_and_si128(bytes, _mm_set1_epi8(0x0F)), data + i / 2);
+        }
+#endif
+        for (; i < count; i += 2) {
+            lowBytes[i] = static_cast<u8>(src[i]);
+            lowBytes[i + 1] = static_cast<u8>(src[i + 1]);
+            data[i / 2] = static_cast<u8>((src[i] & 0x0F) | (src[i + 1] & 0x0F) << 4);
+        }
+    }
+
+
+}
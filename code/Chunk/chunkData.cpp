@@ -1,5 +1,6 @@
 #include "chunkData.hpp"
 
+#include "code/Chunk/blockOrder.hpp"
 #include "common/nbt.hpp"
 #include "helpers.hpp"
 #include "include/lce/blocks/blockID.hpp"
@@ -11,7 +12,35 @@ namespace editor::chunk {
     ChunkData::~ChunkData() = default;
 
 
+    void ChunkData::reset() {
+        oldBlocks.clear();
+        blockData.clear();
+        newBlocks.clear();
+        submerged.clear();
+        hasSubmerged = false;
+        blockLight.clear();
+        skyLight.clear();
+        heightMap.clear();
+        biomes.clear();
+        oldNBTData = makeCompound({});
+        terrainPopulated = 0;
+        lastUpdate = 0;
+        inhabitedTime = 0;
+        entities = NBTBase();
+        tileEntities = NBTBase();
+        tileTicks = NBTBase();
+        DataGroupCount = 0;
+        chunkX = 0;
+        chunkZ = 0;
+        chunkHeight = 256;
+        lastVersion = 0;
+        validChunk = false;
+        dirty = false;
+    }
+
+
     void ChunkData::defaultNBT() {
+        dirty = true;
         entities = makeList(eNBT::COMPOUND, {});
         tileEntities = makeList(eNBT::COMPOUND, {});
         tileTicks = makeList(eNBT::COMPOUND, {});
@@ -23,49 +52,35 @@ namespace editor::chunk {
     }
 
 
+    u64 ChunkData::getMemoryUsage() const {
+        return sizeof(ChunkData)
+               + oldBlocks.capacity() + blockData.capacity()
+               + newBlocks.capacity() * sizeof(u16) + submerged.capacity() * sizeof(u16)
+               + blockLight.getMemoryUsage() + skyLight.getMemoryUsage()
+               + heightMap.capacity() + biomes.capacity();
+    }
+
+
 
 
 
 
     MU void ChunkData::convertNBT128ToAquatic() {
+        dirty = true;
 
-        // BLOCKS
-        newBlocks = u16_vec(65536);
-        for (int xIter = 0; xIter < 16; xIter++) {
-            for (int zIter = 0; zIter < 16; zIter++) {
-                for (int yIter = 0; yIter < 128; yIter++) {
-                    c_u16 block = getBlock<eChunkVersion::V_UNVERSIONED>(xIter, yIter, zIter);
-                    setBlock<eChunkVersion::V_12>(xIter, yIter, zIter, block);
-                }
-            }
-        }
+        // BLOCKS, yXZy with y < 128 on both sides
+        newBlocks.assign(65536, 0);
+        order::widenBlocks(oldBlocks.data(), blockData.data(), newBlocks.data(), 32768);
         u8_vec().swap(oldBlocks);
 
         // BLOCK LIGHT
         u8_vec tempLight(32'768);
-        for (int xIter = 0; xIter < 16; ++xIter) {
-            for (int zIter = 0; zIter < 16; ++zIter) {
-                for (int yIter = 0; yIter < 128; ++yIter) {
-                    c_i32 oldOffset = toIndex<yXZ>(xIter, yIter, zIter);
-                    c_u8 nib = getNibble(blockLight, oldOffset);
-                    c_i32 newOffset = toIndex<XZY>(xIter, yIter, zIter);
-                    setNibble(tempLight, newOffset, nib);
-                }
-            }
-        }
+        order::transposeNibbles<yXZ, XZY, 128>(blockLight.data(), tempLight.data());
         blockLight.swap(tempLight);
 
-        // SKYLIGHT
-        for (int xIter = 0; xIter < 16; ++xIter) {
-            for (int zIter = 0; zIter < 16; ++zIter) {
-                for (int yIter = 0; yIter < 128; ++yIter) {
-                    c_i32 oldOffset = toIndex<yXZ>(xIter, yIter, zIter);
-                    c_u8 nib = getNibble(skyLight, oldOffset);
-                    c_i32 newOffset = toIndex<XZY>(xIter, yIter, zIter);
-                    setNibble(tempLight, newOffset, nib);
-                }
-            }
-        }
+        // SKYLIGHT, reuses the old block light buffer
+        tempLight.resize(32'768);
+        order::transposeNibbles<yXZ, XZY, 128>(skyLight.data(), tempLight.data());
         skyLight.swap(tempLight);
         memset(skyLight.data() + 16384, 0xFF, 16384);
 
@@ -74,45 +89,21 @@ namespace editor::chunk {
 
 
     MU void ChunkData::convertNBT256ToAquatic() {
-        newBlocks = u16_vec(65536);
-        for (int xIter = 0; xIter < 16; xIter++) {
-            for (int zIter = 0; zIter < 16; zIter++) {
-                for (int yIter = 0; yIter < 256; yIter++) {
-                    c_u16 block = getBlock<eChunkVersion::V_NBT>(xIter, yIter, zIter);
-                    setBlock<eChunkVersion::V_12>(xIter, yIter, zIter, block);
-                }
-            }
-        }
-        // std::cout << "made it past get and set\n";
-        // std::cout << std::flush;
+        dirty = true;
 
+        // BLOCKS, both yXZy
+        newBlocks.assign(65536, 0);
+        order::widenBlocks(oldBlocks.data(), blockData.data(), newBlocks.data(), 65536);
         u8_vec().swap(oldBlocks);
 
         // BLOCK LIGHT
         u8_vec tempLight(32'768);
-        for (int xIter = 0; xIter < 16; ++xIter) {
-            for (int zIter = 0; zIter < 16; ++zIter) {
-                for (int yIter = 0; yIter < 256; ++yIter) {
-                    c_i32 oldOffset = toIndex<yXZy>(xIter, yIter, zIter);
-                    c_i32 newOffset = toIndex<XZY>(xIter, yIter, zIter);
-                    c_u8 nib = getNibble(blockLight, oldOffset);
-                    setNibble(tempLight, newOffset, nib);
-                }
-            }
-        }
+        order::transposeNibbles<yXZy, XZY, 256>(blockLight.data(), tempLight.data());
         blockLight.swap(tempLight);
 
         // SKYLIGHT
-        for (int xIter = 0; xIter < 16; ++xIter) {
-            for (int zIter = 0; zIter < 16; ++zIter) {
-                for (int yIter = 0; yIter < 256; ++yIter) {
-                    c_i32 oldOffset = toIndex<yXZy>(xIter, yIter, zIter);
-                    c_i32 newOffset = toIndex<XZY>(xIter, yIter, zIter);
-                    c_u8 nib = getNibble(skyLight, oldOffset);
-                    setNibble(tempLight, newOffset, nib);
-                }
-            }
-        }
+        tempLight.resize(32'768);
+        order::transposeNibbles<yXZy, XZY, 256>(skyLight.data(), tempLight.data());
         skyLight.swap(tempLight);
         u8_vec().swap(tempLight);
 
@@ -121,39 +112,40 @@ namespace editor::chunk {
 
 
     MU void ChunkData::convertOldToAquatic() {
-        newBlocks = u16_vec(65536);
-        for (int xIter = 0; xIter < 16; xIter++) {
-            for (int zIter = 0; zIter < 16; zIter++) {
-                for (int yIter = 0; yIter < 256; yIter++) {
+        dirty = true;
 
-                    c_u16 block = getBlock<eChunkVersion::V_11>(xIter, yIter, zIter);
-                    setBlock<eChunkVersion::V_12>(xIter, yIter, zIter, block);
+        thread_local u8_vec ids(65536);
+        thread_local u8_vec data(32768);
+        order::transposeBytes<XZY, yXZy, 256>(oldBlocks.data(), ids.data());
+        order::transposeNibbles<XZY, yXZy, 256>(blockData.data(), data.data());
+
+        newBlocks.assign(65536, 0);
+        order::widenBlocks(ids.data(), data.data(), newBlocks.data(), 65536);
 
-                    // c_i32 newOffset = toIndex<yXZy>(xIter, yIter, zIter);
-                    // newBlocks[newOffset] = block;
-                }
-            }
-        }
         lastVersion = 12;
         u8_vec().swap(oldBlocks);
     }
 
 
     void ChunkData::convertAquaticToElytra() {
-        oldBlocks = u8_vec(65536);
-        for (int xIter = 0; xIter < 16; xIter++) {
-            for (int zIter = 0; zIter < 16; zIter++) {
-                for (int yIter = 0; yIter < 256; yIter++) {
-
-                    u16 block = getBlock<eChunkVersion::V_12>(xIter, yIter, zIter);
-                    if (((block & 0x1FF0) >> 4) > 255) {
-                            block = lce::blocks::COBBLESTONE_ID << 4;
-                    }
-
-                    setBlock<eChunkVersion::V_11>(xIter, yIter, zIter, block);
-                }
+        dirty = true;
+
+        for (u16& block : newBlocks) {
+            if (block & 0x1000) { // id > 255
+                block = lce::blocks::COBBLESTONE_ID << 4;
             }
         }
+
+        // like setBlock<V_11>, the block byte is the low byte of the u16
+        thread_local u8_vec lowBytes(65536);
+        thread_local u8_vec data(32768);
+        order::narrowBlocks(newBlocks.data(), lowBytes.data(), data.data(), 65536);
+
+        oldBlocks.assign(65536, 0);
+        blockData.assign(32768, 0);
+        order::transposeBytes<yXZy, XZY, 256>(lowBytes.data(), oldBlocks.data());
+        order::transposeNibbles<yXZy, XZY, 256>(data.data(), blockData.data());
+
         lastVersion = 11;
         u16_vec().swap(newBlocks);
         u16_vec().swap(submerged);
@@ -165,6 +157,7 @@ namespace editor::chunk {
      *
      */
     MU void ChunkData::convert114ToAquatic() {
+        dirty = true;
 
         // remove 1.14 blocks here...
         for (int i = 0; i < 65536; i++) {
@@ -202,6 +195,7 @@ namespace editor::chunk {
 
     template<eChunkVersion chunkVersion>
     MU void ChunkData::setSubmerged(c_i32 xIn, c_i32 yIn, c_i32 zIn, c_u16 block) {
+        dirty = true;
         switch (chunkVersion) {
             case eChunkVersion::V_12:
             case eChunkVersion::V_13: {
@@ -218,6 +212,7 @@ namespace editor::chunk {
 
 
     MU void ChunkData::setBlock(c_i32 xIn, c_i32 yIn, c_i32 zIn, c_u16 block) {
+        dirty = true;
         switch (lastVersion) {
             case eChunkVersion::V_UNVERSIONED:
             case eChunkVersion::V_NBT: {
@@ -248,6 +243,7 @@ namespace editor::chunk {
 
     template<eChunkVersion chunkVersion>
     MU void ChunkData::setBlock(c_i32 xIn, c_i32 yIn, c_i32 zIn, c_u16 block) {
+        dirty = true;
         switch (chunkVersion) {
             case eChunkVersion::V_UNVERSIONED:
             case eChunkVersion::V_NBT: {
@@ -6,6 +6,8 @@
 
 #include "common/nbt.hpp"
 
+#include "lightData.hpp"
+
 namespace editor::chunk {
 
 
@@ -58,7 +60,7 @@ namespace editor::chunk {
     }
 
     template<eBlockOrder ORDER>
-    static i32 toIndex(i32 x, i32 y, i32 z) {
+    static constexpr i32 toIndex(i32 x, i32 y, i32 z) {
         switch (ORDER) {
             // case eBlockOrder::XYZ: return x      + y* 16 + z*4096;
             case eBlockOrder::XZY: return x      + y*256 + z*  16;
@@ -109,8 +111,8 @@ namespace editor::chunk {
         bool hasSubmerged = false;
 
         // all versions
-        u8_vec blockLight;          //
-        u8_vec skyLight;            //
+        LightData blockLight;       //
+        LightData skyLight;         //
         u8_vec heightMap;           //
         u8_vec biomes;              //
         NBTBase oldNBTData = makeCompound({}); //
@@ -131,14 +133,31 @@ namespace editor::chunk {
         i32 lastVersion = 0;
         bool validChunk = false;
 
+        /// set by every modifier, unmodified chunks are written back from their original bytes
+        bool dirty = false;
+
         ~ChunkData();
 
+        /// returns to the default state, vectors are emptied but keep their capacity
+        void reset();
+
         MU ND std::string getCoords() const;
 
+        /// estimated heap usage of the block, light and map arrays
+        ND u64 getMemoryUsage() const;
+
         void defaultNBT();
 
         // MODIFIERS
 
+        /// call after editing fields directly instead of through a modifier
+        MU void markDirty() { dirty = true; }
+        MU ND bool isDirty() const { return dirty; }
+
+        MU void setEntities(NBTBase nbt) { entities = std::move(nbt); dirty = true; }
+        MU void setTileEntities(NBTBase nbt) { tileEntities = std::move(nbt); dirty = true; }
+        MU void setTileTicks(NBTBase nbt) { tileTicks = std::move(nbt); dirty = true; }
+
         MU void convertNBT128ToAquatic();
         MU void convertNBT256ToAquatic();
         MU void convertOldToAquatic();
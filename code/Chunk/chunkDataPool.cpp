@@ -0,0 +1,99 @@
+#include "chunkDataPool.hpp"
+
+
+namespace editor::chunk {
+
+
+    ChunkDataPool::~ChunkDataPool() {
+        trim();
+    }
+
+
+    ChunkDataPool& ChunkDataPool::instance() {
+        static ChunkDataPool pool;
+        return pool;
+    }
+
+
+    ChunkData* ChunkDataPool::acquire() {
+        {
+            std::lock_guard lock(m_mutex);
+            if (!m_free.empty()) {
+                ChunkData* chunkData = m_free.back();
+                m_free.pop_back();
+                m_pooledBytes -= chunkData->getMemoryUsage();
+                return chunkData;
+            }
+        }
+        return new ChunkData();
+    }
+
+
+    void ChunkDataPool::release(ChunkData* chunkData) {
+        if (chunkData == nullptr) { return; }
+        // a chunk converted between versions would otherwise keep both sets of blocks
+        if (!chunkData->newBlocks.empty()) {
+            u8_vec().swap(chunkData->oldBlocks);
+            u8_vec().swap(chunkData->blockData);
+        } else if (!chunkData->oldBlocks.empty()) {
+            u16_vec().swap(chunkData->newBlocks);
+            u16_vec().swap(chunkData->submerged);
+        }
+        chunkData->reset();
+
+        c_u64 bytes = chunkData->getMemoryUsage();
+        {
+            std::lock_guard lock(m_mutex);
+            if (m_pooledBytes + bytes <= m_maxBytes) {
+                m_free.push_back(chunkData);
+                m_pooledBytes += bytes;
+                return;
+            }
+        }
+        delete chunkData;
+    }
+
+
+    void ChunkDataPool::trim() {
+        std::vector<ChunkData*> toDelete;
+        {
+            std::lock_guard lock(m_mutex);
+            toDelete.swap(m_free);
+            m_pooledBytes = 0;
+        }
+        for (ChunkData* chunkData : toDelete) {
+            delete chunkData;
+        }
+    }
+
+
+    void ChunkDataPool::setMaxBytes(const u64 maxBytes) {
+        std::vector<ChunkData*> toDelete;
+        {
+            std::lock_guard lock(m_mutex);
+            m_maxBytes = maxBytes;
+            while (m_pooledBytes > m_maxBytes) {
+                toDelete.push_back(m_free.back());
+                m_free.pop_back();
+                m_pooledBytes -= toDelete.back()->getMemoryUsage();
+            }
+        }
+        for (ChunkData* chunkData : toDelete) {
+            delete chunkData;
+        }
+    }
+
+
+    size_t ChunkDataPool::pooledCount() {
+        std::lock_guard lock(m_mutex);
+        return m_free.size();
+    }
+
+
+    u64 ChunkDataPool::pooledBytes() {
+        std::lock_guard lock(m_mutex);
+        return m_pooledBytes;
+    }
+
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "code/Chunk/chunkData.hpp"
+
+
+namespace editor::chunk {
+
+
+    /**
+     * Recycles ChunkData objects so their block, light and map vectors keep their
+     * capacity between chunks and regions, instead of being freed and re-zeroed
+     * from fresh pages every time. Safe to use from multiple threads.
+     * \n\n
+     * Pooled chunks are capped by the bytes their vectors hold, and conversions trim
+     * the pool when they finish, so the memory does not stay with the process.
+     */
+    class ChunkDataPool {
+        std::mutex m_mutex;
+        std::vector<ChunkData*> m_free;
+        u64 m_maxBytes;
+        u64 m_pooledBytes = 0;
+
+    public:
+        /// about 200 V12 chunks, enough to cover the chunks being decoded at once
+        static constexpr u64 DEFAULT_MAX_BYTES = 64ULL * 1024 * 1024;
+
+        explicit ChunkDataPool(u64 maxBytes = DEFAULT_MAX_BYTES) : m_maxBytes(maxBytes) {}
+        ~ChunkDataPool();
+
+        ChunkDataPool(const ChunkDataPool&) = delete;
+        ChunkDataPool& operator=(const ChunkDataPool&) = delete;
+
+        /// the pool shared by every ChunkManager
+        static ChunkDataPool& instance();
+
+        /// returns a reset ChunkData, reusing a pooled one when available
+        ND ChunkData* acquire();
+
+        /**
+         * Resets the ChunkData and keeps it for reuse, or deletes it if the pool is full.
+         * Only the block vectors of the chunk version it last held keep their capacity.
+         */
+        void release(ChunkData* chunkData);
+
+        /// frees every pooled ChunkData
+        MU void trim();
+
+        MU void setMaxBytes(u64 maxBytes);
+        MU ND size_t pooledCount();
+        MU ND u64 pooledBytes();
+    };
+
+
+}
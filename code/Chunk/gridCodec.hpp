@@ -0,0 +1,506 @@
+#pragma once
+
+#include <bit>
+#include <cstring>
+
+#include "include/lce/processor.hpp"
+#include "common/cpu.hpp"
+#if CPU_X86_SIMD
+#include <immintrin.h>
+#endif
+
+
+/**
+ * Block grid decoding shared by the V12 and V13 readers, and grid encoding for the V12 writer.
+ * \n\n
+ * A grid is 4x4x4 blocks. Grid position i = z * 16 + x * 4 + y, and in the
+ * yXZy destination layout that lands at x * 128 + y + z * 2048 relative to the
+ * grid's offset. Each run of 4 y-values is contiguous in the destination.
+ * \n\n
+ * Palette grids start with (1 << Bits) little-endian u16 palette entries,
+ * followed by Bits planes of 8 bytes. Bit (7 - i % 8) of byte (i / 8) in plane k
+ * is bit k of position i's palette index. Submerged grids store a second set of
+ * planes for the submerged layer right after the first, sharing the palette.
+ */
+namespace editor::chunk::grid {
+
+    static constexpr int GRID_POSITIONS = 64;
+
+    /// offset in the destination for the (z, x) column group of a grid, y is contiguous
+    static constexpr int columnOffset(c_int group) {
+        return (group >> 2) * 2048 + (group & 3) * 128;
+    }
+
+
+    /// writes the same block to all 64 positions
+    static inline void fillUniform(u16* dst, c_u16 value) noexcept {
+        for (int group = 0; group < 16; group++) {
+            u16* out = dst + columnOffset(group);
+            out[0] = value; out[1] = value; out[2] = value; out[3] = value;
+        }
+    }
+
+
+    /// copies 64 little-endian u16's stored in grid order
+    static inline void copyFull(c_u8* src, u16* dst) noexcept {
+        for (int group = 0; group < 16; group++) {
+            u16* out = dst + columnOffset(group);
+            for (int y = 0; y < 4; y++) {
+                c_u8* in = src + (group * 4 + y) * 2;
+                out[y] = static_cast<u16>(in[0] | in[1] << 8);
+            }
+        }
+    }
+
+
+    // #####################################################
+    // #               Scalar
+    // #####################################################
+
+
+    template<int Bits>
+    static inline void decodeScalar(c_u8* palette, c_u8* planes, u16* dst) noexcept {
+        u16 values[1 << Bits];
+        for (int i = 0; i < (1 << Bits); i++) {
+            values[i] = static_cast<u16>(palette[i * 2] | palette[i * 2 + 1] << 8);
+        }
+
+        u64 words[Bits];
+        for (int k = 0; k < Bits; k++) {
+            u64 word = 0;
+            for (int b = 0; b < 8; b++) {
+                word = word << 8 | planes[k * 8 + b];
+            }
+            words[k] = word;
+        }
+
+        for (int group = 0; group < 16; group++) {
+            u16* out = dst + columnOffset(group);
+            for (int y = 0; y < 4; y++) {
+                c_int shift = 63 - (group * 4 + y);
+                u32 idx = 0;
+                for (int k = 0; k < Bits; k++) {
+                    idx |= static_cast<u32>(words[k] >> shift & 1U) << k;
+                }
+                out[y] = values[idx];
+            }
+        }
+    }
+
+
+    // #####################################################
+    // #               SSSE3
+    // #####################################################
+
+
+#if CPU_X86_SIMD
+
+    /// splits the palette into a table of low bytes and a table of high bytes
+    template<int Bits>
+    CPU_TARGET_SSSE3
+    static inline void loadPaletteTables(c_u8* palette, __m128i& lo, __m128i& hi) noexcept {
+        alignas(16) u8 bytes[32] = {};
+        std::memcpy(bytes, palette, (1 << Bits) * 2);
+        const __m128i deinterleave = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,
+                                                   1, 3, 5, 7, 9, 11, 13, 15);
+        const __m128i a = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(bytes)), deinterleave);
+        const __m128i b = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(bytes + 16)), deinterleave);
+        lo = _mm_unpacklo_epi64(a, b);
+        hi = _mm_unpackhi_epi64(a, b);
+    }
+
+
+    /// stores 8 u16's (two column groups) starting at the given group
+    CPU_TARGET_SSSE3
+    static inline void storeTwoGroups(u16* dst, c_int group, const __m128i values) noexcept {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + columnOffset(group)), values);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + columnOffset(group + 1)),
+                         _mm_unpackhi_epi64(values, values));
+    }
+
+
+    template<int Bits>
+    CPU_TARGET_SSSE3
+    static void decodeSSSE3(c_u8* palette, c_u8* planes, u16* dst) noexcept {
+        __m128i tableLo, tableHi;
+        loadPaletteTables<Bits>(palette, tableLo, tableHi);
+
+        const __m128i bitMask = _mm_setr_epi8(
+                (char) 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                (char) 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+
+        __m128i planeVec[Bits];
+        for (int k = 0; k < Bits; k++) {
+            planeVec[k] = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(planes + k * 8));
+        }
+
+        // 16 positions (two plane bytes) at a time
+        for (int part = 0; part < 4; part++) {
+            const __m128i spread = _mm_setr_epi8(
+                    (char) (part * 2), (char) (part * 2), (char) (part * 2), (char) (part * 2),
+                    (char) (part * 2), (char) (part * 2), (char) (part * 2), (char) (part * 2),
+                    (char) (part * 2 + 1), (char) (part * 2 + 1), (char) (part * 2 + 1), (char) (part * 2 + 1),
+                    (char) (part * 2 + 1), (char) (part * 2 + 1), (char) (part * 2 + 1), (char) (part * 2 + 1));
+
+            __m128i idx = _mm_setzero_si128();
+            for (int k = 0; k < Bits; k++) {
+                const __m128i bytes = _mm_shuffle_epi8(planeVec[k], spread);
+                const __m128i set = _mm_cmpeq_epi8(_mm_and_si128(bytes, bitMask), bitMask);
+                idx = _mm_or_si128(idx, _mm_and_si128(set, _mm_set1_epi8(static_cast<char>(1 << k))));
+            }
+
+            const __m128i lo = _mm_shuffle_epi8(tableLo, idx);
+            const __m128i hi = _mm_shuffle_epi8(tableHi, idx);
+            storeTwoGroups(dst, part * 4 + 0, _mm_unpacklo_epi8(lo, hi));
+            storeTwoGroups(dst, part * 4 + 2, _mm_unpackhi_epi8(lo, hi));
+        }
+    }
+#endif
+
+
+    // #####################################################
+    // #               AVX2
+    // #####################################################
+
+
+#if CPU_X86_SIMD
+    template<int Bits>
+    CPU_TARGET_AVX2
+    static void decodeAVX2(c_u8* palette, c_u8* planes, u16* dst) noexcept {
+        __m128i tableLo128, tableHi128;
+        loadPaletteTables<Bits>(palette, tableLo128, tableHi128);
+        const __m256i tableLo = _mm256_broadcastsi128_si256(tableLo128);
+        const __m256i tableHi = _mm256_broadcastsi128_si256(tableHi128);
+
+        const __m256i bitMask = _mm256_set1_epi64x(0x0102040810204080LL);
+
+        __m256i planeVec[Bits];
+        for (int k = 0; k < Bits; k++) {
+            u64 word;
+            std::memcpy(&word, planes + k * 8, 8);
+            planeVec[k] = _mm256_set1_epi64x(static_cast<long long>(word));
+        }
+
+        // 32 positions (four plane bytes) at a time, each lane handles two bytes
+        for (int part = 0; part < 2; part++) {
+            c_int b = part * 4;
+            const __m256i spread = _mm256_setr_epi8(
+                    (char) b, (char) b, (char) b, (char) b, (char) b, (char) b, (char) b, (char) b,
+                    (char) (b + 1), (char) (b + 1), (char) (b + 1), (char) (b + 1),
+                    (char) (b + 1), (char) (b + 1), (char) (b + 1), (char) (b + 1),
+                    (char) (b + 2), (char) (b + 2), (char) (b + 2), (char) (b + 2),
+                    (char) (b + 2), (char) (b + 2), (char) (b + 2), (char) (b + 2),
+                    (char) (b + 3), (char) (b + 3), (char) (b + 3), (char) (b + 3),
+                    (char) (b + 3), (char) (b + 3), (char) (b + 3), (char) (b + 3));
+
+            __m256i idx = _mm256_setzero_si256();
+            for (int k = 0; k < Bits; k++) {
+                const __m256i bytes = _mm256_shuffle_epi8(planeVec[k], spread);
+                const __m256i set = _mm256_cmpeq_epi8(_mm256_and_si256(bytes, bitMask), bitMask);
+                idx = _mm256_or_si256(idx, _mm256_and_si256(set, _mm256_set1_epi8(static_cast<char>(1 << k))));
+            }
+
+            const __m256i lo = _mm256_shuffle_epi8(tableLo, idx);
+            const __m256i hi = _mm256_shuffle_epi8(tableHi, idx);
+            const __m256i first = _mm256_unpacklo_epi8(lo, hi);  // lane 0: 0-7,   lane 1: 16-23
+            const __m256i second = _mm256_unpackhi_epi8(lo, hi); // lane 0: 8-15,  lane 1: 24-31
+
+            c_int group = part * 8;
+            storeTwoGroups(dst, group + 0, _mm256_castsi256_si128(first));
+            storeTwoGroups(dst, group + 2, _mm256_castsi256_si128(second));
+            storeTwoGroups(dst, group + 4, _mm256_extracti128_si256(first, 1));
+            storeTwoGroups(dst, group + 6, _mm256_extracti128_si256(second, 1));
+        }
+    }
+#endif
+
+
+    // #####################################################
+    // #               Public
+    // #####################################################
+
+
+    /// decodes a palette grid straight into the yXZy destination
+    template<int Bits>
+    static inline void decodePalette(c_u8* palette, c_u8* planes, u16* dst) noexcept {
+#if CPU_X86_SIMD
+        c_auto level = cmn::simdLevel();
+        if (level >= cmn::eSimdLevel::AVX2) {
+            decodeAVX2<Bits>(palette, planes, dst);
+            return;
+        }
+        if (level >= cmn::eSimdLevel::SSSE3) {
+            decodeSSSE3<Bits>(palette, planes, dst);
+            return;
+        }
+#endif
+        decodeScalar<Bits>(palette, planes, dst);
+    }
+
+
+    /// decodes a grid without a submerged layer
+    template<int Bits>
+    static inline void decodeGrid(c_u8* buffer, u16* blocks) noexcept {
+        decodePalette<Bits>(buffer, buffer + (1 << Bits) * 2, blocks);
+    }
+
+
+    /// decodes a grid and its submerged layer
+    template<int Bits>
+    static inline void decodeGridSubmerged(c_u8* buffer, u16* blocks, u16* submerged) noexcept {
+        c_u8* planes = buffer + (1 << Bits) * 2;
+        decodePalette<Bits>(buffer, planes, blocks);
+        decodePalette<Bits>(buffer, planes + Bits * 8, submerged);
+    }
+
+
+    // #####################################################
+    // #               Encoding
+    // #####################################################
+
+
+    /// one encoded grid, ready to be appended to the section
+    struct EncodedGrid {
+        u8 bits = 0;   ///< 0 for a single value, 1-4 for palettes, 8 for full grids
+        u16 value = 0; ///< the block, when bits == 0
+        u32 size = 0;  ///< bytes used in data
+        alignas(16) u8 data[128];
+    };
+
+
+    /// copies the 64 blocks of a grid into grid order
+    static inline void gatherGrid(const u16* src, u16* grid) noexcept {
+        for (int group = 0; group < 16; group++) {
+            std::memcpy(grid + group * 4, src + columnOffset(group), 8);
+        }
+    }
+
+
+    /// true if all 64 values equal the first one
+    static inline bool isUniformGrid(const u16* grid) noexcept {
+#if CPU_X86_SIMD
+        const __m128i first = _mm_set1_epi16(static_cast<short>(grid[0]));
+        __m128i diff = _mm_setzero_si128();
+        for (int i = 0; i < GRID_POSITIONS; i += 8) {
+            diff = _mm_or_si128(diff, _mm_xor_si128(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(grid + i)), first));
+        }
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) == 0xFFFF;
+#else
+        for (int i = 1; i < GRID_POSITIONS; i++) {
+            if (grid[i] != grid[0]) { return false; }
+        }
+        return true;
+#endif
+    }
+
+
+    /// true if all 64 values are zero
+    static inline bool isZeroGrid(const u16* grid) noexcept {
+        u64 acc = 0;
+        for (int i = 0; i < GRID_POSITIONS; i += 4) {
+            u64 word;
+            std::memcpy(&word, grid + i, 8);
+            acc |= word;
+        }
+        return acc == 0;
+    }
+
+
+    /**
+     * Looks up a value in a palette of up to 16 entries.
+     * @param palette 16 entries, only the first count are valid
+     * @return the index of the value, or -1
+     */
+    static inline int findInPalette(const u16* palette, c_int count, c_u16 value) noexcept {
+        // one call per block, too short to be worth picking an instruction set for
+#if CPU_X86_SIMD
+        const __m128i needle = _mm_set1_epi16(static_cast<short>(value));
+        const u32 low = static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi16(
+                _mm_load_si128(reinterpret_cast<const __m128i*>(palette)), needle)));
+        const u32 high = static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi16(
+                _mm_load_si128(reinterpret_cast<const __m128i*>(palette + 8)), needle)));
+        u32 mask = low | high << 16;
+#else
+        u32 mask = 0;
+        for (int i = 0; i < count; i++) {
+            if (palette[i] == value) { mask |= 3U << (i * 2); }
+        }
+#endif
+        mask &= count >= 16 ? 0xFFFFFFFFU : (1U << count * 2) - 1;
+        return mask != 0 ? std::countr_zero(mask) >> 1 : -1;
+    }
+
+
+    template<int Bits>
+    static inline void packPlanesScalar(c_u8* indices, u8* out) noexcept {
+        for (int k = 0; k < Bits; k++) {
+            for (int b = 0; b < 8; b++) {
+                u8 byte = 0;
+                for (int j = 0; j < 8; j++) {
+                    byte |= static_cast<u8>((indices[b * 8 + j] >> k & 1) << (7 - j));
+                }
+                out[k * 8 + b] = byte;
+            }
+        }
+    }
+
+
+#if CPU_X86_SIMD
+    template<int Bits>
+    CPU_TARGET_SSSE3
+    static void packPlanesSSSE3(c_u8* indices, u8* out) noexcept {
+        const __m128i reverse = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+        __m128i parts[4];
+        for (int part = 0; part < 4; part++) {
+            parts[part] = _mm_shuffle_epi8(
+                    _mm_load_si128(reinterpret_cast<const __m128i*>(indices + part * 16)), reverse);
+        }
+        for (int k = 0; k < Bits; k++) {
+            const __m128i shift = _mm_cvtsi32_si128(7 - k);
+            u8* plane = out + k * 8;
+            for (int part = 0; part < 4; part++) {
+                const u32 mask = static_cast<u32>(_mm_movemask_epi8(_mm_sll_epi16(parts[part], shift)));
+                plane[part * 2] = static_cast<u8>(mask);
+                plane[part * 2 + 1] = static_cast<u8>(mask >> 8);
+            }
+        }
+    }
+
+
+    template<int Bits>
+    CPU_TARGET_AVX2
+    static void packPlanesAVX2(c_u8* indices, u8* out) noexcept {
+        // reverse each run of 8 so that movemask puts the first position in the high bit
+        const __m256i reverse = _mm256_setr_epi8(
+                7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+        const __m256i a = _mm256_shuffle_epi8(
+                _mm256_load_si256(reinterpret_cast<const __m256i*>(indices)), reverse);
+        const __m256i b = _mm256_shuffle_epi8(
+                _mm256_load_si256(reinterpret_cast<const __m256i*>(indices + 32)), reverse);
+        for (int k = 0; k < Bits; k++) {
+            const __m128i shift = _mm_cvtsi32_si128(7 - k);
+            const u32 lo = static_cast<u32>(_mm256_movemask_epi8(_mm256_sll_epi16(a, shift)));
+            const u32 hi = static_cast<u32>(_mm256_movemask_epi8(_mm256_sll_epi16(b, shift)));
+            u8* plane = out + k * 8;
+            for (int i = 0; i < 4; i++) {
+                plane[i] = static_cast<u8>(lo >> i * 8);
+                plane[i + 4] = static_cast<u8>(hi >> i * 8);
+            }
+        }
+    }
+#endif
+
+
+    /**
+     * Writes Bits planes of 8 bytes from 64 palette indices.
+     * Position i goes to bit (7 - i % 8) of byte (i / 8).
+     */
+    template<int Bits>
+    static inline void packPlanes(c_u8* indices, u8* out) noexcept {
+#if CPU_X86_SIMD
+        c_auto level = cmn::simdLevel();
+        if (level >= cmn::eSimdLevel::AVX2) {
+            packPlanesAVX2<Bits>(indices, out);
+            return;
+        }
+        if (level >= cmn::eSimdLevel::SSSE3) {
+            packPlanesSSSE3<Bits>(indices, out);
+            return;
+        }
+#endif
+        packPlanesScalar<Bits>(indices, out);
+    }
+
+
+    template<int Bits>
+    static inline void encodePalette(const u16* palette, c_int count, c_u8* indices, EncodedGrid& out) noexcept {
+        u8* data = out.data;
+        for (int i = 0; i < (1 << Bits); i++) {
+            c_u16 value = i < count ? palette[i] : 0xFFFF;
+            data[i * 2] = static_cast<u8>(value);
+            data[i * 2 + 1] = static_cast<u8>(value >> 8);
+        }
+        packPlanes<Bits>(indices, data + (1 << Bits) * 2);
+        out.bits = Bits;
+        out.size = (1 << Bits) * 2 + Bits * 8;
+    }
+
+
+    /**
+     * Encodes one grid of the yXZy source for the V12 writer.
+     * \n\n
+     * The palette holds values in order of first appearance. Non-zero submerged
+     * values are added to it right after the block at the same position, even though
+     * only the block planes are written; this keeps the palette (and the chosen
+     * format) identical to what the map based writer produced.
+     * Grids with more than 16 palette entries are written in full.
+     */
+    static inline void encodeGrid(const u16* blocks, const u16* submerged, EncodedGrid& out) noexcept {
+        alignas(16) u16 grid[GRID_POSITIONS];
+        alignas(16) u16 sub[GRID_POSITIONS];
+        gatherGrid(blocks, grid);
+        gatherGrid(submerged, sub);
+
+        c_bool hasSubmerged = !isZeroGrid(sub);
+
+        if (!hasSubmerged && isUniformGrid(grid)) {
+            out.bits = 0;
+            out.value = grid[0];
+            out.size = 0;
+            return;
+        }
+
+        alignas(32) u16 palette[16] = {};
+        alignas(32) u8 indices[GRID_POSITIONS];
+        int count = 0;
+
+        for (int i = 0; i < GRID_POSITIONS; i++) {
+            c_u16 block = grid[i];
+            if (i != 0 && block == grid[i - 1]) {
+                indices[i] = indices[i - 1];
+            } else {
+                int index = findInPalette(palette, count, block);
+                if (index < 0) {
+                    if (count == 16) { goto FULL; }
+                    index = count;
+                    palette[count++] = block;
+                }
+                indices[i] = static_cast<u8>(index);
+            }
+
+            if (hasSubmerged) {
+                c_u16 subBlock = sub[i];
+                if (subBlock != 0 && findInPalette(palette, count, subBlock) < 0) {
+                    if (count == 16) { goto FULL; }
+                    palette[count++] = subBlock;
+                }
+            }
+        }
+
+        switch (count) {
+            case 1:
+                out.bits = 0;
+                out.value = palette[0];
+                out.size = 0;
+                return;
+            case 2: encodePalette<1>(palette, count, indices, out); return;
+            case 3:
+            case 4: encodePalette<2>(palette, count, indices, out); return;
+            case 5: case 6: case 7:
+            case 8: encodePalette<3>(palette, count, indices, out); return;
+            default: encodePalette<4>(palette, count, indices, out); return;
+        }
+
+    FULL:
+        for (int i = 0; i < GRID_POSITIONS; i++) {
+            out.data[i * 2] = static_cast<u8>(grid[i]);
+            out.data[i * 2 + 1] = static_cast<u8>(grid[i] >> 8);
+        }
+        out.bits = 8;
+        out.size = GRID_POSITIONS * 2;
+    }
+
+
+}
@@ -74,7 +74,8 @@ namespace editor::chunk {
         static constexpr int GRID_COUNT = 64;
         static constexpr int DATA_SECTION_SIZE = 128;
 
-        static u32_vec sectionOffsets;
+        // one per thread, chunks are encoded in parallel by Region::write
+        thread_local u32_vec sectionOffsets;
         sectionOffsets.reserve(GRID_COUNT);
 
         u32 readOffset = 0;
@@ -87,18 +88,17 @@ namespace editor::chunk {
         sectionOffsets.clear();
 
         // Write headers
+        u8 fills[DATA_SECTION_SIZE];
+        scanPages(dataIn + readOffset, DATA_SECTION_SIZE, fills);
+
         u32 sectionOffsetSize = 0;
-        c_u8* ptr = dataIn + readOffset;
         for (int i = 0; i < DATA_SECTION_SIZE; i++) {
-            if (is_zero_128(ptr)) {
-                writer.write<u8>(DATA_SECTION_SIZE);
-            } else if (is_ff_128(ptr)) {
-                writer.write<u8>(DATA_SECTION_SIZE + 1);
+            if (fills[i] != PAGE_MIXED) {
+                writer.write<u8>(fills[i]);
             } else {
                 sectionOffsets.push_back(readOffset);
                 writer.write<u8>(sectionOffsetSize++);
             }
-            ptr += DATA_SECTION_SIZE;
             readOffset += DATA_SECTION_SIZE;
         }
 
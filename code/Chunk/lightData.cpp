@@ -0,0 +1,122 @@
+#include "lightData.hpp"
+
+#include <cstring>
+
+#include "code/Chunk/chunkData.hpp"
+#include "helpers.hpp"
+
+
+namespace editor::chunk {
+
+
+    LightData::LightData() {
+        clear();
+    }
+
+
+    void LightData::clear() {
+        for (u8_vec& section : m_sections) {
+            section.assign(PAGE_COUNT, PAGE_ZERO);
+        }
+        m_expanded = false;
+    }
+
+
+    void LightData::fill(c_u8 value) {
+        if (value == 0x00 || value == 0xFF) {
+            for (u8_vec& section : m_sections) {
+                section.assign(PAGE_COUNT, value == 0x00 ? PAGE_ZERO : PAGE_FF);
+            }
+            m_expanded = false;
+            return;
+        }
+        std::memset(data(), value, SIZE);
+    }
+
+
+    void LightData::readSection(c_int half, const std::span<const u8> section) {
+        u8_vec& stored = m_sections[half];
+        if (section.size() < PAGE_COUNT) {
+            stored.assign(PAGE_COUNT, PAGE_ZERO);
+        } else {
+            stored.assign(section.begin(), section.end() - static_cast<std::ptrdiff_t>(section.size() % PAGE_SIZE));
+        }
+
+        // a header entry past the stored pages would be read out of bounds later, treat it as zeros
+        c_u32 pageCount = static_cast<u32>(stored.size() / PAGE_SIZE - 1);
+        for (u32 page = 0; page < PAGE_COUNT; page++) {
+            c_u8 entry = stored[page];
+            if (entry != PAGE_ZERO && entry != PAGE_FF && entry >= pageCount) {
+                stored[page] = PAGE_ZERO;
+            }
+        }
+
+        if (m_expanded) {
+            // the other half only exists in m_full
+            chunk::readSection(stored, m_full.data() + half * HALF_SIZE);
+        }
+    }
+
+
+    void LightData::writeSection(DataWriter& writer, c_int half) const {
+        if (m_expanded) {
+            chunk::writeSection(writer, m_full.data() + half * HALF_SIZE);
+            return;
+        }
+        const u8_vec& stored = m_sections[half];
+        writer.write<u32>(static_cast<u32>(stored.size() / PAGE_SIZE - 1));
+        writer.writeBytes(stored.data(), stored.size());
+    }
+
+
+    u8 LightData::getNibble(c_u32 index) const {
+        c_u32 byteIndex = index >> 1;
+        c_u32 shift = (index & 1) * 4;
+        if (m_expanded) {
+            return m_full[byteIndex] >> shift & 0xF;
+        }
+
+        const u8_vec& stored = m_sections[byteIndex / HALF_SIZE];
+        c_u32 offset = byteIndex % HALF_SIZE;
+        c_u8 entry = stored[offset / PAGE_SIZE];
+        if (entry == PAGE_ZERO) { return 0x0; }
+        if (entry == PAGE_FF) { return 0xF; }
+        return stored[(entry + 1) * PAGE_SIZE + offset % PAGE_SIZE] >> shift & 0xF;
+    }
+
+
+    void LightData::setNibble(c_u32 index, c_u8 value) {
+        if (!m_expanded) { expand(); }
+        u8& byte = m_full[index >> 1];
+        c_u32 shift = (index & 1) * 4;
+        byte = static_cast<u8>((byte & ~(0xF << shift)) | (value & 0xF) << shift);
+    }
+
+
+    u8* LightData::data() {
+        if (!m_expanded) { expand(); }
+        return m_full.data();
+    }
+
+
+    void LightData::swap(u8_vec& full) {
+        m_full.swap(full);
+        m_expanded = true;
+    }
+
+
+    u64 LightData::getMemoryUsage() const {
+        return m_sections[0].capacity() + m_sections[1].capacity() + m_full.capacity();
+    }
+
+
+    void LightData::expand() {
+        m_full.resize(SIZE);
+        for (int half = 0; half < 2; half++) {
+            chunk::readSection(m_sections[half], m_full.data() + half * HALF_SIZE);
+        }
+        m_expanded = true;
+    }
+
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <span>
+
+#include "include/lce/processor.hpp"
+
+#include "common/data/DataWriter.hpp"
+
+
+namespace editor::chunk {
+
+
+    /**
+     * Sky or block light of a chunk, 32768 bytes of nibbles in two halves of 128 pages.
+     * \n\n
+     * Chunks store each half as a light section: a 128-byte header with one byte per
+     * 128-byte page, 128 for a page of zeros, 129 for a page of 0xFF, otherwise the
+     * index of one of the pages that follow. LightData keeps read sections in that form,
+     * so light that is not edited is written back as it was read, without expanding
+     * and re-scanning it. The first write expands both halves to the full array.
+     */
+    class LightData {
+        /// a light section as stored in a chunk, the header followed by its pages
+        u8_vec m_sections[2];
+        /// the full array, only valid while m_expanded
+        u8_vec m_full;
+        bool m_expanded = false;
+
+        void expand();
+
+    public:
+        static constexpr u32 SIZE = 32768;
+        static constexpr u32 HALF_SIZE = 16384;
+        static constexpr u32 PAGE_SIZE = 128;
+        static constexpr u32 PAGE_COUNT = 128;
+
+        /// all zeros
+        LightData();
+
+        /// sets every nibble to zero without expanding, buffers keep their capacity
+        void clear();
+
+        /// sets every byte, only 0x00 and 0xFF stay in the sectioned form
+        void fill(u8 value);
+
+        /**
+         * Keeps a light section of a chunk as it is.
+         * @param half 0 for the lower 16384 bytes, 1 for the upper
+         * @param section the header and the pages it refers to
+         */
+        void readSection(int half, std::span<const u8> section);
+
+        /// writes a half as a light section, it is only re-encoded if the light was expanded
+        void writeSection(DataWriter& writer, int half) const;
+
+        /// the light at a nibble index, without expanding
+        ND u8 getNibble(u32 index) const;
+
+        /// expands the light first
+        void setNibble(u32 index, u8 value);
+
+        /// the full 32768 bytes, expanding the light first; writes to it are kept
+        ND u8* data();
+
+        /**
+         * Replaces the light with a full array, the way std::vector::swap does.
+         * @param full exactly SIZE bytes, receives the previous full array
+         */
+        void swap(u8_vec& full);
+
+        MU ND bool isExpanded() const { return m_expanded; }
+
+        /// heap bytes held by the sections and the full array
+        ND u64 getMemoryUsage() const;
+    };
+
+
+}
@@ -6,12 +6,12 @@
 namespace editor::chunk {
 
     void ChunkVNBT::allocChunk() const {
-        chunkData->oldBlocks = u8_vec(65536);
-        chunkData->blockData = u8_vec(32768);
-        chunkData->heightMap = u8_vec(256);
-        chunkData->biomes = u8_vec(256);
-        chunkData->skyLight = u8_vec(32768);
-        chunkData->blockLight = u8_vec(32768);
+        chunkData->oldBlocks.assign(65536, 0);
+        chunkData->blockData.assign(32768, 0);
+        chunkData->heightMap.assign(256, 0);
+        chunkData->biomes.assign(256, 0);
+        chunkData->skyLight.clear();
+        chunkData->blockLight.clear();
 
     }
 
@@ -12,12 +12,12 @@ namespace editor::chunk {
 
 
     void ChunkV11::allocChunk() const {
-        chunkData->oldBlocks = u8_vec(65536);
-        chunkData->blockData = u8_vec(32768);
-        chunkData->skyLight = u8_vec(32768);
-        chunkData->blockLight = u8_vec(32768);
-        chunkData->heightMap = u8_vec(256);
-        chunkData->biomes = u8_vec(256);
+        chunkData->oldBlocks.assign(65536, 0);
+        chunkData->blockData.assign(32768, 0);
+        chunkData->skyLight.clear();
+        chunkData->blockLight.clear();
+        chunkData->heightMap.assign(256, 0);
+        chunkData->biomes.assign(256, 0);
     }
 
 
@@ -43,10 +43,10 @@ namespace editor::chunk {
         readBlocks(dataArray[1], &chunkData->oldBlocks[32768]);
         readSection(dataArray[2], &chunkData->blockData[0]);
         readSection(dataArray[3], &chunkData->blockData[16384]);
-        readSection(dataArray[4], &chunkData->skyLight[0]);
-        readSection(dataArray[5], &chunkData->skyLight[16384]);
-        readSection(dataArray[6], &chunkData->blockLight[0]);
-        readSection(dataArray[7], &chunkData->blockLight[16384]);
+        chunkData->skyLight.readSection(0, dataArray[4]);
+        chunkData->skyLight.readSection(1, dataArray[5]);
+        chunkData->blockLight.readSection(0, dataArray[6]);
+        chunkData->blockLight.readSection(1, dataArray[7]);
 
         reader.readBytes(256, chunkData->heightMap.data());
         chunkData->terrainPopulated = reader.read<i16>();
@@ -170,10 +170,10 @@ namespace editor::chunk {
 
         writeSection(writer, &chunkData->blockData[0]);
         writeSection(writer, &chunkData->blockData[16384]);
-        writeSection(writer, &chunkData->skyLight[0]);
-        writeSection(writer, &chunkData->skyLight[16384]);
-        writeSection(writer, &chunkData->blockLight[0]);
-        writeSection(writer, &chunkData->blockLight[16384]);
+        chunkData->skyLight.writeSection(writer, 0);
+        chunkData->skyLight.writeSection(writer, 1);
+        chunkData->blockLight.writeSection(writer, 0);
+        chunkData->blockLight.writeSection(writer, 1);
 
         writer.writeBytes(chunkData->heightMap.data(), 256);
         writer.write<i16>(chunkData->terrainPopulated);
@@ -192,120 +192,109 @@ namespace editor::chunk {
     }
 
 
+    /**
+     * The inverse of readBlocks: a u32 size, a 2 byte header per grid, then the grid data.
+     * Offsets are relative to the start of the section, so it works wherever the section lands.
+     */
     MU void ChunkV11::writeBlocks(DataWriter& writer, u8 const* oldBlockPtr) const {
         static constexpr u32 GRID_HEADER_SIZE = 2 * GRID_COUNT;
 
-        u32 H_BEGIN = (chunkData->lastVersion <= 8) ? 16 : 24;
-        u32 H_GRID_DATA   = H_BEGIN + 4 + GRID_HEADER_SIZE;
+        c_u32 H_BEGIN     = writer.tell();
+        c_u32 H_GRID_DATA = H_BEGIN + 4 + GRID_HEADER_SIZE;
         u32 h_grid_offset = 0;
 
         writer.seek(H_GRID_DATA);
 
         u8 blockMap[MAP_SIZE] = {};
         u8 gridHeader[GRID_HEADER_SIZE];
-        i32 gridIndex = 0;
-
+        u8 blockBuffer[MAX_BLOCKS_SIZE];
+        u8 blockLoc[MAX_BLOCKS_SIZE];
         u8FixVec_t blockVec;
-        u8FixVec_t blockLoc;
-        for (i32 gridY = 0; gridY < 32; gridY++) {
-        for (i32 gridZ = 0; gridZ < 4; gridZ++) {
-        for (i32 gridX = 0; gridX < 4; gridX++) {
-            c_u32 blockOffset = toIndex<XZY>(gridX + 4, gridY * 4, gridZ * 4);
+
+        for (i32 gridIndex = 0; gridIndex < GRID_COUNT; gridIndex++) {
+            // same placement as putBlocks
+            c_i32 column = gridIndex / 32;
+            c_i32 readOffset = column / 4 * 64 + column % 4 * 4 + gridIndex % 32 * 1024;
 
             blockVec.set_size(0);
-            blockLoc.set_size(0);
-
-            for (i32 blockY = 0; blockY < 4; blockY++) {
-            for (i32 blockZ = 0; blockZ < 4; blockZ++) {
-            for (i32 blockX = 0; blockX < 4; blockX++) {
-                c_u32 blockIndex = blockOffset + toIndex<XZY>(blockX, blockY, blockZ);
-                c_u8 block = oldBlockPtr[blockIndex];
-                if (blockMap[block]) {
-                    blockLoc.push_back(blockMap[block] - 1);
-                } else {
-                    blockMap[block] = blockVec.current_size() + 1;
-                    u8 location = blockVec.current_size();
-                    blockVec.push_back(block);
-                    blockLoc.push_back(location);
+            int num = 0;
+            for (int z = 0; z < 4; z++) {
+                for (int x = 0; x < 4; x++) {
+                    for (int y = 0; y < 4; y++) {
+                        c_u8 block = oldBlockPtr[readOffset + x + z * 16 + y * 256];
+                        if (blockMap[block] == 0) {
+                            blockVec.push_back(block);
+                            blockMap[block] = static_cast<u8>(blockVec.current_size());
+                        }
+                        blockBuffer[num] = block;
+                        blockLoc[num++] = blockMap[block] - 1;
+                    }
                 }
-            }}}
-
-            /*
-             * case  1:   // 65535 (-1 unsigned)
-             * case  2:   // 0
-             * case  3-4: // 1
-             * case  5-8: // 2
-             * case 9-16: // 3
-             * this code assumes blockVec is never 0
-             */
+            }
+            for (size_t i = 0; i < blockVec.current_size(); i++) {
+                blockMap[blockVec[i]] = 0;
+            }
+
             const size_t n = blockVec.current_size();
-            MU const auto gridFormat = static_cast<V11GridFormat>(n == 1 ? 0
-                          : 32 - __builtin_clz(static_cast<unsigned>(n - 1)) - 1);
+            if (n == 1) {
+                gridHeader[gridIndex * 2] = Grid::IS_SINGLE_BLOCK_FLAG;
+                gridHeader[gridIndex * 2 + 1] = blockVec[0];
+                continue;
+            }
+
+            const V11GridFormat gridFormat = n == 2  ? V11_1_BIT
+                                           : n <= 4  ? V11_2_BIT
+                                           : n <= 16 ? V11_3_BIT
+                                                     : V11_4_BIT;
+
+            // a raw grid at an odd half-offset would have its header read as a single block
+            if (gridFormat == V11_4_BIT && (h_grid_offset / 2 & 1U) != 0) {
+                writer.write<u16>(0);
+                h_grid_offset += 2;
+            }
+
             switch (gridFormat) {
-                case V11_0_BIT:
-                    gridHeader[gridIndex++] = Grid::IS_SINGLE_BLOCK_FLAG;
-                    gridHeader[gridIndex++] = blockVec[0];
-                    continue;
-                case V11_1_BIT: writeGrid<1>(writer, blockVec, blockLoc, blockMap); break;
-                case V11_2_BIT: writeGrid<2>(writer, blockVec, blockLoc, blockMap); break;
-                case V11_3_BIT: writeGrid<3>(writer, blockVec, blockLoc, blockMap); break;
-                case V11_4_BIT: {
-                    for (size_t i = 0; i < GRID_COUNT; i++)
-                        writer.write<u8>(blockVec[blockLoc[i]]);
-                    for (c_u16 block : blockVec)
-                        blockMap[block] = 0;
-                    break;
-                }
+                case V11_1_BIT: writeGrid<1>(writer, blockVec, blockLoc); break;
+                case V11_2_BIT: writeGrid<2>(writer, blockVec, blockLoc); break;
+                case V11_3_BIT: writeGrid<4>(writer, blockVec, blockLoc); break;
+                default: writer.writeBytes(blockBuffer, MAX_BLOCKS_SIZE); break;
             }
+
             Grid grid;
             grid.setFormatOffset(h_grid_offset, gridFormat);
-            gridHeader[gridIndex++] = grid.m_byte0;
-            gridHeader[gridIndex++] = grid.m_byte1;
+            gridHeader[gridIndex * 2] = grid.m_byte0;
+            gridHeader[gridIndex * 2 + 1] = grid.m_byte1;
             h_grid_offset += V11_GRID_SIZES[gridFormat];
-        }}}
-
+        }
 
-        u32 finalSize = GRID_HEADER_SIZE + h_grid_offset;
         writer.seek(H_BEGIN);
-        writer.write<u16>(finalSize);                    //< write section size
-        writer.writeBytes(gridHeader, GRID_HEADER_SIZE); //< write grid header
-        writer.seek(H_GRID_DATA + h_grid_offset);        //< seek to end of data
+        writer.write<u32>(GRID_HEADER_SIZE + h_grid_offset); //< write section size
+        writer.writeBytes(gridHeader, GRID_HEADER_SIZE);      //< write grid header
+        writer.seek(H_GRID_DATA + h_grid_offset);             //< seek to end of data
     }
 
 
+    /// palette padded with 0xFF, then the indices packed LSB first, the inverse of readGrid
     template<size_t BitsPerBlock>
-    void ChunkV11::writeGrid(DataWriter& writer,
-                             u8FixVec_t& blockVector,
-                             u8FixVec_t& blockLocations,
-                             u8 blockMap[MAP_SIZE]) const {
-        size_t total = 1 << BitsPerBlock;
-        size_t count = blockVector.current_size();
+    void ChunkV11::writeGrid(DataWriter& writer, const u8FixVec_t& blockVector,
+                             c_u8 blockLocations[MAX_BLOCKS_SIZE]) {
+        constexpr size_t total = 1 << BitsPerBlock;
+        constexpr size_t blocks_per_byte = 8 / BitsPerBlock;
 
-        // write the palette data
+        size_t count = blockVector.current_size();
         for (size_t blockIndex = 0; blockIndex < count; blockIndex++) {
             writer.write<u8>(blockVector[blockIndex]);
         }
-        // fill remaining palette spots with 0xFF
-        size_t remaining = total - count;
-        for (size_t rest = 0; rest < remaining; rest++) {
+        for (size_t rest = count; rest < total; rest++) {
             writer.write<u8>(0xFF);
         }
 
-        //  write the position data
-        //  so, write the first bit of each position, as a single u64,
-        //  then the second, third etc. N times, where N is BitsPerBlock
-        for (size_t bitIndex = 0; bitIndex < BitsPerBlock; bitIndex++) {
-            u64 position = 0;
-            for (size_t locIndex = 0; locIndex < GRID_COUNT; locIndex++) {
-                c_u64 pos = blockLocations[locIndex];
-                position |= (pos >> bitIndex & 1U) << (GRID_COUNT - locIndex - 1);
+        for (size_t byteOffset = 0; byteOffset < 8 * BitsPerBlock; byteOffset++) {
+            u8 currentByte = 0;
+            for (size_t j = 0; j < blocks_per_byte; j++) {
+                currentByte |= blockLocations[byteOffset * blocks_per_byte + j] << (j * BitsPerBlock);
             }
-            writer.write<u64>(position);
-        }
-
-        // clear the table
-        for (size_t i = 0; i < count; ++i) {
-            blockMap[blockVector[i]] = 0;
+            writer.write<u8>(currentByte);
         }
     }
 
@@ -72,11 +72,10 @@ namespace editor::chunk {
 
         void setFormatOffset(u16 offset, V11GridFormat format) {
             offset = offset / 2;
-            m_byte0 = (m_byte0 & 0b11111100) | (format & 0b11);
-            // Set the 6 most significant bits of the offset in m_byte0
-            m_byte0 = (m_byte0 & 0b00000011) | ((offset & 0b1111110000) >> 6);
-            // Set the 2 least significant bits of the offset in m_byte1
-            m_byte1 = (m_byte1 & 0b00111111) | ((offset & 0b00000011) << 6);
+            // the 6 least significant bits of the offset go above the format in m_byte0
+            m_byte0 = static_cast<u8>((offset & 0b111111) << 2 | (format & 0b11));
+            // the rest go in m_byte1
+            m_byte1 = static_cast<u8>(offset >> 6);
         }
 
         MU ND bool isSingleBlock() const {
@@ -108,7 +107,7 @@ namespace editor::chunk {
 
         MU void writeBlocks(DataWriter& writer, u8 const* oldBlockPtr) const;
         template<size_t BitsPerBlock>
-        void writeGrid(DataWriter& writer, u8FixVec_t& blockVector, u8FixVec_t& blockLocations, u8 blockMap[MAP_SIZE]) const;
+        static void writeGrid(DataWriter& writer, const u8FixVec_t& blockVector, c_u8 blockLocations[MAX_BLOCKS_SIZE]);
 
 
     public:
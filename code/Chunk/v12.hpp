@@ -2,7 +2,6 @@
 
 #include "code/Chunk/chunkData.hpp"
 #include "common/error_status.hpp"
-#include "common/fixedVector.hpp"
 #include "vBase.hpp"
 
 
@@ -53,30 +52,15 @@ namespace editor::chunk {
         static constexpr int SECTION_COUNT = 16;
         static constexpr int GRID_COUNT = 64;
         static constexpr int GRID_SIZE = 128;
-        static constexpr int MAP_SIZE = 65536;
 
         // Read Section
 
         void readBlockData(DataReader& reader) const;
-        template<size_t BitsPerBlock>
-        bool readGrid(c_u8* buffer, u8 grid[GRID_SIZE]) const;
-        template<size_t BitsPerBlock>
-        bool readGridSubmerged(u8 const* buffer, u8 blockGrid[GRID_SIZE], u8 SbmrgGrid[GRID_SIZE]) const;
 
         // Write Section
 
-        using u16FixVec_t = FixedVector<u16, GRID_COUNT>;
-
         void writeBlockData(DataWriter& writer) const;
 
-        template<size_t BitsPerBlock, size_t BlockCount, size_t EmptyCount>
-        void writeGrid(DataWriter& writer, u16FixVec_t& blockVector, u16FixVec_t& blockLocations, u8 blockMap[MAP_SIZE]) const;
-        static void writeWithMaxBlocks(DataWriter& writer, const u16FixVec_t& blockVector, const u16FixVec_t& blockLocations, u8 blockMap[MAP_SIZE]) ;
-
-        template<size_t BitsPerBlock, size_t BlockCount, size_t EmptyCount>
-        void writeGridSubmerged(DataWriter& writer, u16FixVec_t& blockVector, u16FixVec_t& blockLocations,
-                                const u16FixVec_t& sbmrgLocations, u8 blockMap[MAP_SIZE]) const;
-
     public:
         explicit ChunkV12(ChunkData* chunkDataIn) : VChunkBase(chunkDataIn) {}
 
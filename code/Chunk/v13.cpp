@@ -1,5 +1,6 @@
 #include "v13.hpp"
 
+#include "code/Chunk/gridCodec.hpp"
 #include "code/Chunk/helpers.hpp"
 #include "common/nbt.hpp"
 
@@ -8,12 +9,12 @@ namespace editor::chunk {
 
     void ChunkV13::allocChunk() const {
         chunkData->DataGroupCount = 0;
-        chunkData->newBlocks = u16_vec(65536);
-        chunkData->submerged = u16_vec(65536);
-        chunkData->skyLight = u8_vec(32768);
-        chunkData->blockLight = u8_vec(32768);
-        chunkData->heightMap = u8_vec(256);
-        chunkData->biomes = u8_vec(256);
+        chunkData->newBlocks.assign(65536, 0);
+        chunkData->submerged.assign(65536, 0);
+        chunkData->skyLight.clear();
+        chunkData->blockLight.clear();
+        chunkData->heightMap.assign(256, 0);
+        chunkData->biomes.assign(256, 0);
     }
 
     // #####################################################
@@ -34,10 +35,10 @@ namespace editor::chunk {
 
         {
         c_auto dataArray = fetchSections<4>(chunkData, reader);
-        readSection(dataArray[0], &chunkData->skyLight[0]);
-        readSection(dataArray[1], &chunkData->skyLight[16348]);
-        readSection(dataArray[2], &chunkData->blockLight[0]);
-        readSection(dataArray[3], &chunkData->blockLight[16348]);
+        chunkData->skyLight.readSection(0, dataArray[0]);
+        chunkData->skyLight.readSection(1, dataArray[1]);
+        chunkData->blockLight.readSection(0, dataArray[2]);
+        chunkData->blockLight.readSection(1, dataArray[3]);
         }
 
         reader.readBytes(256, chunkData->heightMap.data());
@@ -58,26 +59,6 @@ namespace editor::chunk {
     }
 
 
-    static void setBlocks(u16_vec& writeVec, c_u8* grid, int gridOffset) {
-        int readOffset = 0;
-
-        for (int zIter = 0; zIter < 4; zIter++) {
-            for (int xIter = 0; xIter < 4; xIter++) {
-                for (int yIter = 0; yIter < 4; yIter++) {
-                    c_int blockOffset = toIndex<eBlockOrder::yXZy>(xIter,
-                                                                   yIter,
-                                                                   zIter);
-                    c_u8 num1 = grid[readOffset++];
-                    c_u8 num2 = grid[readOffset++];
-                    writeVec[gridOffset + blockOffset] = static_cast<u16>(num1)
-                                                         | static_cast<u16>(num2) << 8U;
-                }
-            }
-        }
-    }
-
-
-
     void ChunkV13::readBlockData(DataReader& reader) const {
         c_u32 maxSectionAddress = reader.read<u16>() << 8;
 
@@ -116,8 +97,6 @@ namespace editor::chunk {
             for (int gridZ = 0; gridZ < 4; gridZ++) {
             for (int gridY = 0; gridY < 4; gridY++) {
 
-                u8 blockGrid[GRID_SIZE] = {0};
-                u8 sbmrgGrid[GRID_SIZE] = {0};
                 c_int gridIndex = gridY + gridX * 4 + gridZ * 16;
                 c_u8 blockLower = sectionHeader[gridIndex * 2];
                 c_u8 blockUpper = sectionHeader[gridIndex * 2 + 1];
@@ -137,39 +116,32 @@ namespace editor::chunk {
 
                 const u8* bufferPtr = reader.data() + gridPosition;
                 reader.seek(gridPosition + V13_GRID_SIZES[format] + 128);
-                bool success = true;
+                // grids decode straight into the chunk's yXZy arrays
+                u16* blocks = chunkData->newBlocks.data() + gridOffset;
+                u16* sbmrg = chunkData->submerged.data() + gridOffset;
                 switch(format) {
                     case V13_0_UNO:
-                        for (int i = 0; i < 128; i += 2) {
-                            blockGrid[i + 0] = blockLower;
-                            blockGrid[i + 1] = blockUpper;
-                        }
+                        grid::fillUniform(blocks, static_cast<u16>(blockLower | blockUpper << 8));
                         break;
-                    case V13_1_BIT:           success = readGrid<1>(bufferPtr, blockGrid); break;
-                    case V13_1_BIT_SUBMERGED: success = readGridSubmerged<1>(bufferPtr, blockGrid, sbmrgGrid); break;
-                    case V13_2_BIT:           success = readGrid<2>(bufferPtr, blockGrid); break;
-                    case V13_2_BIT_SUBMERGED: success = readGridSubmerged<2>(bufferPtr, blockGrid, sbmrgGrid); break;
-                    case V13_3_BIT:           success = readGrid<3>(bufferPtr, blockGrid); break;
-                    case V13_3_BIT_SUBMERGED: success = readGridSubmerged<3>(bufferPtr, blockGrid, sbmrgGrid); break;
-                    case V13_4_BIT:           success = readGrid<4>(bufferPtr, blockGrid); break;
-                    case V13_4_BIT_SUBMERGED: success = readGridSubmerged<4>(bufferPtr, blockGrid, sbmrgGrid); break;
-                    case V13_8_FULL:          fillAllBlocks<GRID_SIZE>(bufferPtr, blockGrid); break;
+                    case V13_1_BIT:           grid::decodeGrid<1>(bufferPtr, blocks); break;
+                    case V13_1_BIT_SUBMERGED: grid::decodeGridSubmerged<1>(bufferPtr, blocks, sbmrg); break;
+                    case V13_2_BIT:           grid::decodeGrid<2>(bufferPtr, blocks); break;
+                    case V13_2_BIT_SUBMERGED: grid::decodeGridSubmerged<2>(bufferPtr, blocks, sbmrg); break;
+                    case V13_3_BIT:           grid::decodeGrid<3>(bufferPtr, blocks); break;
+                    case V13_3_BIT_SUBMERGED: grid::decodeGridSubmerged<3>(bufferPtr, blocks, sbmrg); break;
+                    case V13_4_BIT:           grid::decodeGrid<4>(bufferPtr, blocks); break;
+                    case V13_4_BIT_SUBMERGED: grid::decodeGridSubmerged<4>(bufferPtr, blocks, sbmrg); break;
+                    case V13_8_FULL:          grid::copyFull(bufferPtr, blocks); break;
                     case V13_8_FULL_BLOCKS_SUBMERGED:
-                        fillAllBlocks<GRID_SIZE>(bufferPtr +   0, blockGrid);
-                        fillAllBlocks<GRID_SIZE>(bufferPtr + 128, sbmrgGrid);
+                        grid::copyFull(bufferPtr +   0, blocks);
+                        grid::copyFull(bufferPtr + 128, sbmrg);
                         break;
                     default: // this should never occur
                         return;
                 }
 
-                if EXPECT_FALSE (!success) {
-                    return;
-                }
-
-                setBlocks(chunkData->newBlocks, blockGrid, gridOffset);
                 if ((format & 1) != 0) {
                     chunkData->hasSubmerged = true;
-                    setBlocks(chunkData->submerged, sbmrgGrid, gridOffset);
                 }
             }
             }
@@ -179,100 +151,6 @@ namespace editor::chunk {
     }
 
 
-    /**
-     * only parse the palette + positions.
-     * DOES NOT PARSE LIQUID DATA
-     * @tparam BitsPerBlock
-     * @param buffer
-     * @param grid
-     * @return
-     */
-    template<size_t BitsPerBlock>
-    bool ChunkV13::readGrid(c_u8* buffer, u8 grid[128]) const {
-        c_int size = (1 << BitsPerBlock) * 2;
-        u16_vec palette(size);
-        std::copy_n(buffer, size, palette.begin());
-
-        for (int index = 0; index < 64; index++) {
-            u8 vBlocks[BitsPerBlock];
-
-            c_int row = index / 8;
-            c_int column = index % 8;
-            for (u32 j = 0; j < BitsPerBlock; j++)
-                vBlocks[j] = buffer[size + row + j * 8];
-
-            u16 idx = 0;
-            u8 mask = 0b10000000 >> column;
-            for (u32 k = 0; k < BitsPerBlock; k++)
-                idx |= ((vBlocks[k] & mask) >> (7 - column)) << k;
-
-            if EXPECT_FALSE (idx >= size)
-                return false;
-
-            c_int gridIndex = index * 2;
-            c_int paletteIndex = idx * 2;
-            grid[gridIndex + 0] = palette[paletteIndex + 0];
-            grid[gridIndex + 1] = palette[paletteIndex + 1];
-        }
-        return true;
-    }
-
-
-
-    /**
-     * parses the palette + positions + liquid data.
-     *
-     * @tparam BitsPerBlock
-     * @param buffer
-     * @param blockGrid
-     * @param SbmrgGrid
-     * @return
-     */
-    template<size_t BitsPerBlock>
-    bool ChunkV13::readGridSubmerged(c_u8* buffer,
-                                     u8 blockGrid[GRID_SIZE],
-                                     u8 SbmrgGrid[GRID_SIZE]) const {
-        c_int size = (1 << BitsPerBlock) * 2;
-        u16_vec palette(size);
-        std::copy_n(buffer, size, palette.begin());
-
-        for (int i = 0; i < 8; i++) {
-            u8 vBlocks[BitsPerBlock];
-            u8 vWaters[BitsPerBlock];
-
-            // this loads the pieces into a buffer
-            for (u32 j = 0; j < BitsPerBlock; j++) {
-                c_int offset = size + i + j * 8;
-                vBlocks[j] = buffer[offset];
-                vWaters[j] = buffer[offset + BitsPerBlock * 8];
-            }
-
-            for (int j = 0; j < 8; j++) {
-                u8 mask = 0b10000000 >> j;
-                u16 idxBlock = 0;
-                u16 idxSbmrg = 0;
-                for (u32 k = 0; k < BitsPerBlock; k++) {
-                    idxBlock |= (vBlocks[k] & mask) >> (7 - j) << k;
-                    idxSbmrg |= (vWaters[k] & mask) >> (7 - j) << k;
-                }
-
-                if EXPECT_FALSE (idxBlock >= size || idxSbmrg >= size) {
-                    return false;
-                }
-
-                c_int gridIndex = (i * 8 + j) * 2;
-                c_int paletteIndexBlock = idxBlock * 2;
-                c_int paletteIndexSbmrg = idxSbmrg * 2;
-                blockGrid[gridIndex + 0] = palette[paletteIndexBlock + 0];
-                blockGrid[gridIndex + 1] = palette[paletteIndexBlock + 1];
-                SbmrgGrid[gridIndex + 0] = palette[paletteIndexSbmrg + 0];
-                SbmrgGrid[gridIndex + 1] = palette[paletteIndexSbmrg + 1];
-            }
-        }
-        return true;
-    }
-
-
     // #####################################################
     // #               Write Section
     // #####################################################
@@ -287,10 +165,10 @@ namespace editor::chunk {
 
         writeBlockData(writer);
 
-        writeSection(writer, &chunkData->skyLight[0]);
-        writeSection(writer, &chunkData->skyLight[16348]);
-        writeSection(writer, &chunkData->blockLight[0]);
-        writeSection(writer, &chunkData->blockLight[16348]);
+        chunkData->skyLight.writeSection(writer, 0);
+        chunkData->skyLight.writeSection(writer, 1);
+        chunkData->blockLight.writeSection(writer, 0);
+        chunkData->blockLight.writeSection(writer, 1);
 
         writer.writeBytes(chunkData->heightMap.data(), 256);
         writer.write<u16>(chunkData->terrainPopulated);
@@ -46,10 +46,6 @@ namespace editor::chunk {
         // Read Section
 
         void readBlockData(DataReader& reader) const;
-        template<size_t BitsPerBlock>
-        bool readGrid(c_u8* buffer, u8 grid[128]) const;
-        template<size_t BitsPerBlock>
-        bool readGridSubmerged(u8 const* buffer, u8 blockGrid[GRID_SIZE], u8 SbmrgGrid[GRID_SIZE]) const;
 
         // Write Section
 
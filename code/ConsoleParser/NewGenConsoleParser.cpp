@@ -4,7 +4,7 @@
 #include "code/SaveFile/fileListing.hpp"
 #include "common/RLE/rle_nsxps4.hpp"
 #include "common/utils.hpp"
-#include "include/tinf/tinf.h"
+#include "common/codec/inflate.hpp"
 
 namespace editor {
 
@@ -44,7 +44,7 @@ namespace editor {
         fread(src.data(), 1, input_size, f_in);
         fclose(f_in);
 
-        int status = tinf_zlib_uncompress(data.data(), data.size_ptr(), src.data(), input_size);
+        int status = codec::inflateZlib(src.data(), input_size, data.data(), data.size_ptr());
         if (status != 0) {
             return DECOMPRESS;
         }
@@ -52,7 +52,7 @@ namespace editor {
 
         DataWriter::writeFile("C:\\Users\\jerrin\\CLionProjects\\LegacyEditor\\build\\GAMEDATA_WINDURANGO", data.span());
 
-        status = FileListing::readListing(saveProject, data, m_console);
+        status = FileListing::readListing(saveProject, std::move(data), m_console);
         if (status != 0) {
             return -1;
         }
@@ -101,12 +101,17 @@ namespace editor {
 
             // TODO: get m_timestamp from file itself / make one up
             u32 timestamp = 0;
-            saveProject.emplaceFile(
+            LCEFile& lceFile = saveProject.emplaceFile(
                     saveProject.m_stateSettings.console(),
                     timestamp,
                     inDirPath,
                     fileNameStr
                     );
+            // keeps edits from being written back into the folder being read
+            if (saveProject.m_keepFilesInMemory) {
+                c_auto contents = std::make_shared<const Buffer>(std::move(byteVec));
+                lceFile.setView(contents, contents->span());
+            }
         }
 
         return SUCCESS;
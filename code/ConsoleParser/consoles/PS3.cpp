@@ -1,7 +1,7 @@
 #include "PS3.hpp"
 
 #include "include/sfo/sfo.hpp"
-#include "include/tinf/tinf.h"
+#include "common/codec/inflate.hpp"
 
 #include "common/utils.hpp"
 #include "include/png/crc.hpp"
@@ -68,12 +68,11 @@ namespace editor {
         fread(src.data(), 1, src.size(), f_in);
         fclose(f_in);
 
-        tinf_uncompress(data.data(), &final_size, src.data(), src.size());
-        if (final_size == 0) {
+        if (codec::inflateRaw(src.data(), src.size(), data.data(), data.size_ptr()) != SUCCESS) {
             return printf_err(DECOMPRESS, "%s", ERROR_3);
         }
 
-        int status = FileListing::readListing(saveProject, data, m_console);
+        int status = FileListing::readListing(saveProject, std::move(data), m_console);
         if (status != 0) {
             return -1;
         }
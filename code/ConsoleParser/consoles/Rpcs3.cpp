@@ -56,7 +56,7 @@ namespace editor {
         fread(data.data(), 1, data.size(), f_in);
         fclose(f_in);
 
-        int status = FileListing::readListing(saveProject, data, m_console);
+        int status = FileListing::readListing(saveProject, std::move(data), m_console);
         if (status != 0) {
             return -1;
         }
@@ -121,24 +121,34 @@ namespace editor {
 
 
         // GAMEDATA
+        // the listing goes to disk as it is assembled, its size and crc are kept on the way
         fs::path gameDataPath = rootPath / "GAMEDATA";
-        Buffer inflatedData = FileListing::writeListing(saveProject, theSettings);
-        Buffer deflatedData;
-        status = deflateListing(gameDataPath, inflatedData, deflatedData);
+        const ListingLayout layout = FileListing::planListing(saveProject);
+
+        FileSink fileSink(gameDataPath);
+        if (!fileSink.isOpen()) {
+            return printf_err(FILE_ERROR,
+                              "failed to write savefile to \"%s\"\n",
+                              gameDataPath.string().c_str());
+        }
+        status = FileListing::streamListing(saveProject, theSettings, layout, fileSink);
+        if (status == SUCCESS) {
+            status = fileSink.finish();
+        }
         if (status != 0) return printf_err(status,
                                            "failed to compress fileListing\n");
         theSettings.setOutFilePath(gameDataPath);
-        printf("[*] gamedata final size: %u\n", deflatedData.size());
+        printf("[*] gamedata final size: %u\n", static_cast<u32>(fileSink.size()));
 
 
         // METADATA
         fs::path metadataPath = rootPath / "METADATA";
-        c_u32 crc1 = crc(deflatedData.data(), deflatedData.size());
+        c_u32 crc1 = fileSink.crc();
         c_u32 crc2 = crc(fileInfoData.data(), fileInfoData.size());
 
         DataWriter managerMETADATA(256);
         managerMETADATA.write<u32>(3);
-        managerMETADATA.write<u32>(deflatedData.size());
+        managerMETADATA.write<u32>(fileSink.size());
         managerMETADATA.write<u32>(fileInfoData.size());
         managerMETADATA.write<u32>(crc1);
         managerMETADATA.write<u32>(crc2);
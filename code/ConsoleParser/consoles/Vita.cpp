@@ -48,9 +48,12 @@ namespace editor {
             return printf_err(MALLOC_FAILED, ERROR_1, dst_size);
         }
 
-        codec::RLEVITA_DECOMPRESS(reader.data() + 8, reader.size() - 8, dst.data(), dst.size());
+        if (codec::RLEVITA_DECOMPRESS(reader.data() + 8, reader.size() - 8, dst.data(), dst.size()) == 0
+            && !dst.empty()) {
+            return printf_err(DECOMPRESS, "%s", ERROR_3);
+        }
 
-        int status = FileListing::readListing(saveProject, dst, m_console);
+        int status = FileListing::readListing(saveProject, std::move(dst), m_console);
         if (status != 0) {
             return -1;
         }
@@ -72,15 +75,34 @@ namespace editor {
         fs::create_directories(rootPath);
 
         // GAMEDATA
+        // the listing is compressed as it is assembled, it never exists in memory as a whole
         fs::path gameDataPath = rootPath / "GAMEDATA.bin";
-        Buffer deflatedData = FileListing::writeListing(saveProject, theSettings);
-        Buffer inflatedData;
+        const ListingLayout layout = FileListing::planListing(saveProject);
 
-        status = deflateListing(gameDataPath, deflatedData, inflatedData);
+        FileSink fileSink(gameDataPath);
+        if (!fileSink.isOpen()) {
+            return printf_err(FILE_ERROR,
+                              "failed to write savefile to \"%s\"\n",
+                              gameDataPath.string().c_str());
+        }
+        // 4-bytes of '0'
+        // 4-bytes of total decompressed fileListing size
+        DataWriter header(8, Endian::Little);
+        header.write<u32>(0);
+        header.write<u32>(layout.totalSize);
+        status = fileSink.write(header.span());
+
+        RleVitaSink rleSink(fileSink);
+        if (status == SUCCESS) {
+            status = FileListing::streamListing(saveProject, theSettings, layout, rleSink);
+        }
+        if (status == SUCCESS) {
+            status = rleSink.finish();
+        }
         if (status != 0) return printf_err(status,
                                            "failed to compress fileListing\n");
         theSettings.setOutFilePath(gameDataPath);
-        printf("[*] gamedata final size: %u\n", deflatedData.size());
+        printf("[*] gamedata final size: %llu\n", static_cast<unsigned long long>(fileSink.size()));
 
 
         // FILE INFO
@@ -109,11 +131,14 @@ namespace editor {
 
 
     int Vita::deflateListing(const fs::path& gameDataPath, Buffer& inflatedData, Buffer& deflatedData) const {
-        deflatedData.allocate(inflatedData.size() + 2);
+        deflatedData.allocate(codec::RLEVITA_compressBound(inflatedData.size()));
 
         *deflatedData.size_ptr() = codec::RLEVITA_COMPRESS(
                 inflatedData.data(), inflatedData.size(),
                 deflatedData.data(), deflatedData.size());
+        if (deflatedData.empty() && !inflatedData.empty()) {
+            return COMPRESS;
+        }
 
 
         // 4-bytes of '0'
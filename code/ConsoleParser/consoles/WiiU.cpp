@@ -1,9 +1,9 @@
 #include "WiiU.hpp"
 
 #include "include/zlib-1.2.12/zlib.h"
-#include "include/tinf/tinf.h"
 
 #include "common/utils.hpp"
+#include "common/codec/inflate.hpp"
 #include "common/data/DataWriter.hpp"
 #include "common/fmt.hpp"
 
@@ -51,13 +51,13 @@ namespace editor {
             return printf_err(MALLOC_FAILED, ERROR_1, dst_size);
         }
 
-        int status = tinf_zlib_uncompress(dst.data(), dst.size_ptr(),
-                                          reader.data() + 8, reader.size() - 8);
+        int status = codec::inflateZlib(reader.data() + 8, reader.size() - 8,
+                                        dst.data(), dst.size_ptr());
         if (status != 0) {
             return DECOMPRESS;
         }
 
-        status = FileListing::readListing(saveProject, dst, m_console);
+        status = FileListing::readListing(saveProject, std::move(dst), m_console);
         if (status != 0) {
             return -1;
         }
@@ -72,17 +72,37 @@ namespace editor {
         const fs::path rootPath = theSettings.getInFolderPath();
 
         // GAMEDATA
+        // the listing is compressed as it is assembled, it never exists in memory as a whole
         fs::path gameDataPath = rootPath / getCurrentDateTimeString();
-        Buffer inflatedData = FileListing::writeListing(saveProject, theSettings);
+        const ListingLayout layout = FileListing::planListing(saveProject);
 
-        Buffer deflatedData;
-
-        status = deflateListing(gameDataPath, inflatedData, deflatedData);
+        FileSink fileSink(gameDataPath);
+        if (!fileSink.isOpen()) {
+            return printf_err(FILE_ERROR,
+                              "failed to write savefile to \"%s\"\n",
+                              gameDataPath.string().c_str());
+        }
+        DataWriter header(8);
+        header.write<u64>(layout.totalSize);
+        status = fileSink.write(header.span());
+
+        std::unique_ptr<ListingSink> deflateSink;
+        if (theSettings.m_listingThreads == 1) {
+            deflateSink = std::make_unique<DeflateSink>(fileSink);
+        } else {
+            deflateSink = std::make_unique<ParallelDeflateSink>(fileSink, theSettings.m_listingThreads);
+        }
+        if (status == SUCCESS) {
+            status = FileListing::streamListing(saveProject, theSettings, layout, *deflateSink);
+        }
+        if (status == SUCCESS) {
+            status = deflateSink->finish();
+        }
         if (status != 0)
             return printf_err(status, "failed to compress fileListing\n");
         theSettings.setOutFilePath(gameDataPath);
 
-        cmn::log(cmn::eLog::info, "Savefile size: {}\n", deflatedData.size());
+        cmn::log(cmn::eLog::info, "Savefile size: {}\n", fileSink.size() - header.size());
 
 
 
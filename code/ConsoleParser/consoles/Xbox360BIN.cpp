@@ -77,7 +77,7 @@ namespace editor {
             return DECOMPRESS;
         }
 
-        int status = FileListing::readListing(saveProject, data, m_console);
+        int status = FileListing::readListing(saveProject, std::move(data), m_console);
         if (status != 0) {
             return -1;
         }
@@ -1,8 +1,12 @@
 #include "Xbox360DAT.hpp"
 
+#include "common/codec/XCompress.hpp"
 #include "common/codec/XDecompress.hpp"
+#include "common/data/DataWriter.hpp"
+#include "common/fmt.hpp"
 #include "common/utils.hpp"
 
+#include "code/threaded.hpp"
 #include "code/SaveFile/stateSettings.hpp"
 #include "code/SaveFile/SaveProject.hpp"
 #include "code/SaveFile/fileListing.hpp"
@@ -39,7 +43,7 @@ namespace editor {
         }
 
         if (!saveProject.m_stateSettings.shouldDecompress()) {
-            int status = FileListing::readListing(saveProject, fileData, m_console);
+            int status = FileListing::readListing(saveProject, std::move(fileData), m_console);
             return status;
         }
 
@@ -66,18 +70,78 @@ namespace editor {
             return printf_err(DECOMPRESS, "%s", ERROR_3);
         }
 
-        int status = FileListing::readListing(saveProject, inflatedData, m_console);
+        int status = FileListing::readListing(saveProject, std::move(inflatedData), m_console);
         return status;
     }
 
 
-    int Xbox360DAT::deflateToSave(MU SaveProject& saveProject, MU WriteSettings& theSettings) const {
-        printf("Xbox360DAT.write(): not implemented!\n");
-        return NOT_IMPLEMENTED;
+    /**
+     * LZX-compresses the listing and writes it with its header: the compressed size plus 8,
+     * then the 8-byte decompressed size. Segments are parsed on the shared ThreadPool, a
+     * few per thread at a time, and written in order; the output is the same for any
+     * thread count.
+     * @param threadCount threads parsing segments, 0 uses the whole pool
+     */
+    static int writeGameData(const fs::path& gameDataPath, const Buffer& inflatedData, Buffer& deflatedData,
+                             u32 threadCount) {
+        codec::LzxCompressor compressor(inflatedData.span());
+        if (compressor.segmentCount() == 0) {
+            return printf_err(COMPRESS, "cannot compress an empty fileListing\n");
+        }
+
+        c_u32 concurrency = ThreadPool::instance().concurrency();
+        if (threadCount == 0 || threadCount > concurrency) { threadCount = concurrency; }
+        // two segments per thread keeps every thread busy, and bounds the matches held at once
+        c_u32 batchSize = threadCount * 2;
+
+        std::vector<u8> stream;
+        stream.reserve(codec::XCompressBound(inflatedData.size()));
+        for (u32 first = 0; first < compressor.segmentCount(); first += batchSize) {
+            c_u32 count = std::min(batchSize, compressor.segmentCount() - first);
+            parallel_for(count, [&](const size_t index) {
+                compressor.parseSegment(first + static_cast<u32>(index));
+            }, threadCount);
+            for (u32 index = first; index < first + count; index++) {
+                if (c_int status = compressor.writeSegment(index, stream); status != SUCCESS) {
+                    return status;
+                }
+            }
+        }
+
+        DataWriter writer(stream.size() + 12);
+        writer.write<u32>(static_cast<u32>(stream.size()) + 8);
+        writer.write<u64>(inflatedData.size());
+        writer.writeBytes(stream.data(), stream.size());
+        deflatedData = writer.take();
+        try {
+            DataWriter::writeFile(gameDataPath, deflatedData.span());
+        } catch (const std::exception& e) {
+            return printf_err(FILE_ERROR,
+                              "failed to write savefile to \"%s\"\n",
+                              gameDataPath.string().c_str());
+        }
+        return SUCCESS;
+    }
+
+
+    int Xbox360DAT::deflateToSave(SaveProject& saveProject, WriteSettings& theSettings) const {
+        // GAMEDATA
+        fs::path gameDataPath = theSettings.getInFolderPath() / "savegame.dat";
+        Buffer inflatedData = FileListing::writeListing(saveProject, theSettings);
+        Buffer deflatedData;
+
+        int status = writeGameData(gameDataPath, inflatedData, deflatedData, theSettings.m_listingThreads);
+        if (status != 0) return printf_err(status,
+                                           "failed to compress fileListing\n");
+        theSettings.setOutFilePath(gameDataPath);
+
+        cmn::log(cmn::eLog::info, "Savefile size: {}\n", deflatedData.size());
+
+        return SUCCESS;
     }
 
 
-    int Xbox360DAT::deflateListing(MU const fs::path& gameDataPath, MU Buffer& inflatedData, MU Buffer& deflatedData) const {
-        return NOT_IMPLEMENTED;
+    int Xbox360DAT::deflateListing(const fs::path& gameDataPath, Buffer& inflatedData, Buffer& deflatedData) const {
+        return writeGameData(gameDataPath, inflatedData, deflatedData, 0);
     }
-}
\ No newline at end of file
+}
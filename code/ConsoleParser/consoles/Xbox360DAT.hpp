@@ -21,8 +21,8 @@ namespace editor {
 
         ND int inflateFromLayout(SaveProject& saveProject, const fs::path& theFilePath) override;
         ND int inflateListing(SaveProject& saveProject) override;
-        ND int deflateToSave(MU SaveProject& saveProject, MU WriteSettings& theSettings) const override;
-        ND int deflateListing(MU const fs::path& gameDataPath, MU Buffer& inflatedData, MU Buffer& deflatedData) const override;
+        ND int deflateToSave(SaveProject& saveProject, WriteSettings& theSettings) const override;
+        ND int deflateListing(const fs::path& gameDataPath, Buffer& inflatedData, Buffer& deflatedData) const override;
 
     };
 
@@ -1,5 +1,7 @@
 #include "LCEFile.hpp"
 
+#include <cstring>
+
 #include "common/nbt.hpp"
 #include "common/utils.hpp"
 
@@ -7,6 +9,74 @@
 namespace editor {
 
 
+    Buffer LCEFile::getBuffer() const {
+        if (!isInMemory()) {
+            return DataReader::readFile(path());
+        }
+        Buffer buffer(m_view.size());
+        if (!m_view.empty()) {
+            std::memcpy(buffer.data(), m_view.data(), m_view.size());
+        }
+        return buffer;
+    }
+
+
+    FileContents LCEFile::getContents() const {
+        if (isInMemory()) {
+            return {m_memory, m_view};
+        }
+        c_auto owner = std::make_shared<const Buffer>(DataReader::readFile(path()));
+        return {owner, owner->span()};
+    }
+
+
+    void LCEFile::setBuffer(Buffer buffer) {
+        if (!isInMemory()) {
+            DataWriter::writeFile(path(), buffer.span());
+            return;
+        }
+        m_memory = std::make_shared<const Buffer>(std::move(buffer));
+        m_view = m_memory->span();
+    }
+
+
+    void LCEFile::setView(std::shared_ptr<const Buffer> backing, const std::span<const u8> view) {
+        m_memory = std::move(backing);
+        m_view = view;
+    }
+
+
+    void LCEFile::moveToMemory() {
+        if (isInMemory()) { return; }
+        fs::path filePath = path();
+        if (fs::exists(filePath) && fs::is_regular_file(filePath)) {
+            m_memory = std::make_shared<const Buffer>(DataReader::readFile(filePath));
+        } else {
+            m_memory = std::make_shared<const Buffer>();
+        }
+        m_view = m_memory->span();
+    }
+
+
+    int LCEFile::spillToDisk() {
+        if (!isInMemory()) { return SUCCESS; }
+        fs::path filePath = path();
+        try {
+            if (fs::path folderPath = filePath.parent_path();
+                !folderPath.empty() && !fs::exists(folderPath)) {
+                fs::create_directories(folderPath);
+            }
+            DataWriter::writeFile(filePath, m_view);
+        } catch (const std::exception& e) {
+            printf("LCEFile::spillToDisk: %s\n", e.what());
+            return FILE_ERROR;
+        }
+        m_memory.reset();
+        m_view = {};
+        return SUCCESS;
+    }
+
+
     void LCEFile::initialize(const std::string& fileNameIn) {
         if (fileNameIn.ends_with(".mcr")) {
             if (fileNameIn.starts_with("DIM-1")) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+#include <span>
 #include <utility>
 
 #include "include/lce/enums.hpp"
@@ -12,11 +14,28 @@
 namespace editor {
 
 
+    /// the contents of an LCEFile, owner keeps data alive
+    struct FileContents {
+        std::shared_ptr<const Buffer> owner;
+        std::span<const u8> data;
+    };
+
+
+    /**
+     * A sub-file of a save. Its contents live either on disk at path(), or in memory:
+     * as a view into the decompressed save it was read from, or in its own buffer once
+     * it has been modified. Disk is only touched for files that are not in memory.
+     */
     class LCEFile {
         NBTCompound m_nbt;
         fs::path m_folderPath;
         fs::path m_fileName;
 
+        /// set while the contents are in memory, shared with every file read from the same save
+        std::shared_ptr<const Buffer> m_memory;
+        /// the contents inside m_memory
+        std::span<const u8> m_view;
+
     public:
         lce::CONSOLE m_console = lce::CONSOLE::NONE;
         lce::FILETYPE m_fileType = lce::FILETYPE::NONE;
@@ -38,15 +57,30 @@ namespace editor {
             return m_folderPath / m_fileName;
         }
 
-        MU ND Buffer getBuffer() const {
-            return DataReader::readFile(path());
-        }
+        /// a copy of the contents
+        MU ND Buffer getBuffer() const;
 
-        MU void setBuffer(Buffer buffer) const {
-            DataWriter::writeFile(path(), buffer.span());
-        }
+        /// the contents without copying them when they are in memory
+        MU ND FileContents getContents() const;
+
+        /// replaces the contents, in memory if the file is in memory and on disk otherwise
+        MU void setBuffer(Buffer buffer);
+
+        MU ND bool isInMemory() const { return m_memory != nullptr; }
+
+        /// keeps the contents in memory as a view into backing, nothing is copied
+        MU void setView(std::shared_ptr<const Buffer> backing, std::span<const u8> view);
+
+        /// loads the contents from disk if the file exists there, later writes stay in memory
+        MU void moveToMemory();
+
+        /// writes the in-memory contents to path() and drops them, later reads go to disk
+        MU int spillToDisk();
 
         u64 detectSize() const {
+            if (isInMemory()) {
+                return m_view.size();
+            }
             fs::path filePath = path();
             if (fs::exists(filePath) && fs::is_regular_file(filePath)) {
                 return fs::file_size(filePath);
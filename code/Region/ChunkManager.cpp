@@ -2,14 +2,16 @@
 
 #include "include/lce/processor.hpp"
 
-#include "include/tinf/tinf.h"
-#include "include/zlib-1.2.12/zlib.h"
 
 
 #include "common/RLE/rle.hpp"
+#include "common/codec/XCompress.hpp"
 #include "common/codec/XDecompress.hpp"
+#include "common/codec/deflate.hpp"
+#include "common/codec/inflate.hpp"
 
 #include "code/Chunk/chunkData.hpp"
+#include "code/Chunk/chunkDataPool.hpp"
 #include "code/Chunk/v10.hpp"
 #include "code/Chunk/v11.hpp"
 #include "code/Chunk/v12.hpp"
@@ -22,23 +24,123 @@ namespace editor {
 
 
 
+    eChunkCodec getChunkCodec(const lce::CONSOLE console) {
+        switch (console) {
+            case lce::CONSOLE::XBOX360:
+                return eChunkCodec::LZX;
+            case lce::CONSOLE::PS3:
+            case lce::CONSOLE::RPCS3:
+                return eChunkCodec::PS3_DEFLATE;
+            case lce::CONSOLE::SWITCH:
+            case lce::CONSOLE::WIIU:
+            case lce::CONSOLE::VITA:
+            case lce::CONSOLE::PS4:
+            case lce::CONSOLE::XBOX1:
+            case lce::CONSOLE::WINDURANGO:
+                return eChunkCodec::ZLIB;
+            default:
+                return eChunkCodec::NONE;
+        }
+    }
+
+
     ChunkManager::ChunkManager() {
-        chunkData = new chunk::ChunkData();
         this->buffer.clear();
     }
 
 
     ChunkManager::~ChunkManager() {
-        delete chunkData;
+        releaseChunkData();
+    }
+
+
+    void ChunkManager::releaseChunkData() {
+        chunk::ChunkDataPool::instance().release(chunkData);
         chunkData = nullptr;
     }
 
 
+    void ChunkManager::materialize() {
+        if (!isShared()) {
+            m_backing.reset();
+            m_view = {};
+            return;
+        }
+        buffer = Buffer(static_cast<u32>(m_view.size()));
+        std::memcpy(buffer.data(), m_view.data(), m_view.size());
+        m_backing.reset();
+        m_view = {};
+    }
+
+
+    void ChunkManager::clearPayload() {
+        buffer.clear();
+        m_backing.reset();
+        m_view = {};
+    }
+
+
+    bool ChunkManager::isDirty() const {
+        return chunkData != nullptr && chunkData->dirty;
+    }
+
+
+    void ChunkManager::releaseOriginal() {
+        m_originalBacking.reset();
+        m_original = {};
+        m_originalConsole = lce::CONSOLE::NONE;
+    }
+
+
+    void ChunkManager::keepOriginal(const lce::CONSOLE console) {
+        if (isShared()) {
+            m_originalBacking = m_backing;
+            m_original = m_view;
+        } else {
+            // moving the buffer keeps its memory, so spans into it stay valid
+            auto owned = std::make_shared<const Buffer>(std::move(buffer));
+            m_original = owned->span();
+            m_originalBacking = std::move(owned);
+        }
+        m_originalHeader = chunkHeader;
+        m_originalConsole = console;
+    }
+
+
+    /// swaps the original compressed bytes back in if the chunk is clean and the codec matches
+    bool ChunkManager::restoreOriginal(const lce::CONSOLE console) {
+        if (!hasOriginal() || isDirty() || !isSameChunkCodec(m_originalConsole, console)) {
+            return false;
+        }
+        c_u32 timestamp = chunkHeader.getTimestamp();
+        c_u32 newSaveFlag = chunkHeader.getNewSaveFlag();
+        buffer.clear();
+        m_backing = m_originalBacking;
+        m_view = m_original;
+        chunkHeader = m_originalHeader;
+        chunkHeader.setTimestamp(timestamp);
+        chunkHeader.setNewSaveFlag(newSaveFlag);
+        return true;
+    }
+
+
+    u64 ChunkManager::getMemoryUsage() const {
+        u64 total = payloadSize();
+        if (hasOriginal() && m_originalBacking != m_backing) {
+            total += m_original.size();
+        }
+        if (chunkData != nullptr) {
+            total += chunkData->getMemoryUsage();
+        }
+        return total;
+    }
+
+
     MU int ChunkManager::checkVersion() const {
-        if (this->buffer.empty()) {
+        if (this->empty()) {
             return -1;
         }
-        DataReader checker(buffer.data(), buffer.size());
+        DataReader checker(payload());
         int version = checker.peek_at<u16>(0);
         return version;
 
@@ -54,11 +156,15 @@ namespace editor {
             }
         }
         // cannot read chunk if there is no data
-        if (buffer.empty()) {
+        if (empty()) {
             return;
         }
+        if (chunkData == nullptr) {
+            chunkData = chunk::ChunkDataPool::instance().acquire();
+        }
+
         // read the chunk
-        DataReader reader(buffer.span());
+        DataReader reader(payload());
 
         chunkData->lastVersion = reader.read<u16>();
         if (chunkData->lastVersion == 0x0A00) { // start of NBT
@@ -84,6 +190,7 @@ namespace editor {
                 break;
             default:;
         }
+        chunkData->dirty = false;
 
 
 
@@ -101,9 +208,17 @@ namespace editor {
 
 
     MU void ChunkManager::writeChunk(MU lce::CONSOLE outConsole) {
-        if (chunkHeader.isZipCompressed()) {
+        if (chunkHeader.isZipCompressed() || chunkData == nullptr) {
+            return;
+        }
+
+        // unmodified, so the decompressed payload in buffer is still current;
+        // either the original bytes are reused or it only needs recompressing
+        if (!isDirty() && hasOriginal()) {
+            ensureCompressed(outConsole);
             return;
         }
+        releaseOriginal();
 
 
 //         Buffer outBuffer;
@@ -111,9 +226,31 @@ namespace editor {
 // #ifndef DONT_MEMSET0
 //         memset(outBuffer.data, 0, CHUNK_BUFFER_SIZE);
 // #endif
-        DataWriter writer;
+        Buffer encoded = encodeChunkData();
 
+        // if (chunkData->chunkX == 0 && chunkData->chunkZ == -10) {
+        //     managerOut.writeToFile(R"(C:\Users\jerrin\CLionProjects\LegacyEditor\chunks\0_-10.write)");
+        // }
+
+        clearPayload();
+        buffer = std::move(encoded);
 
+        // buffer.clear();
+        // buffer.allocate(writer.tell());
+        // std::memcpy(buffer.data(), writer.data(), writer.size());
+        chunkHeader.setDecSize(buffer.size());
+
+        if (!chunkHeader.isZipCompressed()) {
+            int status = ensureCompressed(outConsole);
+            if (status != SUCCESS) {
+                return;
+            }
+        }
+    }
+
+
+    Buffer ChunkManager::encodeChunkData() const {
+        DataWriter writer;
         switch (chunkData->lastVersion) {
             case chunk::eChunkVersion::V_UNVERSIONED:
             case chunk::eChunkVersion::V_NBT:
@@ -134,47 +271,74 @@ namespace editor {
                 exit(-1);
             default:;
         }
+        return writer.take();
+    }
 
-        // if (chunkData->chunkX == 0 && chunkData->chunkZ == -10) {
-        //     managerOut.writeToFile(R"(C:\Users\jerrin\CLionProjects\LegacyEditor\chunks\0_-10.write)");
-        // }
-
-        buffer = std::move(writer.take());
 
-        // buffer.clear();
-        // buffer.allocate(writer.tell());
-        // std::memcpy(buffer.data(), writer.data(), writer.size());
-        chunkHeader.setDecSize(buffer.size());
+    /**
+     * Same decisions as writeChunk() followed by ensureCompressed(), made on `out`:
+     * modified or never compressed chunk data is re-encoded, otherwise the decompressed
+     * payload is recompressed or the original bytes are reused. `out` only views this
+     * chunk's payload until it is compressed, so this chunk must outlive that call.
+     */
+    int ChunkManager::encodedCopy(const lce::CONSOLE outConsole, ChunkManager& out) const {
+        if (chunkHeader.isZipCompressed()) {
+            return SUCCESS;
+        }
 
-        if (!chunkHeader.isZipCompressed()) {
-            int status = ensureCompressed(outConsole);
-            if (status != SUCCESS) {
-                return;
-            }
+        out.clearPayload();
+        out.releaseOriginal();
+        out.chunkHeader = chunkHeader;
+        if (chunkData != nullptr && (isDirty() || !hasOriginal())) {
+            out.buffer = encodeChunkData();
+            out.chunkHeader.setDecSize(out.buffer.size());
+        } else {
+            out.m_backing = m_backing;
+            out.m_view = payload();
+            out.m_originalBacking = m_originalBacking;
+            out.m_original = m_original;
+            out.m_originalHeader = m_originalHeader;
+            out.m_originalConsole = m_originalConsole;
         }
+        return out.ensureCompressed(outConsole);
     }
 
 
     // TODO: rewrite to return status
     int ChunkManager::ensureDecompress(lce::CONSOLE console) {
         if (chunkHeader.isZipCompressed() == 0U
-            || buffer.empty()) {
+            || empty()) {
             return SUCCESS;
         }
 
+        // decompresses straight out of the shared region buffer when possible
+        c_auto compressed = payload();
+        c_bool isRLE = chunkHeader.isRLECompressed() == 1U;
+
+        // the zlib output of an RLE chunk only lives until it is decoded,
+        // so it goes into a scratch buffer that every chunk on this thread reuses
+        thread_local std::vector<u8> t_rleScratch;
         Buffer decompressedZip;
-        if (chunkHeader.isRLECompressed()) {
-            decompressedZip.allocate(chunkHeader.getRLESize());
+        u8* zipData;
+        u32 zipSize;
+        if (isRLE) {
+            if (t_rleScratch.size() < chunkHeader.getRLESize()) {
+                t_rleScratch.resize(chunkHeader.getRLESize());
+            }
+            zipData = t_rleScratch.data();
+            zipSize = chunkHeader.getRLESize();
         } else {
             decompressedZip.allocate(chunkHeader.getDecSize());
+            zipData = decompressedZip.data();
+            zipSize = decompressedZip.size();
         }
 
 
         int result = SUCCESS;
         switch (console) {
             case lce::CONSOLE::XBOX360: {
-                codec::XmemErr err = codec::XDecompress(buffer.data(), buffer.size(),
-                                                        decompressedZip.data(), decompressedZip.size_ptr());
+                codec::XmemErr err = codec::XDecompress(compressed.data(), compressed.size(),
+                                                        zipData, &zipSize);
                 if (err != codec::XmemErr::Ok) {
                     result = -1;
                 }
@@ -182,9 +346,9 @@ namespace editor {
             }
             case lce::CONSOLE::RPCS3:
             case lce::CONSOLE::PS3: {
-                result = tinf_uncompress(
-                        decompressedZip.data(), decompressedZip.size_ptr(),
-                        buffer.data(), buffer.size());
+                result = codec::inflateRaw(
+                        compressed.data(), compressed.size(),
+                        zipData, &zipSize);
                 break;
             }
             case lce::CONSOLE::SWITCH:
@@ -193,9 +357,9 @@ namespace editor {
             case lce::CONSOLE::PS4:
             case lce::CONSOLE::XBOX1:
             case lce::CONSOLE::WINDURANGO:
-                result = tinf_zlib_uncompress(
-                        decompressedZip.data(), decompressedZip.size_ptr(),
-                        buffer.data(), buffer.size());
+                result = codec::inflateZlib(
+                        compressed.data(), compressed.size(),
+                        zipData, &zipSize);
                 break;
             default:
                 break;
@@ -203,21 +367,23 @@ namespace editor {
         if (result != SUCCESS) {
             return STATUS::DECOMPRESS;
         }
-        chunkHeader.setZipCompressed(0U);
-
 
-        if (chunkHeader.isRLECompressed() == 1U) {
-            buffer.clear();
-            buffer.allocate(chunkHeader.getDecSize());
-            // TODO: why is this crashing, what did I do
-            codec::RLE_decompress(decompressedZip.data(), decompressedZip.size(),
-                                  buffer.data(), buffer.size_ref());
+        // decoded straight into the final buffer, before the chunk changes so a bad payload leaves it as it was
+        if (isRLE) {
+            decompressedZip.allocate(chunkHeader.getDecSize());
+            if (!codec::RLE_decompress(zipData, zipSize, decompressedZip.data(), decompressedZip.size_ref())) {
+                return STATUS::DECOMPRESS;
+            }
             chunkHeader.setRLECompressed(0U);
-            decompressedZip.clear();
         } else {
-            buffer = std::move(decompressedZip);
+            *decompressedZip.size_ptr() = zipSize;
         }
 
+        keepOriginal(console);
+        chunkHeader.setZipCompressed(0U);
+        clearPayload();
+        buffer = std::move(decompressedZip);
+
         return result;
     }
 
@@ -226,18 +392,25 @@ namespace editor {
     int ChunkManager::ensureCompressed(const lce::CONSOLE console) {
         if (chunkHeader.isZipCompressed() != 0U
             || console == lce::CONSOLE::NONE
-            || buffer.empty()) {
+            || empty()) {
             return SUCCESS;
         }
+        if (restoreOriginal(console)) {
+            return SUCCESS;
+        }
+        materialize();
 
         chunkHeader.setZipCompressed(1U);
         chunkHeader.setDecSize(buffer.size());
 
 
         if (chunkHeader.isRLECompressed() == 0U) {
+            // a lone 255 grows to two bytes, so the input size alone may not fit
             Buffer rleBuffer;
-            rleBuffer.allocate(buffer.size());
-            codec::RLE_compress(buffer.data(), buffer.size(), rleBuffer.data(), rleBuffer.size_ref());
+            rleBuffer.allocate(codec::RLE_compressBound(buffer.size()));
+            if (!codec::RLE_compress(buffer.data(), buffer.size(), rleBuffer.data(), rleBuffer.size_ref())) {
+                return COMPRESS;
+            }
             buffer = std::move(rleBuffer);
 
             chunkHeader.setRLESize(buffer.size());
@@ -248,47 +421,32 @@ namespace editor {
         int status = INVALID_CONSOLE;
         switch (console) {
             case lce::CONSOLE::XBOX360:
-                printf("trying to write xbox360 chunk with ChunkManager::ensureCompressed, "
-                       "not supported yet\n");
-                // TODO: leaks memory
-                // XCompress(comp_ptr, comp_size, data_ptr, data_size);
+                status = codec::XCompress(buffer.span(), buffer);
+                if (status != SUCCESS) {
+                    printf("error has occurred compressing chunk\n");
+                }
                 break;
 
             case lce::CONSOLE::PS3:
-            case lce::CONSOLE::RPCS3: {
-                Buffer compressed(buffer.size());
-                status = compress(compressed.data(), (uLongf*) compressed.size_ptr(),
-                                  buffer.data(), buffer.size());
-                buffer.clear();
-                if (status != 0) {
+            case lce::CONSOLE::RPCS3:
+                status = codec::deflateWithContext(buffer.span(), codec::eDeflateFormat::ZLIB_NO_HEADER, buffer);
+                if (status != SUCCESS) {
                     printf("error has occurred compressing chunk\n");
-                    return MALLOC_FAILED;
                 }
-                // copy it over, and remove ZLIB header
-                buffer = Buffer(compressed.size() - 2);
-                std::memcpy(buffer.data(), compressed.data() + 2, buffer.size());
-                // zero out ending integrity check, as the console does
-                // std::memset(data + comp_size - 6, 0, 4);
                 break;
-            }
 
             case lce::CONSOLE::SWITCH:
             case lce::CONSOLE::PS4:
             case lce::CONSOLE::WIIU:
             case lce::CONSOLE::VITA:
             case lce::CONSOLE::XBOX1:
-            case lce::CONSOLE::WINDURANGO: {
-                Buffer compressed((u32)(float(buffer.size()) * 1.25F));
-                status = compress(compressed.data(), (uLongf*) compressed.size_ptr(),
-                                  buffer.data(), buffer.size());
-                buffer.clear();
-                if (status != 0) {
+            case lce::CONSOLE::WINDURANGO:
+                status = codec::deflateWithContext(buffer.span(), codec::eDeflateFormat::ZLIB, buffer);
+                if (status != SUCCESS) {
                     printf("error has occurred compressing chunk\n");
-                    return MALLOC_FAILED;
                 }
-                buffer = std::move(compressed);
                 break;
-            }
+
             default:
                 break;
         }
@@ -297,30 +455,41 @@ namespace editor {
     }
 
 
-    void ChunkManager::setVariableFlags(c_u32 sizeIn) {
+    u32 ChunkManager::setVariableFlags(c_u32 sizeIn) {
         chunkHeader.setRLECompressed(sizeIn >> 31);
         chunkHeader.setNewSaveFlag((sizeIn >> 30) & 1);
-        *buffer.size_ptr() = sizeIn & 0x3FFFFFFF;
+        return sizeIn & 0x3FFFFFFF;
     }
 
 
     u32 ChunkManager::getSizeForWriting() const {
-        u32 sizeOut = buffer.size();
+        u32 sizeOut = payloadSize();
         if (chunkHeader.isRLECompressed() != 0U) { sizeOut |= 0x80000000; }
         if (chunkHeader.getNewSaveFlag() != 0U) { sizeOut |= 0x40000000; }
         return sizeOut;
     }
 
 
+    /// copies the payload into this chunk's own buffer
     int ChunkManager::read(DataReader& reader, lce::CONSOLE console) {
-        setVariableFlags(reader.read<u32>());
-        bool status = buffer.allocate(buffer.size());
-        if (!status) {
-            printf("Failed to allocate %d bytes for chunk", buffer.size());
-            return STATUS::MALLOC_FAILED;
+        int status = read(reader, console, nullptr);
+        if (status != SUCCESS) {
+            return status;
         }
-        // TODO: is this needed
-        std::memset(buffer.data(), 0, buffer.size());
+        materialize();
+        return SUCCESS;
+    }
+
+
+    /**
+     * Reads the chunk header and keeps a view of the payload inside the reader's buffer.
+     * @param backing owner of the reader's memory; the chunk holds a reference to it until
+     *                it is decompressed, modified or cleared. When null, the reader's memory
+     *                must outlive the view, so callers should materialize() before returning.
+     */
+    int ChunkManager::read(DataReader& reader, lce::CONSOLE console,
+                           const std::shared_ptr<const Buffer>& backing) {
+        c_u32 payloadSize = setVariableFlags(reader.read<u32>());
 
         switch (console) {
             case lce::CONSOLE::PS3:
@@ -335,12 +504,19 @@ namespace editor {
                 chunkHeader.setRLESize(dec_and_rle_size);
                 break;
         }
-        std::memcpy(buffer.data(), reader.ptr(), buffer.size());
+        if (!reader.canRead(payloadSize)) {
+            printf("chunk payload of %u bytes goes outside file\n", payloadSize);
+            return STATUS::INVALID_SAVE;
+        }
+
+        buffer.clear();
+        m_backing = backing;
+        m_view = std::span(reader.ptr(), payloadSize);
         return SUCCESS;
     }
 
 
-    int ChunkManager::write(DataWriter& writer, lce::CONSOLE console) {
+    int ChunkManager::write(DataWriter& writer, lce::CONSOLE console) const {
         writer.write<u32>(getSizeForWriting());
         switch (console) {
             case lce::CONSOLE::PS3:
@@ -352,7 +528,8 @@ namespace editor {
                 writer.write<u32>(chunkHeader.getDecSize());
                 break;
         }
-        writer.writeBytes(buffer.data(), buffer.size());
+        c_auto data = payload();
+        writer.writeBytes(data.data(), data.size());
         return SUCCESS;
     }
 
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory>
+#include <span>
+
 #include "include/lce/enums.hpp"
 
 #include "common/error_status.hpp"
@@ -11,6 +14,23 @@
 namespace editor {
 
 
+    /// outer compression used for chunk payloads, the decompressed payload is the same on every console
+    enum class eChunkCodec : u8 {
+        NONE,
+        LZX,         // XBOX360
+        PS3_DEFLATE, // PS3, RPCS3: zlib stream without its 2-byte header, separate RLE size in the header
+        ZLIB,        // WIIU, VITA, SWITCH, PS4, XBOX1, WINDURANGO
+    };
+
+    ND eChunkCodec getChunkCodec(lce::CONSOLE console);
+
+    /// true if compressed chunk payloads from one console can be written as-is for the other
+    ND inline bool isSameChunkCodec(const lce::CONSOLE consoleA, const lce::CONSOLE consoleB) {
+        c_auto codec = getChunkCodec(consoleA);
+        return codec != eChunkCodec::NONE && codec == getChunkCodec(consoleB);
+    }
+
+
     class ChunkManager {
     public:
         struct ChunkHeader {
@@ -42,10 +62,26 @@ namespace editor {
             MU void setZipCompressed(c_u64 val) { isCompressedZip = val; }
         };
 
+        /// owned payload, only allocated once the chunk is decompressed or modified
         Buffer buffer;
         ChunkHeader chunkHeader;
+        /// taken from chunk::ChunkDataPool on the first readChunk, null until then
         chunk::ChunkData* chunkData = nullptr;
 
+    private:
+        /// region file shared by every chunk read from it, kept alive until all views are released
+        std::shared_ptr<const Buffer> m_backing;
+        /// compressed payload inside m_backing, only used while buffer is empty
+        std::span<const u8> m_view;
+
+        /// compressed bytes as they were read, so an unmodified chunk can be written back verbatim
+        std::shared_ptr<const Buffer> m_originalBacking;
+        std::span<const u8> m_original;
+        ChunkHeader m_originalHeader;
+        lce::CONSOLE m_originalConsole = lce::CONSOLE::NONE;
+
+    public:
+
         MU ND std::string getDataAsString() const {
             std::string result;
             result += "__timestamp_" + std::to_string(chunkHeader.timestamp) + "___";
@@ -65,17 +101,34 @@ namespace editor {
         ChunkManager(ChunkManager&& other) noexcept
             : buffer(std::move(other.buffer)),
               chunkHeader(other.chunkHeader),
-              chunkData(other.chunkData) {
+              chunkData(other.chunkData),
+              m_backing(std::move(other.m_backing)),
+              m_view(other.m_view),
+              m_originalBacking(std::move(other.m_originalBacking)),
+              m_original(other.m_original),
+              m_originalHeader(other.m_originalHeader),
+              m_originalConsole(other.m_originalConsole) {
             other.chunkHeader = ChunkHeader();
             other.chunkData = nullptr;
+            other.m_view = {};
+            other.m_original = {};
         }
 
         ChunkManager& operator=(ChunkManager&& other) noexcept {
             if (this != &other) {
+                releaseChunkData();
                 buffer = std::move(other.buffer);
                 chunkHeader = other.chunkHeader;
                 chunkData = other.chunkData;
+                m_backing = std::move(other.m_backing);
+                m_view = other.m_view;
+                m_originalBacking = std::move(other.m_originalBacking);
+                m_original = other.m_original;
+                m_originalHeader = other.m_originalHeader;
+                m_originalConsole = other.m_originalConsole;
                 other.chunkData = nullptr;
+                other.m_view = {};
+                other.m_original = {};
             }
             return *this;
         }
@@ -83,6 +136,36 @@ namespace editor {
         ChunkManager(const ChunkManager&) = delete;
         ChunkManager& operator=(const ChunkManager&) = delete;
 
+        /// PAYLOAD
+
+        /// the current payload, either the owned buffer or the view into the region file
+        ND std::span<const u8> payload() const {
+            return buffer.empty() ? m_view : buffer.span();
+        }
+        ND u32 payloadSize() const { return static_cast<u32>(payload().size()); }
+        ND bool empty() const { return buffer.empty() && m_view.empty(); }
+        ND bool isShared() const { return buffer.empty() && !m_view.empty(); }
+
+        /// copies a shared view into this chunk's own buffer and drops the backing reference
+        void materialize();
+        /// drops the owned buffer and any shared view
+        void clearPayload();
+
+        /// estimated heap usage, shared views count their own span of the region buffer
+        ND u64 getMemoryUsage() const;
+
+        /// true if the chunk has been decoded into valid chunk data
+        ND bool isValidChunk() const { return chunkData != nullptr && chunkData->validChunk; }
+        /// returns the chunk data to the pool
+        void releaseChunkData();
+
+        /// true if the chunk data was modified since it was read
+        ND bool isDirty() const;
+        /// true if the original compressed bytes are still held
+        ND bool hasOriginal() const { return !m_original.empty(); }
+        /// drops the original compressed bytes, the next write re-encodes the chunk
+        void releaseOriginal();
+
         /// FUNCTIONS
 
         MU ND int checkVersion() const;
@@ -91,12 +174,24 @@ namespace editor {
         int ensureCompressed(lce::CONSOLE console);
 
         MU int read(DataReader& reader, lce::CONSOLE console);
-        MU int write(DataWriter& writer, lce::CONSOLE console);
+        MU int read(DataReader& reader, lce::CONSOLE console,
+                    const std::shared_ptr<const Buffer>& backing);
+        MU int write(DataWriter& writer, lce::CONSOLE console) const;
 
         MU void readChunk(lce::CONSOLE inConsole);
         MU void writeChunk(lce::CONSOLE outConsole);
 
-        void setVariableFlags(u32 sizeIn);
+        /// fills `out` with what writeChunk() and ensureCompressed() would turn this chunk into,
+        /// leaving this chunk decoded; does nothing for chunks that are already compressed
+        int encodedCopy(lce::CONSOLE outConsole, ChunkManager& out) const;
+
+    private:
+        ND Buffer encodeChunkData() const;
+        void keepOriginal(lce::CONSOLE console);
+        bool restoreOriginal(lce::CONSOLE console);
+
+    public:
+        ND u32 setVariableFlags(u32 sizeIn);
         ND u32 getSizeForWriting() const;
     };
 
@@ -1,5 +1,8 @@
 #include "Region.hpp"
 
+#include <atomic>
+#include <stdexcept>
+
 #include "include/lce/processor.hpp"
 
 #include "code/LCEFile/LCEFile.hpp"
@@ -8,6 +11,7 @@
 #include "common/data/DataReader.hpp"
 #include "common/data/DataWriter.hpp"
 #include "common/RLE/rle_nsxps4.hpp"
+#include "code/threaded.hpp"
 
 
 namespace {
@@ -24,7 +28,7 @@ namespace editor {
         if (!inRange(x, z, m_regScale)) return false;
 
         ChunkManager* src = getChunk(x, z);
-        if (!src || src->buffer.empty()) return false;
+        if (!src || src->empty()) return false;
 
         out = std::move(*src);
         *src = ChunkManager{};
@@ -57,16 +61,33 @@ namespace editor {
     }
 
 
+    /**
+     * Recompresses every chunk for consoleIn. Chunks that are still compressed with
+     * the same codec the target uses are left untouched, only their header gets
+     * rewritten by write().
+     */
     void Region::convertChunks(lce::CONSOLE consoleIn) {
+        c_bool passthrough = isSameChunkCodec(m_console, consoleIn);
         MU int index = 0;
         for (auto& chunk: m_chunks) {
-            if (chunk.buffer.empty()) continue;
+            if (chunk.empty()) continue;
+            if (passthrough && chunk.chunkHeader.isZipCompressed()) continue;
 
             chunk.ensureDecompress(m_console);
             chunk.ensureCompressed(consoleIn);
 
             index++;
         }
+        m_console = consoleIn;
+    }
+
+
+    u64 Region::getMemoryUsage() const {
+        u64 total = sizeof(Region) + m_chunks.capacity() * sizeof(ChunkManager);
+        for (const ChunkManager& chunk : m_chunks) {
+            total += chunk.getMemoryUsage();
+        }
+        return total;
     }
 
 
@@ -79,7 +100,7 @@ namespace editor {
 
     MU ChunkManager* Region::getNonEmptyChunk() {
         for (auto& chunk: m_chunks) {
-            if (!chunk.buffer.empty()) {
+            if (!chunk.empty()) {
                 return &chunk;
             }
         }
@@ -92,41 +113,49 @@ namespace editor {
      * step 2: read timestamps [CHUNK_COUNT]
      * step 3: read chunk size, decompressed size
      * step 4: read chunk info
-     * step 5: allocates memory for the chunk
-     * step 6: set chunk's decompressed size attribute
-     * step 7: each chunk gets its own memory
+     * step 5: set chunk's decompressed size attribute
+     * step 6: each chunk keeps a view into the shared file buffer,
+     *         and only gets its own memory once decompressed or modified
      * @param fileIn
      */
     int Region::read(const LCEFile* fileIn) {
+        return read(fileIn, fileIn->getContents());
+    }
+
+
+    int Region::read(const LCEFile* fileIn, const FileContents& contents) {
+        std::shared_ptr<const Buffer> backing = contents.owner;
+        std::span<const u8> data = contents.data;
 
-        Buffer buffer = fileIn->getBuffer();
+        // set before anything is read, so an empty file still gives an empty region at its coordinates
+        m_regX = fileIn->getRegionX();
+        m_regZ = fileIn->getRegionZ();
+        m_console = fileIn->m_console;
 
         // new gen stuff
         if (fileIn->isTinyRegionType()) {
-            DataReader reader(buffer.data(), buffer.size(), Endian::Little);
+            DataReader reader(data.data(), data.size(), Endian::Little);
             if (reader.size() == 0) { return SUCCESS; }
 
             c_u32 fileSize = reader.read<u32>();
             Buffer decomp(fileSize);
-            codec::RLE_NSX_OR_PS4_DECOMPRESS(reader.ptr(), reader.size() - 4,
-                                             decomp.data(), decomp.size());
-            buffer = std::move(decomp);
+            if (codec::RLE_NSX_OR_PS4_DECOMPRESS(reader.ptr(), reader.size() - 4,
+                                                 decomp.data(), decomp.size()) == 0 && fileSize != 0) {
+                return printf_err(DECOMPRESS, "failed to decompress \"%s\"\n", fileIn->getFileName().string().c_str());
+            }
+            backing = std::make_shared<const Buffer>(std::move(decomp));
+            data = backing->span();
         }
 
 
-        if (buffer.empty()) {
+        if (data.empty()) {
             return SUCCESS;
         }
 
         // DataWriter::writeFile(R"(C:\Users\jerrin\CLionProjects\LegacyEditor\build\)" + fileIn->getFileName(),
         //                       fileIn->m_data.span());
 
-        m_regX = fileIn->getRegionX();
-        m_regZ = fileIn->getRegionZ();
-
-        m_console = fileIn->m_console;
-
-        c_u32 totalSectors = buffer.size() / SECTOR_BYTES + 1;
+        c_u32 totalSectors = data.size() / SECTOR_BYTES + 1;
 
         size_t chunkIndex;
         std::vector<u8> sectors;
@@ -134,7 +163,7 @@ namespace editor {
         sectors.resize(CHUNK_COUNT);
         locations.resize(CHUNK_COUNT);
 
-        DataReader reader(buffer.data(), buffer.size(), getConsoleEndian(m_console));
+        DataReader reader(data.data(), data.size(), getConsoleEndian(m_console));
 
 
         reader.skip<0x2000>();
@@ -158,40 +187,111 @@ namespace editor {
             // read chunk
             ChunkManager& chunk = m_chunks[chunkIndex];
             reader.seek(SECTOR_BYTES * locations[chunkIndex]);
-            chunk.read(reader, m_console);
+            if (chunk.read(reader, m_console, backing) != SUCCESS) {
+                throw std::runtime_error("Region::read error\n");
+            }
         }
         return SUCCESS;
     }
 
 
     /**
-     * step 1: make sure all chunks are compressed correctly
-     * step 2: recalculate sectorCount of each chunk
-     * step 3: calculate chunk offsets for each chunk
-     * step 4: allocate memory and create buffer
-     * step 5: write each chunk offset
-     * step 6: write each chunk m_timestamp
-     * step 7: seek to each location, write chunk attr's, then chunk data
+     * Chunks are independent, so encoding and compression run in any order across threads.
+     * Chunks that are already compressed are skipped, so write() does not redo the work.
+     */
+    void Region::compressChunks(const lce::CONSOLE consoleIn, c_u32 threadCount) {
+        std::vector<u32> nonEmpty;
+        nonEmpty.reserve(CHUNK_COUNT);
+        for (u32 chunkIndex = 0; chunkIndex < CHUNK_COUNT; chunkIndex++) {
+            if (!m_chunks[chunkIndex].empty()) {
+                nonEmpty.push_back(chunkIndex);
+            }
+        }
+        parallel_for(nonEmpty.size(), [&](const size_t i) {
+            ChunkManager& chunk = m_chunks[nonEmpty[i]];
+            chunk.writeChunk(consoleIn);
+            chunk.ensureCompressed(consoleIn);
+        }, threadCount);
+    }
+
+
+    /**
+     * step 1: make sure all chunks are compressed correctly, see compressChunks()
+     * step 2: lay the chunks out in sectors, see layoutChunks()
      * @param consoleIn
+     * @param threadCount threads used for step 1, 0 picks the default
      * @return
      */
-    Buffer Region::write(const lce::CONSOLE consoleIn) {
+    Buffer Region::write(const lce::CONSOLE consoleIn, c_u32 threadCount) {
+        compressChunks(consoleIn, threadCount);
+
+        std::vector<const ChunkManager*> chunks(CHUNK_COUNT);
+        for (u32 chunkIndex = 0; chunkIndex < CHUNK_COUNT; chunkIndex++) {
+            chunks[chunkIndex] = &m_chunks[chunkIndex];
+        }
+        return layoutChunks(chunks, consoleIn);
+    }
+
+
+    /**
+     * Chunks that are not compressed yet are compressed into copies, which are only
+     * kept until the sectors are laid out; compressed chunks are written as they are.
+     * @throws std::runtime_error if a chunk fails to compress
+     */
+    Buffer Region::writeCopy(const lce::CONSOLE consoleIn, c_u32 threadCount) const {
+        std::vector<const ChunkManager*> chunks(CHUNK_COUNT);
+        std::vector<u32> decoded;
+        decoded.reserve(CHUNK_COUNT);
+        for (u32 chunkIndex = 0; chunkIndex < CHUNK_COUNT; chunkIndex++) {
+            const ChunkManager& chunk = m_chunks[chunkIndex];
+            chunks[chunkIndex] = &chunk;
+            if (!chunk.empty() && !chunk.chunkHeader.isZipCompressed()) {
+                decoded.push_back(chunkIndex);
+            }
+        }
+
+        std::vector<ChunkManager> copies(decoded.size());
+        std::atomic<int> status = SUCCESS;
+        parallel_for(decoded.size(), [&](const size_t i) {
+            if (c_int result = m_chunks[decoded[i]].encodedCopy(consoleIn, copies[i]); result != SUCCESS) {
+                status = result;
+            }
+        }, threadCount);
+        if (status != SUCCESS) {
+            throw std::runtime_error("Region::writeCopy failed to compress a chunk\n");
+        }
+
+        for (size_t i = 0; i < decoded.size(); i++) {
+            chunks[decoded[i]] = &copies[i];
+        }
+        return layoutChunks(chunks, consoleIn);
+    }
+
+
+    /**
+     * step 1: recalculate sectorCount of each chunk
+     * step 2: calculate chunk offsets for each chunk
+     * step 3: allocate memory and create buffer
+     * step 4: write each chunk offset
+     * step 5: write each chunk m_timestamp
+     * step 6: seek to each location, write chunk attr's, then chunk data
+     * @param chunks compressed chunks in region order
+     */
+    Buffer Region::layoutChunks(const std::vector<const ChunkManager*>& chunks, const lce::CONSOLE consoleIn) const {
         std::vector<u8> sectors;
         std::vector<u32> locations;
         sectors.resize(CHUNK_COUNT);
         locations.resize(CHUNK_COUNT);
 
-
+        // sector layout stays serial so the output matches regardless of thread count
         // 1: Sectors Block
         // 2: Locations Block
         int total_sectors = 2;
         for (u32 x = 0; x < 32; x++) {
             for (u32 z = 0; z < 32; z++) {
                 u32 chunkIndex = z * 32 + x;
-                if (ChunkManager& chunk = m_chunks[chunkIndex]; !chunk.buffer.empty()) {
-                    chunk.writeChunk(consoleIn);
-                    chunk.ensureCompressed(consoleIn);
-                    sectors[chunkIndex] = (chunk.buffer.size() + CHUNK_HEADER_SIZE) / SECTOR_BYTES + 1;
+                if (const ChunkManager& chunk = *chunks[chunkIndex]; !chunk.empty()) {
+                    sectors[chunkIndex] = (chunk.payloadSize() + CHUNK_HEADER_SIZE) / SECTOR_BYTES + 1;
                     locations[chunkIndex] = total_sectors;
                     total_sectors += sectors[chunkIndex];
                 }
@@ -202,7 +302,7 @@ namespace editor {
         DataWriter writer(data_size, getConsoleEndian(consoleIn));
 
 #ifndef DONT_MEMSET0
-        std::memset((void*) writer.data(), 0, writer.size());
+        std::memset((void*) writer.data(), 0, data_size);
 #endif
 
         u32 largestOffset = 0;
@@ -214,11 +314,11 @@ namespace editor {
                 u32 chunk_header = sectors[chunkIndex] | locations[chunkIndex] << 8;
                 writer.writeAtOffset<u32>(0x0 + chunkIndex * 4, chunk_header);
 
-                u32 chunk_timestamp = m_chunks[chunkIndex].chunkHeader.getTimestamp();
+                u32 chunk_timestamp = chunks[chunkIndex]->chunkHeader.getTimestamp();
                 writer.writeAtOffset<u32>(0x1000 + chunkIndex * 4, chunk_timestamp);
 
                 if (sectors[chunkIndex] != 0) {
-                    ChunkManager& chunk = m_chunks[chunkIndex];
+                    const ChunkManager& chunk = *chunks[chunkIndex];
                     writer.seek(locations[chunkIndex] * SECTOR_BYTES);
                     chunk.write(writer, consoleIn);
 
@@ -7,6 +7,7 @@
 
 namespace editor {
     class LCEFile;
+    struct FileContents;
 
     inline bool inRange(i32 x, i32 z, i32 scale) {
         return x >= 0 && x < scale && z >= 0 && z < scale;
@@ -62,10 +63,23 @@ namespace editor {
 
         MU void convertChunks(lce::CONSOLE consoleIn);
 
+        /// estimated heap usage of all chunks, used by RegionCache
+        ND u64 getMemoryUsage() const;
+
         /// READ AND WRITE
 
         int read(const LCEFile* fileIn);
-        Buffer write(lce::CONSOLE consoleIn);
+        /// same as above, with the file's contents already loaded, chunks keep views into contents.owner
+        int read(const LCEFile* fileIn, const FileContents& contents);
+
+        /// encodes and compresses every chunk for consoleIn, the first step of write()
+        void compressChunks(lce::CONSOLE consoleIn, u32 threadCount = 0);
+        Buffer write(lce::CONSOLE consoleIn, u32 threadCount = 0);
+        /// same output as write(), but compresses copies so decoded chunks stay decoded, used by RegionCache
+        ND Buffer writeCopy(lce::CONSOLE consoleIn, u32 threadCount = 0) const;
+
+    private:
+        ND Buffer layoutChunks(const std::vector<const ChunkManager*>& chunks, lce::CONSOLE consoleIn) const;
 
     };
 
@@ -1,4 +1,196 @@
 #include "RegionCache.hpp"
 
+#include <algorithm>
+#include <iterator>
+
+#include "code/LCEFile/LCEFile.hpp"
+#include "common/error_status.hpp"
+
 namespace editor {
-} // editor
\ No newline at end of file
+
+
+    size_t RegionCache::KeyHash::operator()(const Key& key) const noexcept {
+        size_t hash = std::hash<int>{}(static_cast<int>(key.dimension));
+        hash = hash * 31 + std::hash<i32>{}(key.regionX);
+        hash = hash * 31 + std::hash<i32>{}(key.regionZ);
+        return hash;
+    }
+
+
+    RegionCache::~RegionCache() {
+        try {
+            flush();
+        } catch (const std::exception& e) {
+            printf("RegionCache: failed to write back regions: %s\n", e.what());
+        }
+    }
+
+
+    RegionCache::Key RegionCache::makeKey(const LCEFile& file) {
+        return {file.m_fileType, file.getRegionX(), file.getRegionZ()};
+    }
+
+
+    Region* RegionCache::get(LCEFile& file) {
+        c_auto key = makeKey(file);
+        if (auto it = m_lookup.find(key); it != m_lookup.end()) {
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return &it->second->region;
+        }
+
+        Entry& entry = m_entries.emplace_front();
+        entry.key = key;
+        entry.file = &file;
+        try {
+            if (entry.region.read(&file) != SUCCESS) {
+                m_entries.pop_front();
+                return nullptr;
+            }
+        } catch (const std::exception& e) {
+            printf("RegionCache: failed to read %s: %s\n", file.path().string().c_str(), e.what());
+            m_entries.pop_front();
+            return nullptr;
+        }
+        m_lookup.emplace(key, m_entries.begin());
+
+        resize(entry);
+        if (evictToBudget() != SUCCESS) {
+            printf("RegionCache: kept regions that failed to write back, flush() retries them\n");
+        }
+        return &entry.region;
+    }
+
+
+    Region* RegionCache::find(const LCEFile& file) {
+        auto it = m_lookup.find(makeKey(file));
+        if (it == m_lookup.end()) { return nullptr; }
+        return &it->second->region;
+    }
+
+
+    int RegionCache::markDirty(const LCEFile& file) {
+        auto it = m_lookup.find(makeKey(file));
+        if (it == m_lookup.end()) { return SUCCESS; }
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        it->second->dirty = true;
+        resize(*it->second);
+        return evictToBudget();
+    }
+
+
+    int RegionCache::update(const LCEFile& file) {
+        auto it = m_lookup.find(makeKey(file));
+        if (it == m_lookup.end()) { return SUCCESS; }
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        resize(*it->second);
+        return evictToBudget();
+    }
+
+
+    int RegionCache::flush() {
+        int result = SUCCESS;
+        for (Entry& entry : m_entries) {
+            if (c_int status = writeBack(entry); status != SUCCESS) {
+                result = status;
+            }
+            resize(entry);
+        }
+        return result;
+    }
+
+
+    int RegionCache::erase(const LCEFile& file) {
+        auto it = m_lookup.find(makeKey(file));
+        if (it == m_lookup.end()) { return SUCCESS; }
+        auto entryIt = it->second;
+        if (c_int status = writeBack(*entryIt); status != SUCCESS) {
+            return status;
+        }
+        m_usage -= entryIt->bytes;
+        m_lookup.erase(it);
+        m_entries.erase(entryIt);
+        return SUCCESS;
+    }
+
+
+    int RegionCache::clear() {
+        int result = SUCCESS;
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (c_int status = writeBack(*it); status != SUCCESS) {
+                result = status;
+                resize(*it);
+                ++it;
+                continue;
+            }
+            m_usage -= it->bytes;
+            m_lookup.erase(it->key);
+            it = m_entries.erase(it);
+        }
+        return result;
+    }
+
+
+    int RegionCache::setBudget(c_u64 byteBudget) {
+        m_budget = byteBudget;
+        return evictToBudget();
+    }
+
+
+    bool RegionCache::isDirty(const Entry& entry) {
+        if (entry.dirty) { return true; }
+        return std::ranges::any_of(entry.region.m_chunks, [](const ChunkManager& chunk) {
+            return chunk.isDirty();
+        });
+    }
+
+
+    /**
+     * The chunks are compressed into copies, so the cached region stays decoded. Written
+     * chunks drop their original bytes and dirty flag; later writes re-encode their data.
+     */
+    int RegionCache::writeBack(Entry& entry) {
+        if (!isDirty(entry)) { return SUCCESS; }
+        try {
+            entry.file->setBuffer(entry.region.writeCopy(entry.file->m_console));
+        } catch (const std::exception& e) {
+            return printf_err(FILE_ERROR, "RegionCache: failed to write back %s: %s\n",
+                              entry.file->path().string().c_str(), e.what());
+        }
+        for (ChunkManager& chunk : entry.region.m_chunks) {
+            if (!chunk.isDirty()) { continue; }
+            chunk.releaseOriginal();
+            chunk.chunkData->dirty = false;
+        }
+        entry.dirty = false;
+        return SUCCESS;
+    }
+
+
+    void RegionCache::resize(Entry& entry) {
+        m_usage -= entry.bytes;
+        entry.bytes = entry.region.getMemoryUsage();
+        m_usage += entry.bytes;
+    }
+
+
+    /// the most recently used region is never evicted, so the caller's pointer stays valid;
+    /// a region that fails to write back is skipped and kept, and its status returned
+    int RegionCache::evictToBudget() {
+        int result = SUCCESS;
+        auto next = m_entries.end();
+        while (m_usage > m_budget && m_entries.size() > 1 && std::prev(next) != m_entries.begin()) {
+            auto victim = std::prev(next);
+            if (c_int status = writeBack(*victim); status != SUCCESS) {
+                result = status;
+                next = victim;
+                continue;
+            }
+            m_usage -= victim->bytes;
+            m_lookup.erase(victim->key);
+            m_entries.erase(victim);
+        }
+        return result;
+    }
+
+
+} // editor
@@ -1,17 +1,106 @@
 #pragma once
 
+#include <list>
+#include <unordered_map>
+
 #include "code/Region/Region.hpp"
 
 namespace editor {
 class LCEFile;
 
 
+/**
+ * Keeps decoded regions in memory between passes, so scripts that touch the same
+ * region file several times only pay for reading and decompressing it once.
+ * \n
+ * Regions are keyed by (dimension, regionX, regionZ) and evicted least recently used
+ * first once their estimated size goes over the byte budget. Dirty regions are written
+ * back through LCEFile::setBuffer when they are evicted, flushed, or the cache is destroyed.
+ * A region is dirty if any of its chunks is, or if it was passed to markDirty().
+ * Writing back compresses copies of the chunks, so cached chunks stay decoded, and a
+ * region that fails to write back stays cached instead of losing its changes.
+ * \n
+ * Pointers returned by get() stay valid until the region is evicted, which can happen
+ * on any later call that loads or resizes a different region.
+ * \n
+ * Conversions that visit each region once stream them through RegionPipeline instead.
+ */
 class RegionCache {
 public:
-    RegionCache() = default;
+    struct Key {
+        lce::FILETYPE dimension = lce::FILETYPE::NONE;
+        i32 regionX = 0;
+        i32 regionZ = 0;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    static constexpr u64 DEFAULT_BUDGET = 256ULL * 1024 * 1024;
+
+private:
+    struct KeyHash {
+        size_t operator()(const Key& key) const noexcept;
+    };
+
+    struct Entry {
+        Key key;
+        LCEFile* file = nullptr;
+        Region region;
+        u64 bytes = 0;
+        bool dirty = false;
+    };
+
+    /// front is the most recently used region
+    std::list<Entry> m_entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_lookup;
+    u64 m_budget;
+    u64 m_usage = 0;
+
+public:
+    explicit RegionCache(u64 byteBudget = DEFAULT_BUDGET) : m_budget(byteBudget) {}
+    ~RegionCache();
+
+    RegionCache(const RegionCache&) = delete;
+    RegionCache& operator=(const RegionCache&) = delete;
 
+    ND static Key makeKey(const LCEFile& file);
 
+    /// Returns the decoded region of the file, reading it on a miss.
+    /// Returns nullptr if the file could not be read.
+    /// Regions that fail to write back while making room stay cached, see flush().
+    Region* get(LCEFile& file);
+
+    /// Returns the cached region of the file without reading it.
+    MU ND Region* find(const LCEFile& file);
+
+    /// Marks the region as modified and refreshes its size estimate. Edited chunk data is
+    /// picked up on its own, this is for changes chunks do not track, like inserting chunks.
+    /// Returns the status of any eviction it caused.
+    int markDirty(const LCEFile& file);
+
+    /// Refreshes the size estimate of a region after decoding or editing chunks.
+    /// Returns the status of any eviction it caused.
+    MU int update(const LCEFile& file);
+
+    /// Writes back every dirty region, keeping them cached.
+    int flush();
+
+    /// Writes back the region if dirty, then drops it. It is kept if it fails to write back.
+    MU int erase(const LCEFile& file);
+
+    /// Writes back every dirty region, then drops everything that was written back.
+    MU int clear();
+
+    MU int setBudget(u64 byteBudget);
+    MU ND u64 getBudget() const { return m_budget; }
+    MU ND u64 getUsage() const { return m_usage; }
+    MU ND size_t size() const { return m_entries.size(); }
+
+private:
+    ND static bool isDirty(const Entry& entry);
+    static int writeBack(Entry& entry);
+    void resize(Entry& entry);
+    int evictToBudget();
 };
 
 } // editor
-
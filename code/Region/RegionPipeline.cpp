@@ -0,0 +1,93 @@
+#include "RegionPipeline.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+#include "code/Chunk/chunkDataPool.hpp"
+#include "code/LCEFile/LCEFile.hpp"
+#include "code/Region/Region.hpp"
+#include "code/pipeline.hpp"
+#include "code/threaded.hpp"
+
+
+namespace editor {
+
+
+    RegionPipeline::RegionPipeline(const RegionPipelineSettings& settings) : m_settings(settings) {
+        if (m_settings.memoryBudget == 0) { m_settings.memoryBudget = DEFAULT_MEMORY_BUDGET; }
+        if (m_settings.ioThreads == 0) { m_settings.ioThreads = 1; }
+        if (m_settings.decodeThreads == 0) { m_settings.decodeThreads = 1; }
+        if (m_settings.transformThreads == 0) { m_settings.transformThreads = 1; }
+        if (m_settings.encodeThreads == 0) { m_settings.encodeThreads = 1; }
+    }
+
+
+    void RegionPipeline::run(const std::vector<LCEFile*>& files, const lce::CONSOLE consoleOut,
+                             const bool decodeChunks, const Transform& transform) const {
+        struct Item {
+            LCEFile* file = nullptr;
+            /// the file's contents after read, shared with the file while it is in memory
+            FileContents contents;
+            /// the new contents after layout
+            Buffer buffer;
+            std::unique_ptr<Region> region;
+        };
+
+        c_u32 capacity = m_settings.queueCapacity;
+        u32 maxInFlight = m_settings.maxInFlight;
+        if (maxInFlight == 0) {
+            c_u64 regionBytes = decodeChunks ? DECODED_REGION_BYTES : REGION_BYTES;
+            maxInFlight = static_cast<u32>(std::clamp<u64>(m_settings.memoryBudget / regionBytes, 1, 64));
+        }
+        Pipeline<Item> pipeline(maxInFlight);
+
+        pipeline.addStage({"read", [](Item& item) {
+            item.contents = item.file->getContents();
+        }, m_settings.ioThreads, capacity});
+
+        pipeline.addStage({"decode", [decodeChunks](Item& item) {
+            item.region = std::make_unique<Region>();
+            Region& region = *item.region;
+            // an empty region would reach the write stage and replace the file, stop instead
+            if (region.read(item.file, item.contents) != SUCCESS) {
+                throw std::runtime_error("failed to read region \"" + item.file->getFileName().string() + "\"");
+            }
+            item.contents = {};
+            if (!decodeChunks) { return; }
+            parallel_for(region.m_chunks.size(), [&region](const size_t i) {
+                region.m_chunks[i].readChunk(region.m_console);
+            });
+        }, m_settings.decodeThreads, capacity});
+
+        if (transform) {
+            pipeline.addStage({"transform", [&transform](Item& item) {
+                transform(*item.region);
+            }, m_settings.transformThreads, capacity});
+        }
+
+        pipeline.addStage({"encode", [consoleOut](Item& item) {
+            item.region->compressChunks(consoleOut);
+        }, m_settings.encodeThreads, capacity});
+
+        // the decoded region is dropped as soon as its file is built
+        pipeline.addStage({"layout", [consoleOut](Item& item) {
+            item.buffer = item.region->write(consoleOut);
+            item.region.reset();
+        }, 1, capacity});
+
+        pipeline.addStage({"write", [consoleOut](Item& item) {
+            item.file->setBuffer(std::move(item.buffer));
+            item.file->m_console = consoleOut;
+        }, 1, capacity, true});
+
+        pipeline.run(files.size(), [&files](const size_t index) {
+            return Item{files[index]};
+        });
+
+        // the pooled chunks were only needed while regions were in flight
+        chunk::ChunkDataPool::instance().trim();
+    }
+
+
+} // namespace editor
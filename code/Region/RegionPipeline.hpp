@@ -0,0 +1,76 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "include/lce/enums.hpp"
+#include "include/lce/processor.hpp"
+
+
+namespace editor {
+    class LCEFile;
+    class Region;
+
+
+    /**
+     * Threads and memory used by RegionPipeline, 0 picks a default.
+     * \n\n
+     * Decoding and encoding already spread the chunks of a region over the shared ThreadPool,
+     * so one thread per stage keeps every core busy; more threads only make sense for a
+     * transform that works on a single thread.
+     */
+    struct RegionPipelineSettings {
+        /// regions held in memory at once across every stage, defaults to what fits in memoryBudget
+        u32 maxInFlight = 0;
+        /// bytes the regions in flight may roughly take up, defaults to DEFAULT_MEMORY_BUDGET
+        u64 memoryBudget = 0;
+        /// threads reading region files, writing is always done by one thread in file order
+        u32 ioThreads = 1;
+        /// threads splitting regions into chunks and decoding them
+        u32 decodeThreads = 1;
+        /// threads running the caller's transform
+        u32 transformThreads = 1;
+        /// threads encoding and compressing chunks
+        u32 encodeThreads = 1;
+        /// regions that may wait in front of each stage
+        u32 queueCapacity = 2;
+    };
+
+
+    /**
+     * Converts region files with every step running at the same time on different regions:
+     * \n
+     * read -> decode -> transform -> encode -> layout -> write
+     * \n\n
+     * decode splits a file into chunks, undoing the outer RLE of new-gen regions, and
+     * with decodeChunks also reads every chunk into ChunkData. encode writes and compresses
+     * the chunks for consoleOut, layout builds the region file. Files are written back in
+     * the order they were given, with m_console set to consoleOut.
+     */
+    class RegionPipeline {
+        RegionPipelineSettings m_settings;
+
+    public:
+        using Transform = std::function<void(Region&)>;
+
+        static constexpr u64 DEFAULT_MEMORY_BUDGET = 1024ULL * 1024 * 1024;
+        /// a rough peak for one region in flight: its file, its chunks and the file built from them
+        static constexpr u64 REGION_BYTES = 16ULL * 1024 * 1024;
+        /// the same with all 1024 chunks decoded, about 320 KB each at V12
+        static constexpr u64 DECODED_REGION_BYTES = 1024ULL * 320 * 1024;
+
+        explicit RegionPipeline(const RegionPipelineSettings& settings = {});
+
+        /**
+         * @param files converted in place
+         * @param consoleOut console the files are written for
+         * @param decodeChunks decode every chunk before the transform runs
+         * @param transform edits a region, may be empty
+         * @throws std::runtime_error if a region cannot be read, files not written yet keep their contents
+         */
+        void run(const std::vector<LCEFile*>& files, lce::CONSOLE consoleOut,
+                 bool decodeChunks, const Transform& transform) const;
+    };
+
+
+} // namespace editor
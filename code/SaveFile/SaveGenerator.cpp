@@ -0,0 +1,451 @@
+#include "SaveGenerator.hpp"
+
+#include <array>
+
+#include "common/data/DataWriter.hpp"
+#include "common/RLE/rle_nsxps4.hpp"
+#include "common/error_status.hpp"
+
+#include "code/Chunk/chunkDataPool.hpp"
+#include "code/Chunk/helpers.hpp"
+#include "code/Chunk/v12.hpp"
+#include "code/LCEFile/LCEFile.hpp"
+#include "code/Region/Region.hpp"
+#include "code/SaveFile/SaveProject.hpp"
+#include "code/threaded.hpp"
+
+
+namespace editor {
+
+
+    namespace {
+
+        constexpr u16 BEDROCK = 7 << 4, STONE = 1 << 4, GRASS = 2 << 4, DIRT = 3 << 4, WATER = 9 << 4;
+
+        /// the most common underground blocks come first, so small palettes stay realistic
+        constexpr std::array<u16, 64> MATERIALS = [] {
+            std::array<u16, 64> materials{};
+            constexpr u16 FIRST[16] = {
+                    STONE, 1 << 4 | 1, 1 << 4 | 3, 1 << 4 | 5, DIRT, 13 << 4, 16 << 4, 15 << 4,
+                    1 << 4 | 2, 1 << 4 | 4, 1 << 4 | 6, 14 << 4, 21 << 4, 73 << 4, 56 << 4, 24 << 4};
+            for (int i = 0; i < 16; i++) {
+                materials[i] = FIRST[i];
+                materials[16 + i] = static_cast<u16>(35 << 4 | i);  // wool
+                materials[32 + i] = static_cast<u16>(159 << 4 | i); // stained terracotta
+                materials[48 + i] = static_cast<u16>(251 << 4 | i); // concrete
+            }
+            return materials;
+        }();
+
+        constexpr const char* ENTITY_IDS[6] = {"Cow", "Pig", "Sheep", "Zombie", "Skeleton", "Squid"};
+
+        constexpr u32 SALT_BLOCKS = 0x424C4B53;
+        constexpr u32 SALT_ENTITIES = 0x454E5449;
+        constexpr u32 SALT_TILES = 0x54494C45;
+
+        /// file listing versions written by the game alongside each chunk version
+        constexpr i32 SAVE_VERSION_ELYTRA = 10;
+        constexpr i32 SAVE_VERSION_AQUATIC = 11;
+
+
+        /// splitmix64 finalizer
+        u64 mix(u64 value) {
+            value += 0x9E3779B97F4A7C15ULL;
+            value = (value ^ value >> 30) * 0xBF58476D1CE4E5B9ULL;
+            value = (value ^ value >> 27) * 0x94D049BB133111EBULL;
+            return value ^ value >> 31;
+        }
+
+
+        u64 hashCoords(c_u64 seed, c_i32 x, c_i32 y, c_i32 z) {
+            u64 hash = mix(seed ^ static_cast<u32>(x));
+            hash = mix(hash ^ static_cast<u32>(y));
+            return mix(hash ^ static_cast<u32>(z));
+        }
+
+
+        i32 floorDiv(c_i32 value, c_i32 divisor) {
+            return value >= 0 ? value / divisor : (value - divisor + 1) / divisor;
+        }
+
+
+        /// bilinear value noise in [0, 255], integer only so every platform agrees
+        i32 valueNoise(c_u64 seed, c_i32 x, c_i32 z, c_i32 cell) {
+            c_i32 cellX = floorDiv(x, cell), cellZ = floorDiv(z, cell);
+            c_i32 tx = (x - cellX * cell) * 256 / cell;
+            c_i32 tz = (z - cellZ * cell) * 256 / cell;
+            auto corner = [&](c_i32 dx, c_i32 dz) {
+                return static_cast<i32>(hashCoords(seed, cellX + dx, 0, cellZ + dz) & 0xFF);
+            };
+            c_i32 top = corner(0, 0) * (256 - tx) + corner(1, 0) * tx;
+            c_i32 bottom = corner(0, 1) * (256 - tx) + corner(1, 1) * tx;
+            return (top * (256 - tz) + bottom * tz) >> 16;
+        }
+
+
+        /// true with the given probability
+        bool chance(std::mt19937& rng, const double probability) {
+            return static_cast<double>(rng()) < probability * 4294967296.0;
+        }
+
+
+        /// floor(density), plus one more with the remaining probability
+        int countFor(std::mt19937& rng, const double density) {
+            c_int whole = static_cast<int>(density);
+            return whole + (chance(rng, density - whole) ? 1 : 0);
+        }
+
+    } // namespace
+
+
+    SaveGenerator::SaveGenerator(const GeneratorSettings& settings) : m_settings(settings) {
+        m_settings.paletteSize = std::clamp(m_settings.paletteSize, 1U, 64U);
+        m_settings.worldChunks = std::max(m_settings.worldChunks, 1U);
+        if (lce::isConsoleNewGen(m_settings.console)) {
+            m_settings.chunkVersion = chunk::V_12;
+        }
+    }
+
+
+    std::mt19937 SaveGenerator::chunkRandom(c_i32 chunkX, c_i32 chunkZ, c_u32 salt) const {
+        return std::mt19937(static_cast<u32>(hashCoords(m_settings.seed ^ salt, chunkX, 0, chunkZ)));
+    }
+
+
+    i32 SaveGenerator::firstChunk() const {
+        return -static_cast<i32>(m_settings.worldChunks / 2);
+    }
+
+
+    i32 SaveGenerator::heightAt(c_i32 blockX, c_i32 blockZ) const {
+        switch (m_settings.terrain) {
+            case eTerrain::UNIFORM:
+                return 63;
+            case eTerrain::SUPERFLAT:
+                return 3;
+            case eTerrain::NOISY:
+            default:
+                return 48 + valueNoise(m_settings.seed, blockX, blockZ, 64) * 24 / 255
+                          + valueNoise(m_settings.seed + 1, blockX, blockZ, 16) * 8 / 255;
+        }
+    }
+
+
+    /**
+     * Every 4x4x4 grid walks a permutation of its 64 cells, so it holds exactly
+     * paletteSize distinct blocks no matter which grid it is.
+     */
+    u16 SaveGenerator::paletteBlock(c_i32 blockX, c_i32 blockY, c_i32 blockZ) const {
+        c_u32 cell = (blockX & 3) | (blockZ & 3) << 2 | (blockY & 3) << 4;
+        c_u32 gridHash = static_cast<u32>(hashCoords(m_settings.seed, blockX >> 2, blockY >> 2, blockZ >> 2));
+        return MATERIALS[((cell * 37 + gridHash) & 63) % m_settings.paletteSize];
+    }
+
+
+    void SaveGenerator::makeChunk(c_i32 chunkX, c_i32 chunkZ, chunk::ChunkData& chunkData) const {
+        std::mt19937 rng = chunkRandom(chunkX, chunkZ, SALT_BLOCKS);
+
+        chunk::ChunkV12(&chunkData).allocChunk();
+        chunkData.chunkX = chunkX;
+        chunkData.chunkZ = chunkZ;
+
+        for (int x = 0; x < 16; x++) {
+            for (int z = 0; z < 16; z++) {
+                c_i32 blockX = chunkX * 16 + x, blockZ = chunkZ * 16 + z;
+                c_i32 height = heightAt(blockX, blockZ);
+                c_i32 top = m_settings.terrain == eTerrain::NOISY ? std::max(height, SEA_LEVEL) : height;
+                chunkData.heightMap[z * 16 + x] = static_cast<u8>(top + 1);
+                chunkData.biomes[z * 16 + x] = 1;
+
+                for (int y = 0; y <= top; y++) {
+                    u16 block;
+                    if (m_settings.terrain == eTerrain::UNIFORM) {
+                        block = STONE;
+                    } else if (y == 0) {
+                        block = BEDROCK;
+                    } else if (m_settings.terrain == eTerrain::SUPERFLAT) {
+                        block = y < height ? DIRT : GRASS;
+                    } else if (y < height - 3) {
+                        block = paletteBlock(blockX, y, blockZ);
+                    } else if (y < height) {
+                        block = DIRT;
+                    } else if (y == height) {
+                        block = height >= SEA_LEVEL ? GRASS : DIRT;
+                    } else {
+                        block = WATER;
+                    }
+
+                    c_i32 index = chunk::toIndex<chunk::yXZy>(x, y, z);
+                    chunkData.newBlocks[index] = block;
+                    if (block != WATER && y <= SEA_LEVEL && chance(rng, m_settings.submergedRatio)) {
+                        chunkData.submerged[index] = WATER;
+                    }
+                }
+                for (int y = top + 1; y < 256; y++) {
+                    chunkData.skyLight.setNibble(chunk::toIndex<chunk::XZY>(x, y, z), 15);
+                }
+            }
+        }
+
+        chunkData.defaultNBT();
+        chunkData.entities = makeEntities(chunkX, chunkZ);
+        chunkData.tileEntities = makeTileEntities(chunkX, chunkZ);
+        chunkData.terrainPopulated = 1;
+        chunkData.lastVersion = chunk::V_12;
+        chunkData.validChunk = true;
+        chunkData.dirty = true;
+
+        if (m_settings.chunkVersion == chunk::V_11) {
+            chunkData.convertAquaticToElytra();
+        }
+    }
+
+
+    NBTBase SaveGenerator::makeEntities(c_i32 chunkX, c_i32 chunkZ) const {
+        std::mt19937 rng = chunkRandom(chunkX, chunkZ, SALT_ENTITIES);
+        NBTList entities(eNBT::COMPOUND);
+
+        c_int count = countFor(rng, m_settings.entityDensity);
+        for (int i = 0; i < count; i++) {
+            c_i32 x = chunkX * 16 + static_cast<i32>(rng() % 16);
+            c_i32 z = chunkZ * 16 + static_cast<i32>(rng() % 16);
+            c_i32 height = heightAt(x, z);
+            const double y = (m_settings.terrain == eTerrain::NOISY ? std::max(height, SEA_LEVEL) : height) + 1;
+            entities.push_back(makeCompound({
+                    {"id", makeString(ENTITY_IDS[rng() % 6])},
+                    {"Pos", makeList(eNBT::DOUBLE, {makeDouble(x + 0.5), makeDouble(y), makeDouble(z + 0.5)})},
+                    {"Motion", makeList(eNBT::DOUBLE, {makeDouble(0), makeDouble(-0.08), makeDouble(0)})},
+                    {"Rotation", makeList(eNBT::FLOAT, {makeFloat(static_cast<float>(rng() % 360)), makeFloat(0)})},
+                    {"Health", makeShort(static_cast<i16>(10 + rng() % 11))},
+                    {"OnGround", makeByte(1)},
+                    {"UUIDMost", makeLong(static_cast<i64>(static_cast<u64>(rng()) << 32 | rng()))},
+                    {"UUIDLeast", makeLong(static_cast<i64>(static_cast<u64>(rng()) << 32 | rng()))}
+            }));
+        }
+        return makeList(std::move(entities));
+    }
+
+
+    NBTBase SaveGenerator::makeTileEntities(c_i32 chunkX, c_i32 chunkZ) const {
+        std::mt19937 rng = chunkRandom(chunkX, chunkZ, SALT_TILES);
+        NBTList tileEntities(eNBT::COMPOUND);
+
+        c_int count = countFor(rng, m_settings.tileEntityDensity);
+        for (int i = 0; i < count; i++) {
+            NBTList items(eNBT::COMPOUND);
+            c_int itemCount = static_cast<int>(rng() % 27);
+            for (int slot = 0; slot < itemCount; slot++) {
+                items.push_back(makeCompound({
+                        {"id", makeShort(static_cast<i16>(1 + rng() % 400))},
+                        {"Count", makeByte(static_cast<u8>(1 + rng() % 64))},
+                        {"Damage", makeShort(0)},
+                        {"Slot", makeByte(static_cast<u8>(slot))}
+                }));
+            }
+            c_i32 x = chunkX * 16 + static_cast<i32>(rng() % 16);
+            c_i32 z = chunkZ * 16 + static_cast<i32>(rng() % 16);
+            tileEntities.push_back(makeCompound({
+                    {"id", makeString("Chest")},
+                    {"x", makeInt(x)},
+                    {"y", makeInt(static_cast<i32>(rng() % 48) + 1)},
+                    {"z", makeInt(z)},
+                    {"Items", makeList(std::move(items))}
+            }));
+        }
+        return makeList(std::move(tileEntities));
+    }
+
+
+    /**
+     * Builds the chunks of a width x width square starting at (firstX, firstZ)
+     * into region, skipping those outside the world.
+     * @param entitiesInChunks false for new-gen, where entities live in entities.dat
+     */
+    void SaveGenerator::fillRegion(Region& region, c_i32 firstX, c_i32 firstZ, c_i32 width,
+                                   c_bool entitiesInChunks) const {
+        c_i32 worldFirst = firstChunk();
+        c_i32 worldEnd = worldFirst + static_cast<i32>(m_settings.worldChunks);
+
+        std::vector<u32> indices;
+        for (i32 z = 0; z < width; z++) {
+            for (i32 x = 0; x < width; x++) {
+                if (firstX + x < worldFirst || firstX + x >= worldEnd ||
+                    firstZ + z < worldFirst || firstZ + z >= worldEnd) {
+                    continue;
+                }
+                indices.push_back(x + z * region.m_regScale);
+            }
+        }
+
+        parallel_for(indices.size(), [&](const size_t i) {
+            c_i32 x = static_cast<i32>(indices[i]) % region.m_regScale;
+            c_i32 z = static_cast<i32>(indices[i]) / region.m_regScale;
+
+            ChunkManager& chunk = region.m_chunks[indices[i]];
+            chunk.chunkData = chunk::ChunkDataPool::instance().acquire();
+            makeChunk(firstX + x, firstZ + z, *chunk.chunkData);
+            if (!entitiesInChunks) {
+                chunk.chunkData->entities = makeList(eNBT::COMPOUND, {});
+            }
+            chunk.chunkHeader.setZipCompressed(0);
+            chunk.chunkHeader.setRLECompressed(0);
+            chunk.chunkHeader.setTimestamp(0);
+            chunk.writeChunk(region.m_console);
+        }, m_settings.threadCount);
+    }
+
+
+    int SaveGenerator::writeOldGenRegions(SaveProject& saveProject) const {
+        const lce::CONSOLE console = m_settings.console;
+        c_i32 worldFirst = firstChunk();
+        c_i32 worldLast = worldFirst + static_cast<i32>(m_settings.worldChunks) - 1;
+
+        for (i32 regionZ = floorDiv(worldFirst, 32); regionZ <= floorDiv(worldLast, 32); regionZ++) {
+            for (i32 regionX = floorDiv(worldFirst, 32); regionX <= floorDiv(worldLast, 32); regionX++) {
+                Region region(regionX, regionZ, console);
+                fillRegion(region, regionX * 32, regionZ * 32, 32, true);
+
+                LCEFile& file = saveProject.emplaceFile(
+                        console, 0, saveProject.m_tempFolder,
+                        "r." + std::to_string(regionX) + "." + std::to_string(regionZ) + ".mcr");
+                file.setBuffer(region.write(console, m_settings.threadCount));
+            }
+        }
+        return SUCCESS;
+    }
+
+
+    /**
+     * New-gen regions are 16x16 chunks, stored in the top left of a regular
+     * region, and saved as the decompressed size followed by zero runs.
+     */
+    int SaveGenerator::writeNewGenRegions(SaveProject& saveProject) const {
+        const lce::CONSOLE console = m_settings.console;
+        c_i32 worldFirst = firstChunk();
+        c_i32 worldLast = worldFirst + static_cast<i32>(m_settings.worldChunks) - 1;
+
+        if (floorDiv(worldFirst, 16) < -128 || floorDiv(worldLast, 16) > 127) {
+            printf("SaveGenerator: a new-gen world can be at most 4096 chunks wide\n");
+            return STATUS::INVALID_ARGUMENT;
+        }
+
+        for (i32 regionZ = floorDiv(worldFirst, 16); regionZ <= floorDiv(worldLast, 16); regionZ++) {
+            for (i32 regionX = floorDiv(worldFirst, 16); regionX <= floorDiv(worldLast, 16); regionX++) {
+                Region region(regionX, regionZ, console);
+                fillRegion(region, regionX * 16, regionZ * 16, 16, false);
+                const Buffer regionBuffer = region.write(console, m_settings.threadCount);
+
+                // u32 decompressed size, then the zero runs
+                Buffer fileBuffer(4 + codec::RLE_NSXPS4_compressBound(regionBuffer.size()));
+                DataWriter header(fileBuffer.data(), 4, Endian::Little);
+                header.write<u32>(regionBuffer.size());
+                *fileBuffer.size_ptr() = 4 + codec::RLE_NSXPS4_COMPRESS(regionBuffer.data(), regionBuffer.size(),
+                                                                       fileBuffer.data() + 4, fileBuffer.size() - 4);
+
+                LCEFile& file = saveProject.emplaceFile(console, 0, saveProject.m_tempFolder, "");
+                file.setType(lce::FILETYPE::NEW_REGION_OVERWORLD);
+                file.setRegionX(static_cast<i16>(regionX));
+                file.setRegionZ(static_cast<i16>(regionZ));
+                file.setFileName(file.constructFileName(console));
+                file.setBuffer(std::move(fileBuffer));
+            }
+        }
+        return SUCCESS;
+    }
+
+
+    /// i32 count, then per chunk: i32 chunkX, i32 chunkZ and a named root compound holding "Entities"
+    int SaveGenerator::writeEntities(SaveProject& saveProject) const {
+        c_i32 worldFirst = firstChunk();
+        c_i32 worldEnd = worldFirst + static_cast<i32>(m_settings.worldChunks);
+
+        DataWriter writer;
+        writer.write<i32>(0);
+        i32 count = 0;
+        for (i32 chunkZ = worldFirst; chunkZ < worldEnd; chunkZ++) {
+            for (i32 chunkX = worldFirst; chunkX < worldEnd; chunkX++) {
+                NBTBase entities = makeEntities(chunkX, chunkZ);
+                if (entities.get<NBTList>().empty()) { continue; }
+
+                writer.write<i32>(chunkX);
+                writer.write<i32>(chunkZ);
+                writer.write<u8>(static_cast<u8>(eNBT::COMPOUND));
+                writer.write<u16>(0);
+                makeCompound({{"Entities", std::move(entities)}}).write(writer);
+                count++;
+            }
+        }
+        writer.writeAtOffset<i32>(0, count);
+
+        LCEFile& file = saveProject.emplaceFile(m_settings.console, 0, saveProject.m_tempFolder, "entities.dat");
+        file.setBuffer(writer.take());
+        return SUCCESS;
+    }
+
+
+    int SaveGenerator::writeLevel(SaveProject& saveProject) const {
+        c_i32 spawnY = std::max(heightAt(0, 0), SEA_LEVEL) + 1;
+        NBTBase level = makeCompound({{"", makeCompound({{"Data", makeCompound({
+                {"LevelName", makeString("Synthetic")},
+                {"RandomSeed", makeLong(static_cast<i64>(m_settings.seed))},
+                {"generatorName", makeString(m_settings.terrain == eTerrain::NOISY ? "default" : "flat")},
+                {"GameType", makeInt(1)},
+                {"SpawnX", makeInt(0)},
+                {"SpawnY", makeInt(spawnY)},
+                {"SpawnZ", makeInt(0)},
+                {"Time", makeLong(0)},
+                {"LastPlayed", makeLong(0)},
+                {"XZSize", makeInt(static_cast<i32>(m_settings.worldChunks))},
+                {"HellScale", makeInt(3)},
+                {"version", makeInt(19133)}
+        })}})}});
+
+        DataWriter writer;
+        level.write(writer);
+        LCEFile& file = saveProject.emplaceFile(m_settings.console, 0, saveProject.m_tempFolder, "level.dat");
+        file.setBuffer(writer.take());
+        return SUCCESS;
+    }
+
+
+    int SaveGenerator::generate(SaveProject& saveProject, const fs::path& folderPath) const {
+        if (getChunkCodec(m_settings.console) == eChunkCodec::NONE) {
+            printf("SaveGenerator: cannot compress chunks for %s\n",
+                   lce::consoleToStr(m_settings.console).c_str());
+            return STATUS::INVALID_CONSOLE;
+        }
+        if (m_settings.chunkVersion != chunk::V_11 && m_settings.chunkVersion != chunk::V_12) {
+            printf("SaveGenerator: only V_11 and V_12 chunks can be written\n");
+            return STATUS::INVALID_ARGUMENT;
+        }
+
+        if (!fs::exists(folderPath)) {
+            fs::create_directories(folderPath);
+        }
+        saveProject.m_tempFolder = folderPath;
+        // the point of generating is to get files on disk
+        saveProject.m_keepFilesInMemory = false;
+
+        c_bool isNewGen = lce::isConsoleNewGen(m_settings.console);
+        saveProject.m_stateSettings.setConsole(m_settings.console);
+        saveProject.m_stateSettings.setNewGen(isNewGen);
+        saveProject.setNewGen(isNewGen);
+        c_i32 version = m_settings.chunkVersion == chunk::V_11 ? SAVE_VERSION_ELYTRA : SAVE_VERSION_AQUATIC;
+        saveProject.setOldestVersion(version);
+        saveProject.setCurrentVersion(version);
+        saveProject.m_displayMetadata.worldName = L"Synthetic";
+        saveProject.m_displayMetadata.seed = static_cast<i64>(m_settings.seed);
+
+        int status = isNewGen ? writeNewGenRegions(saveProject) : writeOldGenRegions(saveProject);
+        if (status != SUCCESS) { return status; }
+
+        if (isNewGen) {
+            status = writeEntities(saveProject);
+            if (status != SUCCESS) { return status; }
+        }
+
+        return writeLevel(saveProject);
+    }
+
+
+} // namespace editor
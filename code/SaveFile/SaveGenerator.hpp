@@ -0,0 +1,109 @@
+#pragma once
+
+#include <random>
+
+#include "include/lce/enums.hpp"
+#include "include/lce/processor.hpp"
+
+#include "common/data/ghc/fs_std.hpp"
+#include "common/nbt.hpp"
+
+#include "code/Chunk/chunkData.hpp"
+
+
+namespace editor {
+    class Region;
+    class SaveProject;
+
+
+    enum class eTerrain : u8 {
+        /// a flat slab of stone, every grid holds a single block
+        UNIFORM,
+        /// bedrock, two layers of dirt and grass
+        SUPERFLAT,
+        /// hills, water below sea level and a mixed underground
+        NOISY,
+    };
+
+
+    /**
+     * Knobs for SaveGenerator. The same settings always produce the same save,
+     * regardless of the thread count.
+     */
+    struct GeneratorSettings {
+        lce::CONSOLE console = lce::CONSOLE::WIIU;
+        u64 seed = 1;
+        /// width and depth of the overworld in chunks, centered on chunk (0, 0)
+        u32 worldChunks = 54;
+        eTerrain terrain = eTerrain::NOISY;
+        /// V_11 or V_12, new-gen consoles always get V_12 since the editor cannot write V_13
+        chunk::eChunkVersion chunkVersion = chunk::V_12;
+        /// distinct blocks per 4x4x4 grid below the surface of noisy terrain, 1 to 64
+        u32 paletteSize = 4;
+        /**
+         * chance of a block at or below sea level also holding a submerged block, V_12 only.
+         * The V12 writer does not store the submerged layer yet, but it still widens grid palettes.
+         */
+        double submergedRatio = 0.1;
+        /// average entities per chunk
+        double entityDensity = 2.0;
+        /// average tile entities per chunk
+        double tileEntityDensity = 1.0;
+        /// threads used to build and compress chunks, 0 picks the default
+        u32 threadCount = 0;
+    };
+
+
+    /**
+     * Builds complete synthetic saves for benchmarks and load tests.
+     * \n\n
+     * Old-gen consoles get "r.X.Z.mcr" regions, new-gen consoles get tiny
+     * "GAMEDATA_000..." regions plus an entities.dat, and both get a level.dat.
+     * Every chunk is built from its own seed, so any chunk can be rebuilt on its
+     * own and chunks can be built in any order.
+     */
+    class SaveGenerator {
+        GeneratorSettings m_settings;
+
+    public:
+        static constexpr int SEA_LEVEL = 62;
+
+        explicit SaveGenerator(const GeneratorSettings& settings);
+
+        MU ND const GeneratorSettings& settings() const { return m_settings; }
+
+        /**
+         * Writes every file into folderPath and registers them with saveProject.
+         * @param saveProject should be empty, its console and versions are set
+         * @param folderPath where the files go, becomes saveProject.m_tempFolder
+         * @return SUCCESS or an error status
+         */
+        int generate(SaveProject& saveProject, const fs::path& folderPath) const;
+
+        /// fills chunkData with the chunk at (chunkX, chunkZ), including entities and tile entities
+        void makeChunk(i32 chunkX, i32 chunkZ, chunk::ChunkData& chunkData) const;
+
+        /// surface height of the terrain at a block column
+        MU ND i32 heightAt(i32 blockX, i32 blockZ) const;
+
+        /// the "Entities" list of a chunk
+        ND NBTBase makeEntities(i32 chunkX, i32 chunkZ) const;
+
+        /// the "TileEntities" list of a chunk
+        ND NBTBase makeTileEntities(i32 chunkX, i32 chunkZ) const;
+
+    private:
+        ND std::mt19937 chunkRandom(i32 chunkX, i32 chunkZ, u32 salt) const;
+        ND i32 firstChunk() const;
+        ND u16 paletteBlock(i32 blockX, i32 blockY, i32 blockZ) const;
+
+        void fillRegion(Region& region, i32 firstX, i32 firstZ, i32 width, bool entitiesInChunks) const;
+
+        int writeOldGenRegions(SaveProject& saveProject) const;
+        int writeNewGenRegions(SaveProject& saveProject) const;
+        int writeEntities(SaveProject& saveProject) const;
+        int writeLevel(SaveProject& saveProject) const;
+    };
+
+
+} // namespace editor
@@ -169,11 +169,23 @@ namespace editor {
                 create_directories(fullFilePath.parent_path());
             }
 
-            fs::copy(file.path(), fullFilePath);
+            DataWriter::writeFile(fullFilePath, file.getContents().data);
         }
 
         return SUCCESS;
     }
 
 
+    MU int SaveProject::spillToDisk() {
+        int result = SUCCESS;
+        for (LCEFile& file : m_allFiles) {
+            if (c_int status = file.spillToDisk(); status != SUCCESS) {
+                result = status;
+            }
+        }
+        m_keepFilesInMemory = false;
+        return result;
+    }
+
+
 } // namespace editor
\ No newline at end of file
@@ -9,7 +9,10 @@ namespace editor {
 
     class SaveProject {
     public:
+        /// where sub-files go when they are not kept in memory, or are spilled
         fs::path m_tempFolder;
+        /// sub-files of a read save stay in memory instead of being written to m_tempFolder
+        bool m_keepFilesInMemory = true;
 
         DisplayMetadata m_displayMetadata;
         StateSettings m_stateSettings;
@@ -40,6 +43,8 @@ namespace editor {
         MU void printDetails() const;
         MU void printFileList() const;
         MU ND int dumpToFolder(const std::string& detail) const;
+        /// writes every in-memory file to m_tempFolder, later reads and writes go to disk
+        MU int spillToDisk();
 
         static lce::CONSOLE detectConsole(const fs::path& savePath);
 
@@ -7,17 +7,24 @@
 #include "common/utils.hpp"
 #include "writeSettings.hpp"
 
+#include "code/threaded.hpp"
+
 
 namespace editor {
 
-    int FileListing::readListing(SaveProject& saveProject, const Buffer& bufferIn, lce::CONSOLE consoleIn) {
-        static constexpr u32 WSTRING_SIZE = 64;
-        MU static constexpr u32 FILELISTING_HEADER_SIZE = 12;
+    static constexpr u32 WSTRING_SIZE = 64;
+    static constexpr u32 FILELISTING_HEADER_SIZE = 12;
+
 
-        DataReader reader(bufferIn.data(), bufferIn.size(), getConsoleEndian(consoleIn));
+    int FileListing::readListing(SaveProject& saveProject, Buffer bufferIn, lce::CONSOLE consoleIn) {
+        // every in-memory file is a view into the listing, which lives as long as one of them does
+        c_auto backing = std::make_shared<const Buffer>(std::move(bufferIn));
+        c_bool inMemory = saveProject.m_keepFilesInMemory;
+        DataReader reader(backing->data(), backing->size(), getConsoleEndian(consoleIn));
 
+        // still set when in memory, spillToDisk() writes there
         fs::path outputPath = fs::path("temp") / getCurrentDateTimeString();
-        if (!outputPath.empty() && !fs::exists(outputPath)) {
+        if (!inMemory && !outputPath.empty() && !fs::exists(outputPath)) {
             fs::create_directories(outputPath);
         }
         saveProject.m_tempFolder = outputPath;
@@ -36,6 +43,14 @@ namespace editor {
 
         saveProject.m_allFiles.clear();
 
+        struct FileSpan {
+            fs::path path;
+            u32 offset;
+            u32 size;
+        };
+        std::vector<FileSpan> fileSpans;
+        fileSpans.reserve(fileCount);
+
         MU u32 totalSize = 0;
         for (u32 fileIndex = 0; fileIndex < fileCount; fileIndex++) {
 
@@ -50,26 +65,38 @@ namespace editor {
             }
             totalSize += fileSize;
 
-            reader.seek(index);
+            if (static_cast<u64>(index) + fileSize > backing->size()) {
+                printf("FileListing::readListing: file \"%s\" is out of bounds\n", fileName.c_str());
+                return INVALID_SAVE;
+            }
+
+            if (inMemory) {
+                LCEFile& file = saveProject.m_allFiles.emplace_back(consoleIn, timestamp, outputPath, fileName);
+                file.setView(backing, std::span(backing->data() + index, fileSize));
+                continue;
+            }
 
             fs::path filePath = outputPath / fileName;
             if (fs::path folderPath = filePath.parent_path();
                 !folderPath.empty() && !fs::exists(folderPath)) {
                 fs::create_directories(folderPath);
             }
-            auto readSpan = reader.readSpan(fileSize);
-            DataWriter::writeFile(filePath, readSpan);
+            fileSpans.push_back({filePath, index, fileSize});
 
             saveProject.m_allFiles.emplace_back(consoleIn, timestamp, outputPath, fileName);
         }
 
+        // the folders exist by now, so the files can be written in any order
+        parallel_for(fileSpans.size(), [&](const size_t i) {
+            const FileSpan& fileSpan = fileSpans[i];
+            DataWriter::writeFile(fileSpan.path, std::span(backing->data() + fileSpan.offset, fileSpan.size));
+        });
+
         return SUCCESS;
     }
 
 
-    Buffer FileListing::writeListing(SaveProject& saveProject, WriteSettings& writeSettings) {
-        static constexpr u32 WSTRING_SIZE = 64;
-        static constexpr u32 FILELISTING_HEADER_SIZE = 12;
+    ListingLayout FileListing::planListing(SaveProject& saveProject) {
         static const std::set<lce::FILETYPE> TYPES_TO_WRITE = {
                 lce::FILETYPE::STRUCTURE,
                 lce::FILETYPE::VILLAGE,
@@ -85,58 +112,69 @@ namespace editor {
                 lce::FILETYPE::ENTITY_OVERWORLD,
                 lce::FILETYPE::ENTITY_END,
         };
-        u32 FOOTER_ENTRY_SIZE = (saveProject.currentVersion() > 1) ? 144 : 136;
-        u32 MULTIPLIER = (saveProject.currentVersion() > 1) ? 1 : 136;
-
-        auto fileRange = saveProject.view_of(TYPES_TO_WRITE);
-        auto consoleOut = writeSettings.getConsole();
-
-        // step 1: get the file count and size of all sub-files
-        struct FileStruct {
-            const LCEFile& file;
-            Buffer buffer;
-            u32 offset{};
-        };
-
-        std::list<FileStruct> fileStructs;
-
-        u32 fileInfoOffset = FILELISTING_HEADER_SIZE;
-        for (const editor::LCEFile& file: fileRange) {
-            fileStructs.emplace_back(
-                    file,
-                    DataReader::readFile(file.path()),
-                    fileInfoOffset
-            );
-            fileInfoOffset += fileStructs.back().buffer.size();
+        c_u32 FOOTER_ENTRY_SIZE = (saveProject.currentVersion() > 1) ? 144 : 136;
+
+        ListingLayout layout;
+        layout.fileInfoOffset = FILELISTING_HEADER_SIZE;
+        for (const editor::LCEFile& file : saveProject.view_of(TYPES_TO_WRITE)) {
+            c_auto fileSize = static_cast<u32>(file.detectSize());
+            layout.entries.push_back({&file, fileSize, layout.fileInfoOffset});
+            layout.fileInfoOffset += fileSize;
         }
+        layout.totalSize = layout.fileInfoOffset + FOOTER_ENTRY_SIZE * layout.entries.size();
+        return layout;
+    }
 
-        // step 2: find total binary size and create its data buffer
-        c_u32 totalFileSize = fileInfoOffset + FOOTER_ENTRY_SIZE * fileStructs.size();
-        DataWriter writer(totalFileSize, getConsoleEndian(consoleOut));
-
-        // step 3: write header
-        writer.write<u32>(fileInfoOffset);
-        writer.write<u32>(fileStructs.size() * MULTIPLIER);
-        writer.write<u16>(saveProject.oldestVersion());
-        writer.write<u16>(saveProject.currentVersion());
 
-        // step 4: write each files data
-        for (const auto& fileStruct : fileStructs) {
-            writer.writeBytes(fileStruct.buffer.data(), fileStruct.buffer.size());
+    int FileListing::streamListing(SaveProject& saveProject, WriteSettings& writeSettings,
+                                   const ListingLayout& layout, ListingSink& sink) {
+        c_u32 FOOTER_ENTRY_SIZE = (saveProject.currentVersion() > 1) ? 144 : 136;
+        c_u32 MULTIPLIER = (saveProject.currentVersion() > 1) ? 1 : 136;
+        c_auto consoleOut = writeSettings.getConsole();
+        c_auto endian = getConsoleEndian(consoleOut);
+        int status;
+
+        // step 1: header
+        DataWriter header(FILELISTING_HEADER_SIZE, endian);
+        header.write<u32>(layout.fileInfoOffset);
+        header.write<u32>(layout.entries.size() * MULTIPLIER);
+        header.write<u16>(saveProject.oldestVersion());
+        header.write<u16>(saveProject.currentVersion());
+        if ((status = sink.write(header.span())) != SUCCESS) { return status; }
+
+        // step 2: each files data, only one of them is loaded at a time
+        for (const auto& entry : layout.entries) {
+            const FileContents contents = entry.file->getContents();
+            if (contents.data.size() != entry.size) {
+                return printf_err(INVALID_SAVE,
+                                  "FileListing::streamListing: \"%s\" changed size while writing\n",
+                                  entry.file->path().string().c_str());
+            }
+            if ((status = sink.write(contents.data)) != SUCCESS) { return status; }
         }
 
-        // step 5: write file metadata
-        for (const auto& fileStruct : fileStructs) {
-            std::string fileIterName = fileStruct.file.constructFileName(consoleOut);
-            writer.writeWStringFromString(fileIterName, WSTRING_SIZE);
-            writer.write<u32>(fileStruct.buffer.size());
-            writer.write<u32>(fileStruct.offset);
+        // step 3: file metadata
+        DataWriter footer(FOOTER_ENTRY_SIZE * layout.entries.size() + 1, endian);
+        for (const auto& entry : layout.entries) {
+            std::string fileIterName = entry.file->constructFileName(consoleOut);
+            footer.writeWStringFromString(fileIterName, WSTRING_SIZE);
+            footer.write<u32>(entry.size);
+            footer.write<u32>(entry.offset);
             if (saveProject.currentVersion() > 1) {
-                writer.write<u64>(fileStruct.file.m_timestamp);
+                footer.write<u64>(entry.file->m_timestamp);
             }
         }
+        return sink.write(footer.span());
+    }
+
 
-        return writer.take();
+    Buffer FileListing::writeListing(SaveProject& saveProject, WriteSettings& writeSettings) {
+        const ListingLayout layout = planListing(saveProject);
+        BufferSink sink(layout.totalSize, getConsoleEndian(writeSettings.getConsole()));
+        if (streamListing(saveProject, writeSettings, layout, sink) != SUCCESS) {
+            return {};
+        }
+        return sink.take();
     }
 
-}
\ No newline at end of file
+}
@@ -8,16 +8,51 @@
 #include "code/LCEFile/LCEFile.hpp"
 #include "common/error_status.hpp"
 
+#include "listingSink.hpp"
+
 
 namespace editor {
     class SaveProject;
     class WriteSettings;
 
+    /// where everything goes in a listing, worked out from the file sizes alone
+    struct ListingLayout {
+        struct Entry {
+            const LCEFile* file;
+            u32 size;
+            u32 offset;
+        };
+
+        std::vector<Entry> entries;
+        /// the files end and their metadata starts here
+        u32 fileInfoOffset = 0;
+        u32 totalSize = 0;
+    };
+
+
     class FileListing {
     public:
         FileListing() = default;
 
-        ND static int readListing(SaveProject& saveProject, const Buffer& bufferIn, lce::CONSOLE consoleIn);
+        /**
+         * Registers every sub-file of a decompressed save with saveProject. The files keep
+         * views into bufferIn if saveProject.m_keepFilesInMemory, otherwise they are written
+         * to a new folder under temp/.
+         */
+        ND static int readListing(SaveProject& saveProject, Buffer bufferIn, lce::CONSOLE consoleIn);
+
+        /// lays out the files that go into the listing without reading any of them
+        ND static ListingLayout planListing(SaveProject& saveProject);
+
+        /**
+         * Writes the listing described by layout into sink: the header, every file and then
+         * their metadata. Only one file is loaded at a time, so with an encoding sink peak
+         * memory is about the largest file rather than the whole save. Does not finish sink.
+         */
+        ND static int streamListing(SaveProject& saveProject, WriteSettings& writeSettings,
+                                    const ListingLayout& layout, ListingSink& sink);
+
+        /// the whole listing in one buffer, empty if a file could not be read
         ND static Buffer writeListing(SaveProject& saveProject, WriteSettings& writeSettings);
 
 
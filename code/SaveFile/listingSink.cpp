@@ -0,0 +1,342 @@
+#include "listingSink.hpp"
+
+#include <array>
+
+#include "include/zlib-1.2.12/zlib.h"
+
+#include "common/RLE/rle_scan.hpp"
+
+#include "code/threaded.hpp"
+
+
+namespace editor {
+
+
+    /// how much encoded output the sinks collect before passing it on
+    static constexpr size_t CHUNK_SIZE = 256 * 1024;
+    /// input per block of ParallelDeflateSink
+    static constexpr size_t DEFLATE_BLOCK_SIZE = 256 * 1024;
+    /// the deflate window, and so the most a block can refer back to
+    static constexpr size_t DEFLATE_WINDOW_SIZE = 32 * 1024;
+
+
+    // #####################################################
+    // #               BufferSink
+    // #####################################################
+
+
+    int BufferSink::write(const std::span<const u8> data) {
+        m_writer.writeBytes(data.data(), data.size());
+        return SUCCESS;
+    }
+
+
+    // #####################################################
+    // #               FileSink
+    // #####################################################
+
+
+    FileSink::FileSink(const fs::path& filePath)
+        : m_stream(filePath, std::ios::binary), m_filePath(filePath) {
+        m_crc = crc32(0, nullptr, 0);
+    }
+
+
+    int FileSink::write(const std::span<const u8> data) {
+        if (!m_stream.write(reinterpret_cast<const char*>(data.data()),
+                            static_cast<std::streamsize>(data.size()))) {
+            return printf_err(FILE_ERROR, "failed to write to \"%s\"\n", m_filePath.string().c_str());
+        }
+        // zlib takes uInt lengths
+        for (size_t offset = 0; offset < data.size(); offset += CHUNK_SIZE) {
+            c_auto length = std::min(CHUNK_SIZE, data.size() - offset);
+            m_crc = crc32(m_crc, data.data() + offset, static_cast<uInt>(length));
+        }
+        m_size += data.size();
+        return SUCCESS;
+    }
+
+
+    int FileSink::finish() {
+        m_stream.close();
+        if (m_stream.fail()) {
+            return printf_err(FILE_ERROR, "failed to write to \"%s\"\n", m_filePath.string().c_str());
+        }
+        return SUCCESS;
+    }
+
+
+    // #####################################################
+    // #               DeflateSink
+    // #####################################################
+
+
+    struct DeflateSink::State {
+        z_stream stream{};
+        std::array<u8, CHUNK_SIZE> output{};
+        bool open = false;
+    };
+
+
+    DeflateSink::DeflateSink(ListingSink& next) : m_next(next), m_state(std::make_unique<State>()) {
+        // the same parameters compress() uses
+        m_state->open = deflateInit(&m_state->stream, Z_DEFAULT_COMPRESSION) == Z_OK;
+    }
+
+
+    DeflateSink::~DeflateSink() {
+        if (m_state->open) {
+            deflateEnd(&m_state->stream);
+        }
+    }
+
+
+    int DeflateSink::write(const std::span<const u8> data) {
+        if (!m_state->open) { return COMPRESS; }
+
+        for (size_t offset = 0; offset < data.size(); offset += CHUNK_SIZE) {
+            c_auto length = std::min(CHUNK_SIZE, data.size() - offset);
+            m_state->stream.next_in = const_cast<Bytef*>(data.data() + offset);
+            m_state->stream.avail_in = static_cast<uInt>(length);
+            if (c_int status = pump(Z_NO_FLUSH); status != SUCCESS) {
+                return status;
+            }
+        }
+        return SUCCESS;
+    }
+
+
+    int DeflateSink::finish() {
+        if (!m_state->open) { return COMPRESS; }
+
+        m_state->stream.next_in = nullptr;
+        m_state->stream.avail_in = 0;
+        int status = pump(Z_FINISH);
+        deflateEnd(&m_state->stream);
+        m_state->open = false;
+        if (status == SUCCESS) {
+            status = m_next.finish();
+        }
+        return status;
+    }
+
+
+    /// runs deflate until it has consumed the pending input, or until the stream ends when finishing
+    int DeflateSink::pump(const int flush) {
+        z_stream& stream = m_state->stream;
+        while (true) {
+            stream.next_out = m_state->output.data();
+            stream.avail_out = static_cast<uInt>(m_state->output.size());
+
+            c_int result = deflate(&stream, flush);
+            if (result == Z_STREAM_ERROR) { return COMPRESS; }
+
+            c_auto produced = m_state->output.size() - stream.avail_out;
+            if (produced != 0) {
+                if (c_int status = m_next.write(std::span(m_state->output.data(), produced)); status != SUCCESS) {
+                    return status;
+                }
+            }
+
+            if (flush == Z_FINISH) {
+                if (result == Z_STREAM_END) { return SUCCESS; }
+            } else if (stream.avail_in == 0 && stream.avail_out != 0) {
+                return SUCCESS;
+            }
+        }
+    }
+
+
+    // #####################################################
+    // #               ParallelDeflateSink
+    // #####################################################
+
+
+    ParallelDeflateSink::ParallelDeflateSink(ListingSink& next, u32 threadCount)
+        : m_next(next), m_adler(adler32(0, nullptr, 0)) {
+        c_u32 concurrency = ThreadPool::instance().concurrency();
+        if (threadCount == 0 || threadCount > concurrency) { threadCount = concurrency; }
+        m_threadCount = threadCount;
+        m_blocks.emplace_back().input.reserve(DEFLATE_BLOCK_SIZE);
+    }
+
+
+    int ParallelDeflateSink::write(std::span<const u8> data) {
+        while (!data.empty()) {
+            std::vector<u8>& input = m_blocks.back().input;
+            c_auto length = std::min(DEFLATE_BLOCK_SIZE - input.size(), data.size());
+            input.insert(input.end(), data.begin(), data.begin() + length);
+            data = data.subspan(length);
+
+            if (input.size() < DEFLATE_BLOCK_SIZE) { break; }
+            // two blocks per thread keeps every thread busy while the batch is written out
+            if (m_blocks.size() >= m_threadCount * 2) {
+                if (c_int status = compressBlocks(false); status != SUCCESS) {
+                    return status;
+                }
+            }
+            m_blocks.emplace_back().input.reserve(DEFLATE_BLOCK_SIZE);
+        }
+        return SUCCESS;
+    }
+
+
+    int ParallelDeflateSink::finish() {
+        if (c_int status = compressBlocks(true); status != SUCCESS) {
+            return status;
+        }
+
+        c_u8 trailer[4] = {
+                static_cast<u8>(m_adler >> 24), static_cast<u8>(m_adler >> 16),
+                static_cast<u8>(m_adler >> 8), static_cast<u8>(m_adler),
+        };
+        if (c_int status = m_next.write(trailer); status != SUCCESS) {
+            return status;
+        }
+        return m_next.finish();
+    }
+
+
+    /**
+     * Deflates every block in m_blocks and passes them on in order.
+     * @param isFinal the last block ends the stream, otherwise every block must be full
+     */
+    int ParallelDeflateSink::compressBlocks(const bool isFinal) {
+        std::atomic<int> failure{SUCCESS};
+
+        parallel_for(m_blocks.size(), [&](const size_t index) {
+            Block& block = m_blocks[index];
+            c_bool isLast = isFinal && index + 1 == m_blocks.size();
+            c_auto length = static_cast<uInt>(block.input.size());
+
+            const std::vector<u8>& previous = index == 0 ? m_dictionary : m_blocks[index - 1].input;
+            c_auto dictionaryLength = std::min(previous.size(), DEFLATE_WINDOW_SIZE);
+
+            // raw deflate, the zlib header and trailer are written around the blocks
+            z_stream stream{};
+            if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                failure.store(COMPRESS);
+                return;
+            }
+            if (dictionaryLength != 0) {
+                deflateSetDictionary(&stream, previous.data() + previous.size() - dictionaryLength,
+                                     static_cast<uInt>(dictionaryLength));
+            }
+
+            // room for the sync flush marker as well
+            block.output.resize(deflateBound(&stream, length) + 16);
+            stream.next_in = block.input.data();
+            stream.avail_in = length;
+            stream.next_out = block.output.data();
+            stream.avail_out = static_cast<uInt>(block.output.size());
+
+            c_int result = deflate(&stream, isLast ? Z_FINISH : Z_SYNC_FLUSH);
+            block.output.resize(block.output.size() - stream.avail_out);
+            deflateEnd(&stream);
+
+            if (result != (isLast ? Z_STREAM_END : Z_OK) || stream.avail_in != 0) {
+                failure.store(COMPRESS);
+                return;
+            }
+            block.adler = adler32(adler32(0, nullptr, 0), block.input.data(), length);
+        }, m_threadCount);
+
+        if (failure.load() != SUCCESS) { return failure.load(); }
+
+        if (!m_wroteHeader) {
+            // what compress() writes for the default level
+            c_u8 header[2] = {0x78, 0x9C};
+            if (c_int status = m_next.write(header); status != SUCCESS) {
+                return status;
+            }
+            m_wroteHeader = true;
+        }
+
+        for (const Block& block : m_blocks) {
+            m_adler = adler32_combine(m_adler, block.adler, static_cast<z_off_t>(block.input.size()));
+            if (c_int status = m_next.write(block.output); status != SUCCESS) {
+                return status;
+            }
+        }
+
+        // keep the end of the input as the dictionary of the next batch
+        const std::vector<u8>& last = m_blocks.back().input;
+        c_auto keep = std::min(last.size(), DEFLATE_WINDOW_SIZE);
+        m_dictionary.assign(last.end() - static_cast<std::ptrdiff_t>(keep), last.end());
+        m_blocks.clear();
+        return SUCCESS;
+    }
+
+
+    // #####################################################
+    // #               RleVitaSink
+    // #####################################################
+
+
+    RleVitaSink::RleVitaSink(ListingSink& next) : m_next(next) {
+        m_output.reserve(CHUNK_SIZE + 2);
+    }
+
+
+    int RleVitaSink::write(std::span<const u8> data) {
+        // the scanning kernels take u32 sizes
+        while (!data.empty()) {
+            c_auto piece = data.first(std::min(data.size(), CHUNK_SIZE));
+            data = data.subspan(piece.size());
+            c_auto size = static_cast<u32>(piece.size());
+
+            u32 index = 0;
+            while (index < size) {
+                // zeros, possibly continuing a run from the previous write
+                c_u32 zerosEnd = codec::detail::findNotByte(piece.data(), index, size, 0);
+                u32 zeroCount = m_zeroCount + (zerosEnd - index);
+                for (; zeroCount >= 255; zeroCount -= 255) {
+                    m_output.push_back(0);
+                    m_output.push_back(255);
+                }
+                m_zeroCount = static_cast<u8>(zeroCount);
+                index = zerosEnd;
+                if (index == size) { break; }
+
+                if (m_zeroCount > 0) {
+                    m_output.push_back(0);
+                    m_output.push_back(m_zeroCount);
+                    m_zeroCount = 0;
+                }
+                c_u32 literalEnd = codec::detail::findByte(piece.data(), index, size, 0);
+                m_output.insert(m_output.end(), piece.data() + index, piece.data() + literalEnd);
+                index = literalEnd;
+
+                if (m_output.size() >= CHUNK_SIZE) {
+                    if (c_int status = flushOutput(); status != SUCCESS) {
+                        return status;
+                    }
+                }
+            }
+        }
+        return SUCCESS;
+    }
+
+
+    int RleVitaSink::finish() {
+        if (m_zeroCount > 0) {
+            m_output.push_back(0);
+            m_output.push_back(m_zeroCount);
+            m_zeroCount = 0;
+        }
+        if (c_int status = flushOutput(); status != SUCCESS) {
+            return status;
+        }
+        return m_next.finish();
+    }
+
+
+    int RleVitaSink::flushOutput() {
+        if (m_output.empty()) { return SUCCESS; }
+        c_int status = m_next.write(m_output);
+        m_output.clear();
+        return status;
+    }
+
+
+} // namespace editor
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "include/lce/processor.hpp"
+#include "common/data/ghc/fs_std.hpp"
+#include "common/data/DataWriter.hpp"
+#include "common/error_status.hpp"
+
+
+namespace editor {
+
+
+    /**
+     * Receives a file listing piece by piece, in order.
+     * Sinks that encode forward their output to another sink, so they can be chained.
+     */
+    class ListingSink {
+    public:
+        virtual ~ListingSink() = default;
+
+        ND virtual int write(std::span<const u8> data) = 0;
+
+        /// flushes whatever the sink still holds and finishes the sink it feeds, call once after the last write
+        ND virtual int finish() { return SUCCESS; }
+    };
+
+
+    /// collects everything into one buffer
+    class BufferSink final : public ListingSink {
+        DataWriter m_writer;
+
+    public:
+        explicit BufferSink(size_t reserve, Endian endian = Endian::Big) : m_writer(reserve, endian) {}
+
+        ND int write(std::span<const u8> data) override;
+
+        ND Buffer take() { return m_writer.take(); }
+    };
+
+
+    /// writes straight to a file, keeping the size and crc32 of what went through
+    class FileSink final : public ListingSink {
+        std::ofstream m_stream;
+        fs::path m_filePath;
+        u64 m_size = 0;
+        u32 m_crc = 0;
+
+    public:
+        explicit FileSink(const fs::path& filePath);
+
+        ND bool isOpen() const { return m_stream.is_open(); }
+
+        ND int write(std::span<const u8> data) override;
+        ND int finish() override;
+
+        ND u64 size() const { return m_size; }
+        ND u32 crc() const { return m_crc; }
+    };
+
+
+    /// zlib-compresses into next, the output matches compress() over the whole input
+    class DeflateSink final : public ListingSink {
+        struct State;
+
+        ListingSink& m_next;
+        std::unique_ptr<State> m_state;
+
+    public:
+        explicit DeflateSink(ListingSink& next);
+        ~DeflateSink() override;
+
+        ND int write(std::span<const u8> data) override;
+        ND int finish() override;
+
+    private:
+        ND int pump(int flush);
+    };
+
+
+    /**
+     * zlib-compresses into next on the shared ThreadPool, the way pigz does.
+     * \n\n
+     * The input is cut into blocks that are deflated at the same time, each one primed with
+     * the 32 KiB in front of it so the ratio stays close to that of a single stream. Every
+     * block but the last ends on a sync flush, so they join into one valid zlib stream whose
+     * Adler-32 is combined from theirs. The bytes differ from compress(), the inflated data
+     * does not. Only a few blocks per thread are held at once.
+     */
+    class ParallelDeflateSink final : public ListingSink {
+        struct Block {
+            std::vector<u8> input;
+            std::vector<u8> output;
+            u32 adler = 0;
+        };
+
+        ListingSink& m_next;
+        u32 m_threadCount;
+        /// blocks compressed together, the last one is being filled
+        std::vector<Block> m_blocks;
+        /// the input right before the first block of m_blocks
+        std::vector<u8> m_dictionary;
+        u32 m_adler;
+        bool m_wroteHeader = false;
+
+    public:
+        /// @param threadCount threads compressing blocks, 0 uses the whole pool
+        explicit ParallelDeflateSink(ListingSink& next, u32 threadCount = 0);
+
+        ND int write(std::span<const u8> data) override;
+        ND int finish() override;
+
+    private:
+        ND int compressBlocks(bool isFinal);
+    };
+
+
+    /// RLE-compresses into next, the output matches codec::RLEVITA_COMPRESS over the whole input
+    class RleVitaSink final : public ListingSink {
+        ListingSink& m_next;
+        std::vector<u8> m_output;
+        u8 m_zeroCount = 0;
+
+    public:
+        explicit RleVitaSink(ListingSink& next);
+
+        ND int write(std::span<const u8> data) override;
+        ND int finish() override;
+
+    private:
+        ND int flushOutput();
+    };
+
+
+} // namespace editor
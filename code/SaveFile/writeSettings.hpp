@@ -6,6 +6,7 @@
 #include "include/lce/processor.hpp"
 
 #include "code/ConsoleParser/productcodes.hpp"
+#include "code/Region/RegionPipeline.hpp"
 
 
 namespace editor {
@@ -28,6 +29,12 @@ namespace editor {
     public:
         ProductCodes m_productCodes;
 
+        /// threads and memory used when converting region files
+        RegionPipelineSettings m_regionPipeline;
+
+        /// threads compressing GAMEDATA, 0 uses the whole pool, 1 gives the exact bytes of a single zlib stream
+        u32 m_listingThreads = 0;
+
         bool shouldRemovePlayers = true;
 
         bool shouldRemoveDataMapping = true;
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "include/lce/processor.hpp"
+
+
+namespace editor {
+
+
+    /// A FIFO with a fixed capacity. push() blocks while it is full, pop() while it is empty.
+    template<typename T>
+    class BoundedQueue {
+        std::mutex m_mutex;
+        std::condition_variable m_notFull;
+        std::condition_variable m_notEmpty;
+        std::deque<T> m_items;
+        size_t m_capacity;
+        bool m_closed = false;
+
+    public:
+        explicit BoundedQueue(const size_t capacity) : m_capacity(capacity == 0 ? 1 : capacity) {}
+
+        /// @return false if the queue was closed, item is left untouched then
+        bool push(T& item) {
+            std::unique_lock lock(m_mutex);
+            m_notFull.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+            if (m_closed) { return false; }
+            m_items.push_back(std::move(item));
+            lock.unlock();
+            m_notEmpty.notify_one();
+            return true;
+        }
+
+        /// @return nullopt once the queue is closed and drained
+        std::optional<T> pop() {
+            std::unique_lock lock(m_mutex);
+            m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+            if (m_items.empty()) { return std::nullopt; }
+            std::optional<T> item(std::move(m_items.front()));
+            m_items.pop_front();
+            lock.unlock();
+            m_notFull.notify_one();
+            return item;
+        }
+
+        /// wakes every waiting thread, later pushes fail and pops drain what is left
+        void close() {
+            {
+                std::lock_guard lock(m_mutex);
+                m_closed = true;
+            }
+            m_notFull.notify_all();
+            m_notEmpty.notify_all();
+        }
+    };
+
+
+    /**
+     * Runs items through a chain of stages that work concurrently, connected by BoundedQueue's.
+     * \n\n
+     * Every stage has its own threads, since stages block on their queues and on file I/O,
+     * which would stall the workers of the shared ThreadPool. Work inside a stage can still
+     * use parallel_for. A full queue makes the stage in front of it wait (back-pressure), and
+     * at most maxInFlight items exist at once, so memory stays bounded however many items run.
+     * \n\n
+     * The first exception thrown by a stage cancels the pipeline: the remaining items are
+     * dropped and run() rethrows it once every thread has stopped.
+     */
+    template<typename Item>
+    class Pipeline {
+    public:
+        struct Stage {
+            std::string name;
+            std::function<void(Item&)> func;
+            /// threads working on this stage
+            u32 parallelism = 1;
+            /// items that may wait in front of this stage
+            u32 queueCapacity = 2;
+            /// items reach func in the order they were made, implies a single thread
+            bool ordered = false;
+        };
+
+    private:
+        struct Slot {
+            size_t sequence;
+            Item item;
+        };
+
+        std::vector<Stage> m_stages;
+        std::vector<std::unique_ptr<BoundedQueue<Slot>>> m_queues;
+        u32 m_maxInFlight;
+
+        std::mutex m_flightMutex;
+        std::condition_variable m_flightDone;
+        size_t m_inFlight = 0;
+
+        std::atomic<bool> m_cancelled{false};
+        std::mutex m_errorMutex;
+        std::exception_ptr m_error;
+
+    public:
+        /// @param maxInFlight items that may exist at once across all stages
+        explicit Pipeline(c_u32 maxInFlight) : m_maxInFlight(maxInFlight == 0 ? 1 : maxInFlight) {}
+
+        Pipeline& addStage(Stage stage) {
+            if (stage.ordered || stage.parallelism == 0) { stage.parallelism = 1; }
+            m_stages.push_back(std::move(stage));
+            return *this;
+        }
+
+        /// drops every item that has not finished yet, run() returns once the threads stop
+        void cancel() {
+            m_cancelled.store(true, std::memory_order_relaxed);
+            for (auto& queue : m_queues) { queue->close(); }
+            m_flightDone.notify_all();
+        }
+
+        ND bool isCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+
+        /**
+         * Calls makeItem(index) for every index in [0, count) on the calling thread and feeds
+         * the items through the stages. Returns once every item has left the last stage.
+         */
+        void run(const size_t count, const std::function<Item(size_t)>& makeItem) {
+            if (m_stages.empty()) { return; }
+            m_queues.clear();
+            for (const Stage& stage : m_stages) {
+                m_queues.push_back(std::make_unique<BoundedQueue<Slot>>(stage.queueCapacity));
+            }
+
+            std::vector<std::thread> threads;
+            std::vector<std::unique_ptr<std::atomic<u32>>> running;
+            for (size_t index = 0; index < m_stages.size(); index++) {
+                running.push_back(std::make_unique<std::atomic<u32>>(m_stages[index].parallelism));
+            }
+            for (size_t index = 0; index < m_stages.size(); index++) {
+                for (u32 i = 0; i < m_stages[index].parallelism; i++) {
+                    threads.emplace_back([this, index, &running] {
+                        if (m_stages[index].ordered) {
+                            runOrderedStage(index);
+                        } else {
+                            runStage(index);
+                        }
+                        // the last thread of a stage closes the queue of the next one
+                        if (running[index]->fetch_sub(1) == 1 && index + 1 < m_queues.size()) {
+                            m_queues[index + 1]->close();
+                        }
+                    });
+                }
+            }
+
+            for (size_t sequence = 0; sequence < count; sequence++) {
+                {
+                    std::unique_lock lock(m_flightMutex);
+                    m_flightDone.wait(lock, [this] { return isCancelled() || m_inFlight < m_maxInFlight; });
+                    if (isCancelled()) { break; }
+                    m_inFlight++;
+                }
+                try {
+                    Slot slot{sequence, makeItem(sequence)};
+                    if (!m_queues.front()->push(slot)) { retire(); }
+                } catch (...) {
+                    retire();
+                    setError(std::current_exception());
+                    break;
+                }
+            }
+            m_queues.front()->close();
+
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            if (m_error) {
+                std::exception_ptr error;
+                std::swap(error, m_error);
+                std::rethrow_exception(error);
+            }
+        }
+
+    private:
+        void runStage(const size_t index) {
+            while (std::optional<Slot> slot = m_queues[index]->pop()) {
+                process(index, *slot);
+            }
+        }
+
+
+        void runOrderedStage(const size_t index) {
+            std::map<size_t, Slot> waiting;
+            size_t nextSequence = 0;
+            while (std::optional<Slot> slot = m_queues[index]->pop()) {
+                c_auto sequence = slot->sequence;
+                waiting.emplace(sequence, std::move(*slot));
+                for (auto it = waiting.find(nextSequence); it != waiting.end(); it = waiting.find(nextSequence)) {
+                    process(index, it->second);
+                    waiting.erase(it);
+                    nextSequence++;
+                }
+            }
+            // only left over after a cancel, when earlier items were dropped
+            for (size_t i = 0; i < waiting.size(); i++) { retire(); }
+        }
+
+
+        void process(const size_t index, Slot& slot) {
+            if (isCancelled()) {
+                retire();
+                return;
+            }
+            try {
+                m_stages[index].func(slot.item);
+            } catch (...) {
+                retire();
+                setError(std::current_exception());
+                return;
+            }
+            if (index + 1 == m_stages.size() || !m_queues[index + 1]->push(slot)) {
+                retire();
+            }
+        }
+
+
+        void retire() {
+            {
+                std::lock_guard lock(m_flightMutex);
+                m_inFlight--;
+            }
+            m_flightDone.notify_one();
+        }
+
+
+        void setError(std::exception_ptr error) {
+            {
+                std::lock_guard lock(m_errorMutex);
+                if (!m_error) { m_error = std::move(error); }
+            }
+            cancel();
+        }
+    };
+
+
+} // namespace editor
@@ -4,7 +4,10 @@
 
 #include "include/lce/blocks/blockID.hpp"
 
+#include "code/Chunk/chunkDataPool.hpp"
 #include "code/Region/Region.hpp"
+#include "code/Region/RegionCache.hpp"
+#include "code/Region/RegionPipeline.hpp"
 
 #include "code/SaveFile/SaveProject.hpp"
 #include "code/SaveFile/fileListing.hpp"
@@ -186,8 +189,8 @@ namespace editor {
             }
 
             std::memcpy(chunkData->newBlocks.data(), &blocks[0], 131072);
-            memset(chunkData->blockLight.data(), 0xFF, 32768);
-            memset(chunkData->skyLight.data(), 0xFF, 32768);
+            chunkData->blockLight.fill(0xFF);
+            chunkData->skyLight.fill(0xFF);
             chunkData->terrainPopulated = 2046;
 
             chunkData->defaultNBT();
@@ -207,13 +210,13 @@ namespace editor {
             chunk.chunkHeader.setNewSaveFlag(1);
             // fix shit old xbox NBT
             if (chunkData->entities.get<NBTList>().subType() != eNBT::COMPOUND)
-                chunkData->entities = makeList(eNBT::COMPOUND, {});
+                chunkData->setEntities(makeList(eNBT::COMPOUND, {}));
 
             if (chunkData->tileEntities.get<NBTList>().subType() != eNBT::COMPOUND)
-                chunkData->tileEntities = makeList(eNBT::COMPOUND, {});
+                chunkData->setTileEntities(makeList(eNBT::COMPOUND, {}));
 
             if (chunkData->tileTicks.get<NBTList>().subType() != eNBT::COMPOUND)
-                chunkData->tileTicks = makeList(eNBT::COMPOUND, {});
+                chunkData->setTileTicks(makeList(eNBT::COMPOUND, {}));
 
             if (chunkData->chunkHeight == 128) {
                 chunkData->convertNBT128ToAquatic();
@@ -315,7 +318,7 @@ namespace editor {
         for (int i = 0; i < 1024; i++) {
             ChunkManager& chunkManager = region.m_chunks[i];
             chunkManager.readChunk(inConsole);
-            if (!chunkManager.chunkData->validChunk) continue;
+            if (!chunkManager.isValidChunk()) continue;
             convertReadChunkToAquatic(chunkManager);
             chunkManager.writeChunk(outConsole);
         }
@@ -337,7 +340,7 @@ namespace editor {
         };
 
         using ft = lce::FILETYPE;
-        using Map = std::unordered_map<Coordinate, editor::Region>;
+        using Map = std::unordered_map<Coordinate, LCEFile*>;
 
         std::vector<std::tuple<ft, ft, ft, Map>> dimensions;
         dimensions.reserve(3);
@@ -345,6 +348,12 @@ namespace editor {
         dimensions.emplace_back(ft::NEW_REGION_NETHER,    ft::OLD_REGION_NETHER,    ft::ENTITY_NETHER,    Map{});
         dimensions.emplace_back(ft::NEW_REGION_END,       ft::OLD_REGION_END,       ft::ENTITY_END,       Map{});
 
+        auto consoleWrite = writeSettings.getConsole();
+
+        // each old region is filled from up to four tiny regions, the cache keeps it
+        // decoded between those visits and writes it back to its file when it is evicted
+        std::list<LCEFile> convertedFiles;
+        RegionCache regionCache;
 
         for (auto& [newFmt, oldFmt, entityFmt, regionMap] : dimensions) {
 
@@ -368,15 +377,26 @@ namespace editor {
                 }
             }
 
-            // (2) build regions
+            // (2) create the old region files, empty until their chunks are written back
             for (auto& pos : positions) {
                 Coordinate key{pos[0], pos[1]};
 
-                regionMap.emplace(
-                        std::piecewise_construct,
-                        std::forward_as_tuple(key),
-                        std::forward_as_tuple(key.x, key.z)
+                auto& file = convertedFiles.emplace_back(
+                        consoleWrite,
+                        0,
+                        saveProject.m_tempFolder,
+                        ""
                 );
+                file.setType(oldFmt);
+                file.setRegionX((i16)key.x);
+                file.setRegionZ((i16)key.z);
+                std::string fileName = file.constructFileName(consoleWrite);
+                file.setFileName(fileName);
+                if (saveProject.m_keepFilesInMemory) {
+                    file.moveToMemory();
+                }
+                file.setBuffer(Buffer());
+                regionMap.emplace(key, &file);
             }
 
             // (3) collect new format
@@ -407,17 +427,20 @@ namespace editor {
                 }
 
                 // (4a) move chunks from tiny regions to big regions
-                Region& bigRegion = bigIt->second;
+                Region* bigRegion = regionCache.get(*bigIt->second);
+                if (bigRegion == nullptr) {
+                    throw std::runtime_error("failed to read " + bigIt->second->path().string());
+                }
                 for (int sx = 0; sx < 16; ++sx) {
                     for (int sz = 0; sz < 16; ++sz) {
                         int dx = sx + 16 * std::abs(tinyRegion.x() & 1);
                         int dz = sz + 16 * std::abs(tinyRegion.z() & 1);
 
                         int scale = 27;
-                        bool onLeft   = (bigRegion.x() == -1);
-                        bool onRight  = (bigRegion.x() ==  0);
-                        bool onTop    = (bigRegion.z() == -1);
-                        bool onBottom = (bigRegion.z() ==  0);
+                        bool onLeft   = (bigRegion->x() == -1);
+                        bool onRight  = (bigRegion->x() ==  0);
+                        bool onTop    = (bigRegion->z() == -1);
+                        bool onBottom = (bigRegion->z() ==  0);
                         int xMin = onLeft  ? 32 - scale : 0;
                         int xMax = onRight ? scale : 32;
                         int zMin = onTop    ? 32 - scale  : 0;
@@ -428,10 +451,10 @@ namespace editor {
 
 
 
-                        if (!inRange(sx, sz, bigRegion.m_regScale)){
+                        if (!inRange(sx, sz, bigRegion->m_regScale)){
                             continue;
                         }
-                        if (!inRange(dx, dz, bigRegion.m_regScale)){
+                        if (!inRange(dx, dz, bigRegion->m_regScale)){
                             continue;
                         }
                         ChunkManager chunk;
@@ -440,12 +463,12 @@ namespace editor {
                         }
 
                         Coordinate realChunkCoord = {
-                                bigRegion.x() * 32 + dx,
-                                bigRegion.z() * 32 + dz
+                                bigRegion->x() * 32 + dx,
+                                bigRegion->z() * 32 + dz
                         };
 
                         chunk.readChunk(saveProject.m_stateSettings.console());
-                        if (!chunk.chunkData->validChunk) continue;
+                        if (!chunk.isValidChunk()) continue;
                         convertReadChunkToAquatic(chunk);
 
                         auto entityIt = entityMap.extract(realChunkCoord);
@@ -453,72 +476,70 @@ namespace editor {
                             if (chunk.chunkData->validChunk) {
                                 NBTBase nbt = std::move(entityIt.mapped().get<NBTCompound>().extract("Entities")
                                                                 .value_or(makeList(eNBT::COMPOUND)));
-                                chunk.chunkData->entities = std::move(nbt);
+                                chunk.chunkData->setEntities(std::move(nbt));
                             }
                         }
 
-                        chunk.writeChunk(writeSettings.getConsole());
+                        chunk.writeChunk(consoleWrite);
+                        // the old region only needs the compressed bytes
+                        chunk.releaseChunkData();
 
-                        if (!bigRegion.insertChunk(dx, dz, std::move(chunk))) {
+                        if (!bigRegion->insertChunk(dx, dz, std::move(chunk))) {
                             continue;
                         }
 
                         // std::cout << "moved chunk(" << sx << ", " << sz << ") "
                         //           << "tiny reg[" << tinyRegion.x() << ", " << tinyRegion.z() << "] "
                         //           << "to chunk(" <<  dx << ", " << dz << ") "
-                        //           << "big reg[" << bigRegion.x() << ", " << bigRegion.z() << "]\n";
+                        //           << "big reg[" << bigRegion->x() << ", " << bigRegion->z() << "]\n";
 
                     }
                 }
 
+                // the inserted chunks hold no chunk data to mark, so the region is marked instead;
+                // regions that fail to write back while making room stay cached for clear() below
+                regionCache.markDirty(*bigIt->second);
 
-            }
-        }
 
-        auto consoleWrite = writeSettings.getConsole();
-
-        // create files from old regions
-        std::list<LCEFile> convertedFiles;
-        for (auto& [newFmt, oldFmt, entityFmt, regionMap] : dimensions) {
-            for (auto& [coord, region] : regionMap) {
-                Buffer buffer = region.write(consoleWrite);
-                if (buffer.empty()) continue;
-                auto& file = convertedFiles.emplace_back(
-                        consoleWrite,
-                        0,
-                        saveProject.m_tempFolder,
-                        ""
-                );
-                file.setType(oldFmt);
-                file.setRegionX((i16)coord.x);
-                file.setRegionZ((i16)coord.z);
-                std::string fileName = file.constructFileName(consoleWrite);
-                file.setFileName(fileName);
-                file.setBuffer(std::move(buffer));
             }
         }
 
+        if (regionCache.clear() != SUCCESS) {
+            throw std::runtime_error("failed to write the converted regions");
+        }
+        // old regions that received no chunks stay empty and are left out of the save
+        convertedFiles.remove_if([](const LCEFile& file) {
+            if (file.detectSize() != 0) { return false; }
+            if (!file.isInMemory()) { fs::remove(file.path()); }
+            return true;
+        });
         saveProject.addFiles(std::move(convertedFiles));
     }
 
 
-    MU void convertRegions(SaveProject& saveProject, lce::CONSOLE consoleOut) {
+    MU void convertRegions(SaveProject& saveProject, lce::CONSOLE consoleOut,
+                           const RegionPipelineSettings& pipelineSettings = {}) {
         static const std::set<lce::FILETYPE> regionTypes = {
                 lce::FILETYPE::OLD_REGION_NETHER,
                 lce::FILETYPE::OLD_REGION_OVERWORLD,
                 lce::FILETYPE::OLD_REGION_END
         };
 
+        std::vector<LCEFile*> regionFiles;
         for (LCEFile& file : saveProject.view_of(regionTypes)) {
-            Region region;
-            region.read(&file);
-            region.convertChunks(consoleOut);
-
-            file.setBuffer(region.write(consoleOut));
-            file.m_console = consoleOut;
+            // same codec and endian, the region file is already valid for the target
+            if (isSameChunkCodec(file.m_console, consoleOut)
+                && lce::getConsoleEndian(file.m_console) == lce::getConsoleEndian(consoleOut)) {
+                file.m_console = consoleOut;
+                continue;
+            }
+            regionFiles.push_back(&file);
         }
-    }
 
+        RegionPipeline(pipelineSettings).run(regionFiles, consoleOut, false, [consoleOut](Region& region) {
+            region.convertChunks(consoleOut);
+        });
+    }
 
 
     MU ND int preprocess(SaveProject& saveProject, StateSettings& stateSettings, WriteSettings& theWriteSettings) {
@@ -588,9 +609,16 @@ namespace editor {
         // old gen -> old gen
         if (!lce::isConsoleNewGen(consoleIn) && !lce::isConsoleNewGen(consoleOut)) {
             std::cout << "[-] rewriting all region chunks to adjust endian, this may take a minute.\n";
+            std::vector<LCEFile*> regionFiles;
             for (LCEFile& file : saveProject.view_of(kOldGenRegions)) {
-                editor::convertChunksToAquatic(file, consoleIn, consoleOut);
+                regionFiles.push_back(&file);
             }
+            RegionPipeline(writeSettings.m_regionPipeline).run(regionFiles, consoleOut, true, [](Region& region) {
+                for (ChunkManager& chunkManager : region.m_chunks) {
+                    if (!chunkManager.isValidChunk()) continue;
+                    convertReadChunkToAquatic(chunkManager);
+                }
+            });
 
             // new gen -> old gen
         } else if (lce::isConsoleNewGen(consoleIn) && !lce::isConsoleNewGen(consoleOut)) {
@@ -619,8 +647,10 @@ namespace editor {
                 level.setBuffer(std::move(writer.take()));
             }
         } else {
-            convertRegions(saveProject, consoleOut);
+            convertRegions(saveProject, consoleOut, writeSettings.m_regionPipeline);
         }
+
+        chunk::ChunkDataPool::instance().trim();
     }
 
 
@@ -1,36 +1,272 @@
-/*
 #include "threaded.hpp"
 
-#include "lce/processor.hpp"
 
-#include <thread>
+namespace editor {
 
-#include "code/SaveFile/fileListing.hpp"
+
+    namespace {
+        thread_local const ThreadPool* t_pool = nullptr;
+        thread_local u32 t_workerIndex = 0;
+    }
 
 
-template<int threadCount, typename Function, typename... Args>
-int run_parallel(Function func, Args... args) {
-    std::vector<std::thread> threads;
-    for (int i = 0; i < threadCount; ++i) {
-        threads.emplace_back(std::bind(func, i, args...));
+    u32 getDefaultThreadCount() {
+        c_u32 hardware = std::thread::hardware_concurrency();
+        return hardware == 0 ? 1 : hardware;
     }
-    for (auto& thread : threads) {
-        if (thread.joinable()) {
+
+
+    // #####################################################
+    // #               ThreadPool
+    // #####################################################
+
+
+    ThreadPool::ThreadPool(u32 workerCount) {
+        if (workerCount == 0) { workerCount = getDefaultThreadCount() - 1; }
+        m_workerCount = workerCount;
+
+        for (u32 i = 0; i < workerCount + 1; i++) {
+            m_queues.push_back(std::make_unique<Queue>());
+        }
+        m_threads.reserve(workerCount);
+        for (u32 i = 0; i < workerCount; i++) {
+            m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock(m_sleepMutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (auto& thread : m_threads) {
             thread.join();
         }
     }
-    return 0;
-}
 
-template int run_parallel<4>(std::function<void(int)> func);
 
-template int run_parallel<4>(
-        void (*)(size_t, editor::FileListing&),
-        std::reference_wrapper<editor::FileListing>
-);
+    ThreadPool& ThreadPool::instance() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+
+    bool ThreadPool::isWorkerThread() const {
+        return t_pool == this;
+    }
+
+
+    void ThreadPool::submit(Task task) {
+        submit(std::move(task), nullptr);
+    }
+
+
+    void ThreadPool::submit(Task task, const void* group) {
+        Queue& queue = isWorkerThread() ? *m_queues[t_workerIndex] : *m_queues.back();
+        {
+            std::lock_guard lock(queue.mutex);
+            queue.tasks.push_back({std::move(task), group});
+        }
+        m_pending.fetch_add(1, std::memory_order_release);
+        {
+            // pairs with the predicate check in workerLoop, so the wake-up cannot be missed
+            std::lock_guard lock(m_sleepMutex);
+        }
+        m_wake.notify_one();
+    }
+
+
+    bool ThreadPool::popFrom(std::deque<Entry>& tasks, const bool fromBack, const void* group, Task& task) {
+        for (size_t n = 0; n < tasks.size(); n++) {
+            c_auto it = tasks.begin() + static_cast<std::ptrdiff_t>(fromBack ? tasks.size() - 1 - n : n);
+            if (group != nullptr && it->group != group) { continue; }
+            task = std::move(it->task);
+            tasks.erase(it);
+            return true;
+        }
+        return false;
+    }
+
+
+    bool ThreadPool::tryPop(Task& task, const void* group) {
+        u32 start = 0;
+
+        // newest task of our own first, it is the one most likely still in cache
+        if (isWorkerThread()) {
+            Queue& own = *m_queues[t_workerIndex];
+            std::lock_guard lock(own.mutex);
+            if (popFrom(own.tasks, true, group, task)) { return true; }
+            start = t_workerIndex + 1;
+        }
+
+        {
+            Queue& injected = *m_queues.back();
+            std::lock_guard lock(injected.mutex);
+            if (popFrom(injected.tasks, false, group, task)) { return true; }
+        }
+
+        // steal the oldest task of another worker, those tend to be the biggest
+        for (u32 i = 0; i < m_workerCount; i++) {
+            Queue& victim = *m_queues[(start + i) % m_workerCount];
+            std::lock_guard lock(victim.mutex);
+            if (popFrom(victim.tasks, false, group, task)) { return true; }
+        }
+        return false;
+    }
+
+
+    bool ThreadPool::runPending() {
+        return runPending(nullptr);
+    }
+
+
+    bool ThreadPool::runPending(const void* group) {
+        Task task;
+        if (!tryPop(task, group)) { return false; }
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+        task();
+        return true;
+    }
+
+
+    void ThreadPool::workerLoop(c_u32 index) {
+        t_pool = this;
+        t_workerIndex = index;
+
+        while (true) {
+            if (runPending()) { continue; }
+
+            std::unique_lock lock(m_sleepMutex);
+            m_wake.wait(lock, [this] {
+                return m_stopping || m_pending.load(std::memory_order_acquire) != 0;
+            });
+            if (m_stopping && m_pending.load(std::memory_order_acquire) == 0) { return; }
+        }
+    }
+
+
+    // #####################################################
+    // #               TaskGroup
+    // #####################################################
+
+
+    TaskGroup::TaskGroup(ThreadPool& pool) : m_pool(pool) {}
+
+
+    TaskGroup::~TaskGroup() {
+        try {
+            wait();
+        } catch (...) {}
+    }
+
+
+    void TaskGroup::run(std::function<void()> func) {
+        {
+            std::lock_guard lock(m_waitMutex);
+            m_active++;
+        }
+        m_pool.submit([this, func = std::move(func)] {
+            if (!isCancelled()) {
+                try {
+                    func();
+                } catch (...) {
+                    setError(std::current_exception());
+                }
+            }
+            // last access to the group, a waiter cannot return before the mutex is released
+            std::lock_guard lock(m_waitMutex);
+            if (--m_active == 0) { m_changed.notify_all(); }
+        }, this);
+
+        // a waiter that already looked at the queues has to look again
+        std::lock_guard lock(m_waitMutex);
+        m_submitted++;
+        m_changed.notify_all();
+    }
+
+
+    void TaskGroup::wait() {
+        while (true) {
+            u64 submitted;
+            {
+                std::lock_guard lock(m_waitMutex);
+                if (m_active == 0) { break; }
+                submitted = m_submitted;
+            }
+            if (m_pool.runPending(this)) { continue; }
+
+            // the remaining tasks are running on other threads
+            std::unique_lock lock(m_waitMutex);
+            m_changed.wait(lock, [&] { return m_active == 0 || m_submitted != submitted; });
+        }
+
+        std::exception_ptr error;
+        {
+            std::lock_guard lock(m_errorMutex);
+            std::swap(error, m_error);
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+
+    void TaskGroup::setError(std::exception_ptr error) {
+        {
+            std::lock_guard lock(m_errorMutex);
+            if (!m_error) { m_error = std::move(error); }
+        }
+        cancel();
+    }
+
+
+    // #####################################################
+    // #               parallel_for
+    // #####################################################
+
+
+    void parallel_for(const size_t count, const std::function<void(size_t)>& func, u32 threadCount) {
+        if (count == 0) { return; }
+        ThreadPool& pool = ThreadPool::instance();
+        if (threadCount == 0 || threadCount > pool.concurrency()) { threadCount = pool.concurrency(); }
+        if (threadCount > count) { threadCount = static_cast<u32>(count); }
+
+        if (threadCount <= 1) {
+            for (size_t index = 0; index < count; index++) {
+                func(index);
+            }
+            return;
+        }
+
+        std::atomic<size_t> nextIndex{0};
+        TaskGroup group(pool);
+
+        auto worker = [&] {
+            while (!group.isCancelled()) {
+                const size_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+                if (index >= count) { return; }
+                func(index);
+            }
+        };
+
+        for (u32 i = 1; i < threadCount; i++) {
+            group.run(worker);
+        }
+
+        try {
+            worker();
+        } catch (...) {
+            group.cancel();
+            // the queued workers reference this frame, let them drain before unwinding
+            try {
+                group.wait();
+            } catch (...) {}
+            throw;
+        }
+        group.wait();
+    }
+
 
-template int run_parallel<32>(
-        void (*)(size_t, editor::FileListing&),
-        std::reference_wrapper<editor::FileListing>
-);
- */
\ No newline at end of file
+} // namespace editor
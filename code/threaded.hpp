@@ -1,20 +1,162 @@
-/*
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
+#include "include/lce/processor.hpp"
 
- * \n
- * It is a requirement that the first argument passed to the
- * function is an index based on the maximum thread count.
- * \n\n
- * use 'std::ref' for references.
- * @tparam threadCount how many threads to create
- * @tparam Function
- * @tparam Args
- * @param func the function to call
- * @param args the arguments to pass to the function
- * @return
 
-template<int threadCount, typename Function, typename... Args>
-int run_parallel(Function func, Args... args);
-*/
\ No newline at end of file
+namespace editor {
+
+
+    /// number of threads to use when the caller does not specify one
+    MU ND u32 getDefaultThreadCount();
+
+
+    /**
+     * The editor's shared work-stealing scheduler.
+     * \n\n
+     * Every worker owns a deque: it pushes and pops its own tasks at the back,
+     * and idle workers steal from the front of the others. Tasks submitted from
+     * threads outside the pool go to a shared injection queue.
+     * \n\n
+     * A thread waiting on a TaskGroup runs the queued tasks of that group itself,
+     * and sleeps once the rest are running elsewhere. A parallel loop started from
+     * inside a task therefore reuses the existing workers rather than spawning more,
+     * and cannot deadlock the pool, since a waiter never depends on a queued task
+     * it could not run itself.
+     */
+    class ThreadPool {
+        friend class TaskGroup;
+        using Task = std::function<void()>;
+
+        struct Entry {
+            Task task;
+            /// the TaskGroup the task belongs to, if any
+            const void* group = nullptr;
+        };
+
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Entry> tasks;
+        };
+
+        /// one per worker, the last one is the injection queue
+        std::vector<std::unique_ptr<Queue>> m_queues;
+        std::vector<std::thread> m_threads;
+        /// fixed before the first worker starts, m_threads is still growing then
+        u32 m_workerCount = 0;
+
+        std::mutex m_sleepMutex;
+        std::condition_variable m_wake;
+        std::atomic<size_t> m_pending{0};
+        bool m_stopping = false;
+
+    public:
+        /**
+         * @param workerCount background threads, 0 picks one less than
+         * getDefaultThreadCount() since the waiting thread also runs tasks
+         */
+        explicit ThreadPool(u32 workerCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /// the pool shared by the whole editor, created on first use
+        static ThreadPool& instance();
+
+        /// threads that can run tasks at once, the workers plus the waiting thread
+        ND u32 concurrency() const { return m_workerCount + 1; }
+
+        /// true when called from one of this pool's workers
+        ND bool isWorkerThread() const;
+
+        /**
+         * Queues a task. Prefer a TaskGroup, which tracks completion and errors;
+         * a task submitted here must not throw.
+         */
+        void submit(Task task);
+
+        /**
+         * Runs one queued task on the calling thread, if there is one.
+         * @return false when every queue was empty
+         */
+        bool runPending();
+
+    private:
+        void submit(Task task, const void* group);
+        /// only takes tasks of group, unless it is nullptr
+        bool runPending(const void* group);
+        /// takes the newest (fromBack) or oldest task that belongs to group, any task if it is nullptr
+        static bool popFrom(std::deque<Entry>& tasks, bool fromBack, const void* group, Task& task);
+        bool tryPop(Task& task, const void* group);
+        void workerLoop(u32 index);
+    };
+
+
+    /**
+     * A set of tasks on a ThreadPool that can be waited on together.
+     * \n\n
+     * wait() runs the group's queued tasks until every task of the group has finished,
+     * sleeping while the last ones run on other threads, then rethrows the first
+     * exception one of them threw. A throwing task cancels the group. Cancelled groups
+     * skip tasks that have not started yet, running tasks can poll isCancelled() to stop early.
+     */
+    class TaskGroup {
+        ThreadPool& m_pool;
+        std::mutex m_waitMutex;
+        std::condition_variable m_changed;
+        /// guarded by m_waitMutex, as is m_submitted
+        size_t m_active = 0;
+        /// counts run() calls, so a waiter notices tasks queued while it checked the pool
+        u64 m_submitted = 0;
+        std::atomic<bool> m_cancelled{false};
+        std::mutex m_errorMutex;
+        std::exception_ptr m_error;
+
+    public:
+        explicit TaskGroup(ThreadPool& pool = ThreadPool::instance());
+
+        /// waits for every task, errors that were never collected by wait() are dropped
+        ~TaskGroup();
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        void run(std::function<void()> func);
+
+        /// blocks until every task has finished, rethrows the first exception
+        void wait();
+
+        void cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+
+        ND bool isCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+
+    private:
+        void setError(std::exception_ptr error);
+    };
+
+
+    /**
+     * Calls func(index) for every index in [0, count) on the shared ThreadPool.
+     * Indices are handed out dynamically, so uneven work (like empty chunks)
+     * balances itself out. Safe to call from inside another parallel_for.
+     * \n
+     * The first exception thrown by func stops the loop and is rethrown on the
+     * calling thread once every running call has finished.
+     * @param count how many indices to process
+     * @param func the function to call for each index
+     * @param threadCount how many threads may work on the loop, 0 uses the whole pool
+     */
+    void parallel_for(size_t count, const std::function<void(size_t)>& func, u32 threadCount = 0);
+
+
+} // namespace editor
@@ -1,77 +1,104 @@
 #pragma once
 
+#include <cstring>
+
 #include "include/lce/processor.hpp"
 
-#include "../data/DataReader.hpp"
-#include "../data/DataWriter.hpp"
+#include "rle_scan.hpp"
 
 
 namespace codec {
 
-    static void RLE_decompress(u8* dataIn, c_u32 sizeIn, u8* dataOut, u32& sizeOut) {
-        // DataManager managerIn(dataIn, sizeIn);
-        // DataManager managerOut(dataOut, sizeOut);
+    /**
+     * The most RLE_compress can write for sizeIn bytes.
+     * A lone 255 becomes two bytes, anything else stays the same size or shrinks.
+     */
+    constexpr u32 RLE_compressBound(c_u32 sizeIn) { return sizeIn * 2; }
+
 
-        // dataIn, indexIn, sizeIn
-        // dataOut, indexOut, sizeOut
+    /**
+     * Decodes the chunk RLE format: any byte but 255 is itself, "255 n" is n + 1 times 255
+     * for n < 3, and "255 n v" is n + 1 times v. Literals are copied in bulk up to the next
+     * 255, and runs are filled with memset.
+     *
+     * @param dataIn the encoded data
+     * @param sizeIn its size
+     * @param dataOut where the decoded data goes, decoded in place with no intermediate buffer
+     * @param sizeOut the capacity of dataOut, set to the decoded size
+     * @return false if dataIn is cut short or decodes to more than the capacity
+     */
+    static bool RLE_decompress(c_u8* dataIn, c_u32 sizeIn, u8* dataOut, u32& sizeOut) {
+        c_u32 capacity = sizeOut;
         u32 indexIn = 0;
         u32 indexOut = 0;
+        sizeOut = 0;
 
         while (indexIn < sizeIn) {
-            if (c_u8 byte1 = dataIn[indexIn++]; byte1 != 255) {
-                dataOut[indexOut++] = byte1;
-            } else {
-                c_u8 byte2 = dataIn[indexIn++];
-                u8 value = 255;
-                if (byte2 >= 3) {
-                    value = dataIn[indexIn++];
-                }
-                for (int j = 0; j <= static_cast<int>(byte2); j++) {
-                    dataOut[indexOut++] = value;
-                }
+            c_u32 literalEnd = detail::findByte(dataIn, indexIn, sizeIn, 255);
+            c_u32 literals = literalEnd - indexIn;
+            if (literals > capacity - indexOut) { return false; }
+            std::memcpy(dataOut + indexOut, dataIn + indexIn, literals);
+            indexOut += literals;
+            indexIn = literalEnd;
+            if (indexIn == sizeIn) { break; }
+
+            if (sizeIn - indexIn < 2) { return false; }
+            c_u8 countMinusOne = dataIn[indexIn + 1];
+            indexIn += 2;
+            u8 value = 255;
+            if (countMinusOne >= 3) {
+                if (indexIn == sizeIn) { return false; }
+                value = dataIn[indexIn++];
             }
+
+            c_u32 count = countMinusOne + 1;
+            if (count > capacity - indexOut) { return false; }
+            std::memset(dataOut + indexOut, value, count);
+            indexOut += count;
         }
         sizeOut = indexOut;
+        return true;
     }
 
 
-    static void RLE_compress(c_u8* dataIn, c_u32 sizeIn, u8* dataOut, u32& sizeOut) {
-        u32 dataIndex = 0;
+    /**
+     * Encodes into the format RLE_decompress reads. Runs of 4 or more bytes, and every
+     * 255, are encoded, the stretches in between are copied in bulk.
+     *
+     * @param dataIn the data to encode
+     * @param sizeIn its size
+     * @param dataOut where the encoded data goes, RLE_compressBound(sizeIn) always fits
+     * @param sizeOut the capacity of dataOut, set to the encoded size
+     * @return false if the encoded data does not fit
+     */
+    static bool RLE_compress(c_u8* dataIn, c_u32 sizeIn, u8* dataOut, u32& sizeOut) {
+        c_u32 capacity = sizeOut;
+        u32 indexIn = 0;
+        u32 indexOut = 0;
         sizeOut = 0;
 
-        while (dataIndex < sizeIn) {
-            c_u8 value = dataIn[dataIndex];
-            u32 count = 1;
-
-            // Count the run of the same byte
-            while (dataIndex + count < sizeIn && dataIn[dataIndex + count] == value && count < 256) {
-                count++;
-            }
+        while (indexIn < sizeIn) {
+            c_u32 literalEnd = detail::findRunOrByte(dataIn, indexIn, sizeIn, 255);
+            c_u32 literals = literalEnd - indexIn;
+            if (literals > capacity - indexOut) { return false; }
+            std::memcpy(dataOut + indexOut, dataIn + indexIn, literals);
+            indexOut += literals;
+            indexIn = literalEnd;
+            if (indexIn == sizeIn) { break; }
 
-            if (value == 255) {
-                if (count < 4) {
-                    dataOut[sizeOut++] = 255;
-                    dataOut[sizeOut++] = count - 1;
-                } else {
-                    dataOut[sizeOut++] = 255;
-                    dataOut[sizeOut++] = count - 1;
-                    dataOut[sizeOut++] = value;
-                }
-            } else {
-                if (count >= 4) {
-                    // If run length is 4 or more, encode it
-                    dataOut[sizeOut++] = 255;
-                    dataOut[sizeOut++] = count - 1;
-                    dataOut[sizeOut++] = value;
-                } else {
-                    // Else write the bytes directly
-                    for (u32 i = 0; i < count; ++i) {
-                        dataOut[sizeOut++] = value;
-                    }
-                }
+            c_u8 value = dataIn[indexIn];
+            c_u32 count = detail::runLength(dataIn, indexIn, sizeIn, 256);
+            // short runs of 255 leave the value out
+            c_u32 encodedSize = value == 255 && count < 4 ? 2 : 3;
+            if (encodedSize > capacity - indexOut) { return false; }
+            dataOut[indexOut++] = 255;
+            dataOut[indexOut++] = static_cast<u8>(count - 1);
+            if (encodedSize == 3) {
+                dataOut[indexOut++] = value;
             }
-
-            dataIndex += count;
+            indexIn += count;
         }
+        sizeOut = indexOut;
+        return true;
     }
 }
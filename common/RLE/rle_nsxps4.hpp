@@ -1,84 +1,102 @@
 #pragma once
 
+#include <cstring>
+
 #include "include/lce/processor.hpp"
 
-#include "../data/DataReader.hpp"
-#include "../data/DataWriter.hpp"
+#include "rle_scan.hpp"
 
 
 namespace codec {
 
+    /// the longest zero run one token can hold, "0 0 255 255"
+    static constexpr u32 RLE_NSXPS4_MAX_RUN = 65535 + 256;
+
+
     /**
-     * A form of RLE decompression.
+     * The most RLE_NSXPS4_COMPRESS can write for sizeIn bytes.
+     * A lone zero becomes two bytes, anything else stays the same size or shrinks.
+     */
+    constexpr u32 RLE_NSXPS4_compressBound(c_u32 sizeIn) { return sizeIn * 2; }
+
+
+    /**
+     * A form of RLE decompression. Any byte but 0 is itself, "0 n" is n zeros and
+     * "0 0 hi lo" is (hi << 8 | lo) + 256 zeros. Decodes in place: literals are copied
+     * in bulk up to the next zero and runs are filled with memset.
      *
      * @param dataIn buffer_in to parseLayer from
      * @param sizeIn buffer_in size
      * @param dataOut a pointer to allocated buffer_out
      * @param sizeOut the size of the allocated buffer_out
+     * @return the decoded size, 0 if dataIn is cut short or does not fit in sizeOut
      */
     static u32 RLE_NSX_OR_PS4_DECOMPRESS(c_u8* dataIn, c_u32 sizeIn, u8* dataOut, c_u32 sizeOut) {
-        DataReader reader(dataIn, sizeIn);
-        DataWriter writer(sizeOut);
-
-        while (reader.tell() < sizeIn) {
-
-            if (c_u8 value = reader.read<u8>(); value != 0x00) {
-                writer.write<u8>(value);
-
-            } else {
-                int numZeros = reader.read<u8>();
-
-                if (numZeros == 0) {
-                    c_int numZeros1 = reader.read<u8>();
-                    c_int numZeros2 = reader.read<u8>();
-                    numZeros = numZeros1 << 8 | numZeros2;
-                    numZeros += 256;
-                }
-
-                writer.writePad(numZeros, 0);
+        u32 indexIn = 0;
+        u32 indexOut = 0;
+
+        while (indexIn < sizeIn) {
+            c_u32 literalEnd = detail::findByte(dataIn, indexIn, sizeIn, 0);
+            c_u32 literals = literalEnd - indexIn;
+            if (literals > sizeOut - indexOut) { return 0; }
+            std::memcpy(dataOut + indexOut, dataIn + indexIn, literals);
+            indexOut += literals;
+            indexIn = literalEnd;
+            if (indexIn == sizeIn) { break; }
+
+            if (sizeIn - indexIn < 2) { return 0; }
+            u32 numZeros = dataIn[indexIn + 1];
+            indexIn += 2;
+            if (numZeros == 0) {
+                if (sizeIn - indexIn < 2) { return 0; }
+                numZeros = (dataIn[indexIn] << 8 | dataIn[indexIn + 1]) + 256;
+                indexIn += 2;
             }
-        }
 
-        std::memcpy(dataOut, writer.data(), writer.size());
-        return static_cast<u32>(writer.size());
+            if (numZeros > sizeOut - indexOut) { return 0; }
+            std::memset(dataOut + indexOut, 0, numZeros);
+            indexOut += numZeros;
+        }
+        return indexOut;
     }
 
 
     /**
-     * A form of RLE compression.
+     * A form of RLE compression, the inverse of RLE_NSX_OR_PS4_DECOMPRESS.
      *
      * @param dataIn buffer_in to parseLayer from
      * @param sizeIn buffer_in size
      * @param dataOut a pointer to allocated buffer_out
-     * @param sizeOut the size of the allocated buffer_out
+     * @param sizeOut the size of the allocated buffer_out, RLE_NSXPS4_compressBound(sizeIn) always fits
+     * @return the encoded size, 0 if it does not fit in sizeOut
      */
-    MU static u32 RLE_NSXPS4_COMPRESS(c_u8* dataIn, c_u32 sizeIn, u8* dataOut, u32 sizeOut) {
-        u32 dataIndex = 0;
-        sizeOut = 0;
-
-        while (dataIndex < sizeIn) {
-            if (c_u8 value = dataIn[dataIndex]; value != 0) {
-                dataOut[sizeOut++] = value;
-                continue;
-            }
-
-            u32 runCount = 1;
-            while (dataIndex + runCount < sizeIn && dataIn[dataIndex + runCount] == 0) {
-                runCount++;
-            }
-
+    MU static u32 RLE_NSXPS4_COMPRESS(c_u8* dataIn, c_u32 sizeIn, u8* dataOut, c_u32 sizeOut) {
+        u32 indexIn = 0;
+        u32 indexOut = 0;
+
+        while (indexIn < sizeIn) {
+            c_u32 literalEnd = detail::findByte(dataIn, indexIn, sizeIn, 0);
+            c_u32 literals = literalEnd - indexIn;
+            if (literals > sizeOut - indexOut) { return 0; }
+            std::memcpy(dataOut + indexOut, dataIn + indexIn, literals);
+            indexOut += literals;
+            indexIn = literalEnd;
+            if (indexIn == sizeIn) { break; }
+
+            c_u32 runCount = detail::runLength(dataIn, indexIn, sizeIn, RLE_NSXPS4_MAX_RUN);
             if (runCount < 256) {
-                dataOut[sizeOut++] = 0;
-                dataOut[sizeOut++] = runCount;
+                if (sizeOut - indexOut < 2) { return 0; }
+                dataOut[indexOut++] = 0;
+                dataOut[indexOut++] = runCount;
             } else {
-                dataOut[sizeOut++] = 0;
-                dataOut[sizeOut++] = 0;
-                dataOut[sizeOut++] = (runCount >> 8) - 1;
-                dataOut[sizeOut++] = runCount & 255;
+                if (sizeOut - indexOut < 4) { return 0; }
+                dataOut[indexOut++] = 0;
+                dataOut[indexOut++] = 0;
+                dataOut[indexOut++] = (runCount >> 8) - 1;
+                dataOut[indexOut++] = runCount & 255;
             }
-
-            dataIndex += runCount;
+            indexIn += runCount;
         }
-        return sizeOut;
+        return indexOut;
     }
-}
\ No newline at end of file
+}
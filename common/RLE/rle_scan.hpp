@@ -0,0 +1,97 @@
+#pragma once
+
+#include <bit>
+
+#include "include/lce/processor.hpp"
+
+#include "../cpu.hpp"
+#if CPU_X86_SIMD
+#include <immintrin.h>
+#endif
+
+
+/**
+ * Scanning kernels shared by the RLE codecs.
+ * They look at 16 bytes per step with SSE2 compares and find the first hit with
+ * a count of trailing zeros, and fall back to plain loops for the tail.
+ * Most runs are shorter than 32 bytes, so AVX2 versions picked at runtime were
+ * slower than these.
+ */
+namespace codec::detail {
+
+
+    /// index of the first byte equal to value in [from, size), or size
+    static inline u32 findByte(c_u8* data, u32 from, c_u32 size, c_u8 value) {
+#if CPU_X86_SIMD
+        const __m128i pattern = _mm_set1_epi8(static_cast<char>(value));
+        for (; from + 16 <= size; from += 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + from));
+            if (c_u32 mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern)); mask != 0) {
+                return from + std::countr_zero(mask);
+            }
+        }
+#endif
+        for (; from < size; from++) {
+            if (data[from] == value) { return from; }
+        }
+        return size;
+    }
+
+
+    /// index of the first byte other than value in [from, size), or size
+    static inline u32 findNotByte(c_u8* data, u32 from, c_u32 size, c_u8 value) {
+#if CPU_X86_SIMD
+        const __m128i pattern = _mm_set1_epi8(static_cast<char>(value));
+        for (; from + 16 <= size; from += 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + from));
+            if (c_u32 mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern)) & 0xFFFF; mask != 0) {
+                return from + std::countr_zero(mask);
+            }
+        }
+#endif
+        for (; from < size; from++) {
+            if (data[from] != value) { return from; }
+        }
+        return size;
+    }
+
+
+    /// how many bytes from `from` on repeat data[from], at most maxCount
+    static inline u32 runLength(c_u8* data, c_u32 from, c_u32 size, c_u32 maxCount) {
+        c_u32 end = size - from > maxCount ? from + maxCount : size;
+        return findNotByte(data, from, end, data[from]) - from;
+    }
+
+
+    /**
+     * index of the first byte in [from, size) that is escape or starts four equal bytes,
+     * or size. These are the bytes RLE_compress cannot copy as they are.
+     */
+    static inline u32 findRunOrByte(c_u8* data, u32 from, c_u32 size, c_u8 escape) {
+#if CPU_X86_SIMD
+        const __m128i pattern = _mm_set1_epi8(static_cast<char>(escape));
+        for (; from + 19 <= size; from += 16) {
+            const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + from));
+            const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + from + 1));
+            const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + from + 2));
+            const __m128i b3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + from + 3));
+            const __m128i run = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, b1), _mm_cmpeq_epi8(b1, b2)),
+                                              _mm_cmpeq_epi8(b2, b3));
+            const __m128i hit = _mm_or_si128(run, _mm_cmpeq_epi8(b0, pattern));
+            if (c_u32 mask = _mm_movemask_epi8(hit); mask != 0) {
+                return from + std::countr_zero(mask);
+            }
+        }
+#endif
+        for (; from < size; from++) {
+            if (data[from] == escape) { return from; }
+            if (from + 3 < size && data[from] == data[from + 1]
+                && data[from] == data[from + 2] && data[from] == data[from + 3]) {
+                return from;
+            }
+        }
+        return size;
+    }
+
+
+} // namespace codec::detail
@@ -1,27 +1,52 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+
 #include "include/lce/processor.hpp"
 
-#include "../data/DataReader.hpp"
-#include "../data/DataWriter.hpp"
+#include "rle_scan.hpp"
 
 namespace codec {
 
+    /**
+     * The most RLEVITA_COMPRESS can write for sizeIn bytes.
+     * A lone zero becomes two bytes, anything else stays the same size or shrinks.
+     */
+    constexpr u32 RLEVITA_compressBound(c_u32 sizeIn) { return sizeIn * 2; }
+
+
+    /**
+     * Any byte but 0 is itself, "0 n" is n zeros. Decodes in place: literals are copied
+     * in bulk up to the next zero and runs are filled with memset.
+     *
+     * @param dataIn buffer_in to parseLayer from
+     * @param sizeIn buffer_in size
+     * @param dataOut a pointer to allocated buffer_out
+     * @param sizeOut the size of the allocated buffer_out
+     * @return the decoded size, 0 if dataIn is cut short or does not fit in sizeOut
+     */
     static u32 RLEVITA_DECOMPRESS(c_u8* dataIn, c_u32 sizeIn, u8* dataOut, c_u32 sizeOut) {
-        DataReader managerIn(dataIn, sizeIn);
-        DataWriter managerOut(sizeOut);
+        u32 indexIn = 0;
+        u32 indexOut = 0;
 
-        while (managerIn.tell() < sizeIn) {
+        while (indexIn < sizeIn) {
+            c_u32 literalEnd = detail::findByte(dataIn, indexIn, sizeIn, 0);
+            c_u32 literals = literalEnd - indexIn;
+            if (literals > sizeOut - indexOut) { return 0; }
+            std::memcpy(dataOut + indexOut, dataIn + indexIn, literals);
+            indexOut += literals;
+            indexIn = literalEnd;
+            if (indexIn == sizeIn) { break; }
 
-            if (c_u8 value = managerIn.read<u8>(); value != 0x00) {
-                managerOut.write<u8>(value);
-            } else {
-                c_int numZeros = managerIn.read<u8>();
-                managerOut.writePad(numZeros, 0);
-            }
+            if (sizeIn - indexIn < 2) { return 0; }
+            c_u32 numZeros = dataIn[indexIn + 1];
+            indexIn += 2;
+            if (numZeros > sizeOut - indexOut) { return 0; }
+            std::memset(dataOut + indexOut, 0, numZeros);
+            indexOut += numZeros;
         }
-        std::memcpy(dataOut, managerOut.data(), managerOut.size());
-        return static_cast<u32>(managerOut.size());
+        return indexOut;
     }
 
 
@@ -31,44 +56,32 @@ namespace codec {
      * @param dataIn buffer_in to parseLayer from
      * @param sizeIn buffer_in size
      * @param dataOut a pointer to allocated buffer_out
-     * @param sizeOut the size of the allocated buffer_out
+     * @param sizeOut the size of the allocated buffer_out, RLEVITA_compressBound(sizeIn) always fits
+     * @return the encoded size, 0 if it does not fit in sizeOut
      */
     static u32 RLEVITA_COMPRESS(c_u8* dataIn, c_u32 sizeIn, u8* dataOut, c_u32 sizeOut) {
-        if (sizeOut < 2) {
-            return 0;
-        }
+        u32 indexIn = 0;
+        u32 indexOut = 0;
 
-        DataReader managerIn(dataIn, sizeIn);
-        DataWriter managerOut(sizeOut);
+        while (indexIn < sizeIn) {
+            c_u32 literalEnd = detail::findByte(dataIn, indexIn, sizeIn, 0);
+            c_u32 literals = literalEnd - indexIn;
+            if (literals > sizeOut - indexOut) { return 0; }
+            std::memcpy(dataOut + indexOut, dataIn + indexIn, literals);
+            indexOut += literals;
+            indexIn = literalEnd;
+            if (indexIn == sizeIn) { break; }
 
-        u8 zeroCount = 0;
-
-        for (u32 i = 0; i < sizeIn; ++i) {
-
-            if (c_u8 value = managerIn.read<u8>(); value != 0) {
-                if (zeroCount > 0) {
-                    managerOut.write<u8>(0);
-                    managerOut.write<u8>(zeroCount);
-                    zeroCount = 0;
-                }
-                managerOut.write<u8>(value);
-            } else {
-                zeroCount++;
-                if (zeroCount == 255 || i == sizeIn - 1) {
-                    managerOut.write<u8>(0);
-                    managerOut.write<u8>(zeroCount);
-                    zeroCount = 0;
-                }
+            // runs longer than 255 are split into several tokens
+            u32 runCount = detail::findNotByte(dataIn, indexIn, sizeIn, 0) - indexIn;
+            indexIn += runCount;
+            for (; runCount != 0; runCount -= std::min(runCount, 255U)) {
+                if (sizeOut - indexOut < 2) { return 0; }
+                dataOut[indexOut++] = 0;
+                dataOut[indexOut++] = static_cast<u8>(std::min(runCount, 255U));
             }
         }
-
-        if (zeroCount > 0) {
-            managerOut.write<u8>(0);
-            managerOut.write<u8>(zeroCount);
-        }
-
-        std::memcpy(dataOut, managerOut.data(), managerOut.size());
-        return static_cast<u32>(managerOut.size());
+        return indexOut;
     }
 
 }
@@ -0,0 +1,1081 @@
+#include "XCompress.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstring>
+
+#include "common/error_status.hpp"
+
+
+/**
+ * An LZX encoder for the stream XDecompress and lzx.c read, window_bits 17.
+ * \n\n
+ * Parsing turns the input into tokens, a literal or a match of a length and an offset,
+ * and never lets a match run past the end of its frame, since the decoder checks every
+ * frame on its own. Matches come from hash chains over the input itself, which already
+ * holds the whole window, so a segment only needs the 128 KB in front of it hashed to
+ * reach as far back as the decoder can.
+ * - FAST takes the longest match at each position, or the match at the last offset
+ *   when that is about as long, since it costs only a few bits
+ * - OPTIMAL collects every longer match at each position and picks the cheapest path
+ *   through the frame, first with fixed costs and again with the code lengths that
+ *   the first path produced
+ * \n\n
+ * Writing a frame maps the tokens onto the repeated offsets the decoder will have, builds
+ * length-limited Huffman codes and stores the frame in whichever block type is smallest.
+ */
+namespace codec {
+
+
+    static std::atomic<eXCompressLevel> s_level{eXCompressLevel::FAST};
+
+
+    eXCompressLevel getXCompressLevel() {
+        return s_level.load(std::memory_order_relaxed);
+    }
+
+
+    void setXCompressLevel(const eXCompressLevel level) {
+        s_level.store(level, std::memory_order_relaxed);
+    }
+
+
+    namespace {
+
+
+        constexpr u32 FRAME_SIZE = 0x8000;
+        constexpr u32 SEGMENT_FRAMES = 8;
+        constexpr u32 SEGMENT_SIZE = FRAME_SIZE * SEGMENT_FRAMES;
+
+        /// window_bits 17, what XDecompress and the consoles decode with
+        constexpr u32 WINDOW_SIZE = 1 << 17;
+        /// the farthest back the 34 position slots of that window reach
+        constexpr u32 MAX_OFFSET = WINDOW_SIZE - 3;
+
+        constexpr u32 MIN_MATCH = 2;
+        constexpr u32 MAX_MATCH = 257;
+        /// the shortest match the hash chains look for, 2-byte matches only use repeated offsets
+        constexpr u32 HASH_MATCH = 3;
+
+        constexpr u32 NUM_CHARS = 256;
+        constexpr u32 NUM_SLOTS = 34;
+        constexpr u32 MAIN_SYMBOLS = NUM_CHARS + NUM_SLOTS * 8;
+        constexpr u32 NUM_PRIMARY_LENGTHS = 7;
+        constexpr u32 LENGTH_SYMBOLS = 249;
+        constexpr u32 ALIGNED_SYMBOLS = 8;
+        constexpr u32 PRETREE_SYMBOLS = 20;
+
+        constexpr u32 MAX_CODE_BITS = 16;
+        /// aligned and pretree code lengths are stored in 3 and 4 bits
+        constexpr u32 MAX_ALIGNED_BITS = 7;
+        constexpr u32 MAX_PRETREE_BITS = 15;
+
+        constexpr u32 BLOCK_VERBATIM = 1;
+        constexpr u32 BLOCK_ALIGNED = 2;
+        constexpr u32 BLOCK_UNCOMPRESSED = 3;
+
+        /// the offset history of an empty stream
+        constexpr std::array<u32, 3> INITIAL_REPEATS = {1, 1, 1};
+
+
+        constexpr auto EXTRA_BITS = [] {
+            std::array<u8, NUM_SLOTS> bits{};
+            for (u32 slot = 4; slot < NUM_SLOTS; slot++) {
+                bits[slot] = static_cast<u8>(slot / 2 - 1);
+            }
+            return bits;
+        }();
+
+        constexpr auto POSITION_BASE = [] {
+            std::array<u32, NUM_SLOTS> base{};
+            for (u32 slot = 1; slot < NUM_SLOTS; slot++) {
+                base[slot] = base[slot - 1] + (1U << EXTRA_BITS[slot - 1]);
+            }
+            return base;
+        }();
+
+        static_assert(POSITION_BASE[NUM_SLOTS - 1] + (1U << EXTRA_BITS[NUM_SLOTS - 1]) - 2 == MAX_OFFSET + 1);
+
+
+        /// the slot of an offset plus 2, which is what the slots count in
+        u32 positionSlot(c_u32 formatted) {
+            if (formatted < 4) { return formatted; }
+            c_u32 log = std::bit_width(formatted) - 1;
+            return 2 * log + ((formatted >> (log - 1)) & 1);
+        }
+
+
+        // #####################################################
+        // #               Tokens
+        // #####################################################
+
+        /*
+         * A token is a u32: 0 is a literal, the byte at its position,
+         * anything else is a match with the length above bit 17 and the offset below.
+         */
+
+        constexpr u32 OFFSET_BITS = 17;
+
+        constexpr u32 makeMatch(c_u32 length, c_u32 offset) { return length << OFFSET_BITS | offset; }
+        constexpr u32 tokenLength(c_u32 token) { return token == 0 ? 1 : token >> OFFSET_BITS; }
+        constexpr u32 tokenOffset(c_u32 token) { return token & ((1U << OFFSET_BITS) - 1); }
+
+        static_assert(MAX_OFFSET < 1U << OFFSET_BITS);
+
+
+        /// the bytes a and b have in common, up to max
+        u32 matchLength(c_u8* a, c_u8* b, c_u32 max) {
+            u32 length = 0;
+            while (length + 8 <= max) {
+                u64 x, y;
+                std::memcpy(&x, a + length, 8);
+                std::memcpy(&y, b + length, 8);
+                if (c_u64 diff = x ^ y; diff != 0) {
+                    if constexpr (std::endian::native == std::endian::little) {
+                        return length + (std::countr_zero(diff) >> 3);
+                    } else {
+                        return length + (std::countl_zero(diff) >> 3);
+                    }
+                }
+                length += 8;
+            }
+            while (length < max && a[length] == b[length]) {
+                length++;
+            }
+            return length;
+        }
+
+
+        // #####################################################
+        // #               Match finder
+        // #####################################################
+
+
+        /// hash chains over the positions of one segment and the window in front of it
+        class MatchFinder {
+            std::vector<u32> m_head;
+            /// the previous position with the same hash, relative to m_base, plus 1
+            std::vector<u32> m_chain;
+            c_u8* m_data = nullptr;
+            u32 m_size = 0;
+            u32 m_base = 0;
+            u32 m_hashShift = 0;
+
+            ND u32 hash(c_u32 position) const {
+                c_u8* bytes = m_data + position;
+                c_u32 value = bytes[0] | bytes[1] << 8 | bytes[2] << 16;
+                return (value * 2654435761U) >> m_hashShift;
+            }
+
+        public:
+            /// prepares for the positions base to end, small inputs get a smaller table
+            void reset(c_u8* data, c_u32 size, c_u32 base, c_u32 end) {
+                c_u32 hashBits = std::clamp<u32>(std::bit_width(end - base), 10, 15);
+                m_head.assign(size_t{1} << hashBits, 0);
+                m_chain.resize(end - base);
+                m_data = data;
+                m_size = size;
+                m_base = base;
+                m_hashShift = 32 - hashBits;
+            }
+
+            /// adds a position, each one in order and before any position after it is searched
+            void insert(c_u32 position) {
+                if (position + HASH_MATCH > m_size) { return; }
+                u32& head = m_head[hash(position)];
+                m_chain[position - m_base] = head;
+                head = position - m_base + 1;
+            }
+
+            /**
+             * Visits earlier positions with the same hash, nearest first, until visit returns false.
+             * @param visit called with the offset of each candidate
+             */
+            template<typename Visit>
+            void search(c_u32 position, u32 depth, Visit&& visit) const {
+                if (position + HASH_MATCH > m_size) { return; }
+                u32 candidate = m_head[hash(position)];
+                while (candidate != 0 && depth-- != 0) {
+                    c_u32 offset = position - (candidate - 1 + m_base);
+                    if (offset > MAX_OFFSET || !visit(offset)) { return; }
+                    candidate = m_chain[candidate - 1];
+                }
+            }
+        };
+
+
+        // #####################################################
+        // #               Costs
+        // #####################################################
+
+
+        /// estimated bits of every symbol, for the optimal parse
+        struct CostModel {
+            std::array<u32, MAIN_SYMBOLS> main{};
+            std::array<u32, LENGTH_SYMBOLS> length{};
+
+            /// a guess used before anything is known about the frame
+            void setDefaults() {
+                std::fill_n(main.begin(), NUM_CHARS, 8);
+                std::fill(main.begin() + NUM_CHARS, main.end(), 9);
+                std::fill(length.begin(), length.end(), 7);
+                for (u32 slot = 0; slot < 3; slot++) {
+                    for (u32 header = 0; header < 8; header++) {
+                        main[NUM_CHARS + (slot << 3 | header)] = 6;
+                    }
+                }
+            }
+
+            /// a match of this slot and length, without the extra bits of the offset
+            ND u32 matchCost(c_u32 slot, c_u32 matchSize) const {
+                c_u32 footer = matchSize - MIN_MATCH;
+                if (footer < NUM_PRIMARY_LENGTHS) {
+                    return main[NUM_CHARS + (slot << 3 | footer)];
+                }
+                return main[NUM_CHARS + (slot << 3 | NUM_PRIMARY_LENGTHS)] + length[footer - NUM_PRIMARY_LENGTHS];
+            }
+        };
+
+
+        // #####################################################
+        // #               Huffman codes
+        // #####################################################
+
+
+        /**
+         * In-place minimum redundancy code lengths (Moffat and Katajainen). weights holds
+         * count >= 2 frequencies in ascending order and is overwritten with their code lengths.
+         */
+        void minimumRedundancy(u32* weights, c_i64 count) {
+            i64 root = 0, leaf = 2;
+            weights[0] += weights[1];
+            for (i64 next = 1; next < count - 1; next++) {
+                if (leaf >= count || weights[root] < weights[leaf]) {
+                    weights[next] = weights[root];
+                    weights[root++] = static_cast<u32>(next);
+                } else {
+                    weights[next] = weights[leaf++];
+                }
+                if (leaf >= count || (root < next && weights[root] < weights[leaf])) {
+                    weights[next] += weights[root];
+                    weights[root++] = static_cast<u32>(next);
+                } else {
+                    weights[next] += weights[leaf++];
+                }
+            }
+
+            weights[count - 2] = 0;
+            for (i64 next = count - 3; next >= 0; next--) {
+                weights[next] = weights[weights[next]] + 1;
+            }
+
+            i64 available = 1, used = 0, depth = 0;
+            root = count - 2;
+            i64 next = count - 1;
+            while (available > 0) {
+                while (root >= 0 && weights[root] == depth) {
+                    used++;
+                    root--;
+                }
+                while (available > used) {
+                    weights[next--] = static_cast<u32>(depth);
+                    available--;
+                }
+                available = 2 * used;
+                depth++;
+                used = 0;
+            }
+        }
+
+
+        /**
+         * Complete Huffman code lengths of at most maxBits for the given frequencies.
+         * Unused symbols get 0, and a lone used symbol is paired with another so that
+         * the code stays complete, which the decoder requires unless every length is 0.
+         */
+        void buildLengths(const u32* freqs, c_u32 count, c_u32 maxBits, u8* lens) {
+            thread_local std::vector<u32> t_order;
+            thread_local std::vector<u32> t_weights;
+            t_order.clear();
+            for (u32 sym = 0; sym < count; sym++) {
+                if (freqs[sym] != 0) { t_order.push_back(sym); }
+            }
+            std::fill_n(lens, count, 0);
+
+            if (t_order.empty()) { return; }
+            if (t_order.size() == 1) {
+                lens[t_order[0]] = 1;
+                lens[t_order[0] == 0 ? 1 : 0] = 1;
+                return;
+            }
+
+            std::ranges::sort(t_order, [freqs](c_u32 a, c_u32 b) {
+                return freqs[a] != freqs[b] ? freqs[a] < freqs[b] : a < b;
+            });
+            t_weights.resize(t_order.size());
+            for (size_t i = 0; i < t_order.size(); i++) {
+                t_weights[i] = freqs[t_order[i]];
+            }
+            minimumRedundancy(t_weights.data(), static_cast<i64>(t_weights.size()));
+
+            // too long codes are shortened by moving leaves up the tree until it is complete again
+            std::array<u32, 33> lengthCounts{};
+            for (c_u32 length : t_weights) {
+                lengthCounts[std::min(length, maxBits)]++;
+            }
+            u64 total = 0;
+            for (u32 length = maxBits; length > 0; length--) {
+                total += static_cast<u64>(lengthCounts[length]) << (maxBits - length);
+            }
+            while (total > u64{1} << maxBits) {
+                lengthCounts[maxBits]--;
+                for (u32 length = maxBits - 1; length > 0; length--) {
+                    if (lengthCounts[length] != 0) {
+                        lengthCounts[length]--;
+                        lengthCounts[length + 1] += 2;
+                        break;
+                    }
+                }
+                total--;
+            }
+
+            // the rarest symbols get the longest codes
+            size_t index = 0;
+            for (u32 length = maxBits; length > 0; length--) {
+                for (u32 n = lengthCounts[length]; n > 0; n--) {
+                    lens[t_order[index++]] = static_cast<u8>(length);
+                }
+            }
+        }
+
+
+        /// the canonical codes of the lengths, as the decoder assigns them
+        void buildCodes(const u8* lens, c_u32 count, u16* codes) {
+            std::array<u32, MAX_CODE_BITS + 1> lengthCounts{};
+            for (u32 sym = 0; sym < count; sym++) {
+                lengthCounts[lens[sym]]++;
+            }
+            lengthCounts[0] = 0;
+
+            std::array<u32, MAX_CODE_BITS + 1> nextCode{};
+            u32 code = 0;
+            for (u32 length = 1; length <= MAX_CODE_BITS; length++) {
+                code = (code + lengthCounts[length - 1]) << 1;
+                nextCode[length] = code;
+            }
+            for (u32 sym = 0; sym < count; sym++) {
+                if (lens[sym] != 0) {
+                    codes[sym] = static_cast<u16>(nextCode[lens[sym]]++);
+                }
+            }
+        }
+
+
+        // #####################################################
+        // #               Bit writer
+        // #####################################################
+
+
+        /// writes bits MSB first in 16-bit little-endian words, into memory known to be large enough
+        class BitWriter {
+            u8* m_out;
+            u8* m_begin;
+            u64 m_bits = 0;
+            u32 m_count = 0;
+
+        public:
+            explicit BitWriter(u8* out) : m_out(out), m_begin(out) {}
+
+            void put(c_u32 value, c_u32 count) {
+                m_bits = m_bits << count | value;
+                m_count += count;
+                while (m_count >= 16) {
+                    m_count -= 16;
+                    c_auto word = static_cast<u16>(m_bits >> m_count);
+                    *m_out++ = static_cast<u8>(word);
+                    *m_out++ = static_cast<u8>(word >> 8);
+                }
+            }
+
+            /// bits written into the current word
+            ND u32 pending() const { return m_count; }
+
+            /// pads the current word with zeros
+            void align() {
+                if (m_count != 0) { put(0, 16 - m_count); }
+            }
+
+            void putBytes(c_u8* data, c_u32 size) {
+                std::memcpy(m_out, data, size);
+                m_out += size;
+            }
+
+            void putLE32(c_u32 value) {
+                for (u32 i = 0; i < 4; i++) {
+                    *m_out++ = static_cast<u8>(value >> (8 * i));
+                }
+            }
+
+            ND u32 size() const { return static_cast<u32>(m_out - m_begin); }
+        };
+
+
+        /**
+         * Writes the pretree and then lens, as deltas from prev, runs of zeros and runs of one value.
+         * The decoder reads the main tree in two parts, so a call never covers more than one of them.
+         */
+        void writeLengths(BitWriter& writer, const u8* lens, const u8* prev, c_u32 count) {
+            struct Item {
+                u8 symbol;
+                u8 extra;
+                u8 extraBits;
+                /// the delta that follows symbol 19
+                u8 delta;
+            };
+            std::array<Item, MAIN_SYMBOLS> items{};
+            u32 itemCount = 0;
+            std::array<u32, PRETREE_SYMBOLS> freqs{};
+
+            auto delta = [&](c_u32 index, c_u32 length) {
+                return static_cast<u8>((prev[index] + 17 - length) % 17);
+            };
+
+            u32 index = 0;
+            while (index < count) {
+                c_u8 length = lens[index];
+                u32 run = 1;
+                while (index + run < count && lens[index + run] == length) {
+                    run++;
+                }
+
+                if (length == 0) {
+                    while (run >= 20) {
+                        c_u32 extra = std::min<u32>(run, 51) - 20;
+                        items[itemCount++] = {18, static_cast<u8>(extra), 5, 0};
+                        freqs[18]++;
+                        index += extra + 20;
+                        run -= extra + 20;
+                    }
+                    if (run >= 4) {
+                        items[itemCount++] = {17, static_cast<u8>(run - 4), 4, 0};
+                        freqs[17]++;
+                        index += run;
+                        run = 0;
+                    }
+                } else {
+                    while (run >= 4) {
+                        c_u32 extra = run > 4 ? 1 : 0;
+                        c_u8 value = delta(index, length);
+                        items[itemCount++] = {19, static_cast<u8>(extra), 1, value};
+                        freqs[19]++;
+                        freqs[value]++;
+                        index += 4 + extra;
+                        run -= 4 + extra;
+                    }
+                }
+
+                for (; run > 0; run--, index++) {
+                    c_u8 value = delta(index, length);
+                    items[itemCount++] = {value, 0, 0, 0};
+                    freqs[value]++;
+                }
+            }
+
+            std::array<u8, PRETREE_SYMBOLS> pretreeLens{};
+            std::array<u16, PRETREE_SYMBOLS> pretreeCodes{};
+            buildLengths(freqs.data(), PRETREE_SYMBOLS, MAX_PRETREE_BITS, pretreeLens.data());
+            buildCodes(pretreeLens.data(), PRETREE_SYMBOLS, pretreeCodes.data());
+
+            for (c_u8 length : pretreeLens) {
+                writer.put(length, 4);
+            }
+            for (u32 i = 0; i < itemCount; i++) {
+                const Item& item = items[i];
+                writer.put(pretreeCodes[item.symbol], pretreeLens[item.symbol]);
+                if (item.extraBits != 0) {
+                    writer.put(item.extra, item.extraBits);
+                }
+                if (item.symbol == 19) {
+                    writer.put(pretreeCodes[item.delta], pretreeLens[item.delta]);
+                }
+            }
+        }
+
+
+        // #####################################################
+        // #               Per-thread scratch
+        // #####################################################
+
+
+        /// a frame as symbols, with the offset footer of each match
+        struct Symbol {
+            u16 main;
+            u8 lengthFooter;
+            u8 slot;
+            u32 footer;
+        };
+
+
+        struct ParseScratch {
+            MatchFinder finder;
+            // optimal parsing
+            std::vector<u32> matches;
+            std::vector<u32> matchStart;
+            std::vector<u32> cost;
+            std::vector<u32> via;
+            std::vector<std::array<u32, 3>> repeats;
+            std::vector<u32> path;
+            CostModel model;
+        };
+
+
+        struct WriteScratch {
+            std::vector<Symbol> symbols;
+            std::vector<u8> frame;
+        };
+
+
+        /**
+         * Turns tokens into symbols against the decoder's offset history, which is updated.
+         * @return one past the last token of the frame
+         */
+        const u32* symbolize(const u32* token, c_u32 frameSize, std::array<u32, 3>& repeats,
+                             std::vector<Symbol>& symbols, c_u8* frame) {
+            symbols.clear();
+            u32 position = 0;
+            while (position < frameSize) {
+                c_u32 value = *token++;
+                if (value == 0) {
+                    symbols.push_back({frame[position], 0, 0, 0});
+                    position++;
+                    continue;
+                }
+
+                c_u32 length = tokenLength(value);
+                c_u32 offset = tokenOffset(value);
+                u32 slot, footer = 0;
+                if (offset == repeats[0]) {
+                    slot = 0;
+                } else if (offset == repeats[1]) {
+                    slot = 1;
+                    std::swap(repeats[0], repeats[1]);
+                } else if (offset == repeats[2]) {
+                    slot = 2;
+                    std::swap(repeats[0], repeats[2]);
+                } else {
+                    c_u32 formatted = offset + 2;
+                    slot = positionSlot(formatted);
+                    footer = formatted - POSITION_BASE[slot];
+                    repeats = {offset, repeats[0], repeats[1]};
+                }
+
+                c_u32 lengthHeader = std::min(length - MIN_MATCH, NUM_PRIMARY_LENGTHS);
+                symbols.push_back({
+                        static_cast<u16>(NUM_CHARS + (slot << 3 | lengthHeader)),
+                        static_cast<u8>(length - MIN_MATCH - lengthHeader),
+                        static_cast<u8>(slot), footer});
+                position += length;
+            }
+            return token;
+        }
+
+
+        // #####################################################
+        // #               Parsing
+        // #####################################################
+
+
+        constexpr u32 FAST_DEPTH = 8;
+        constexpr u32 FAST_NICE = 48;
+        /// a 3-byte match farther than this costs more than its literals
+        constexpr u32 FAST_FAR_OFFSET = 16384;
+
+        constexpr u32 OPTIMAL_DEPTH = 48;
+        /// matches at least this long are taken whole, without trying every shorter length
+        constexpr u32 OPTIMAL_NICE = 128;
+        constexpr u32 OPTIMAL_PASSES = 2;
+
+
+        void parseFast(MatchFinder& finder, c_u8* data, c_u32 start, c_u32 end,
+                       std::array<u32, 3>& repeats, std::vector<u32>& tokens) {
+            u32 position = start;
+            while (position < end) {
+                c_u32 maxLength = std::min(MAX_MATCH, end - position);
+                if (maxLength < HASH_MATCH) {
+                    finder.insert(position++);
+                    tokens.push_back(0);
+                    continue;
+                }
+
+                c_u8* current = data + position;
+                c_u32 repeatLength = repeats[0] <= position
+                                             ? matchLength(current, current - repeats[0], maxLength) : 0;
+
+                u32 bestLength = 0, bestOffset = 0;
+                if (repeatLength < FAST_NICE) {
+                    finder.search(position, FAST_DEPTH, [&](c_u32 offset) {
+                        if (current[bestLength] != (current - offset)[bestLength]) { return true; }
+                        c_u32 length = matchLength(current, current - offset, maxLength);
+                        if (length > bestLength) {
+                            bestLength = length;
+                            bestOffset = offset;
+                        }
+                        return length < std::min(FAST_NICE, maxLength);
+                    });
+                }
+
+                u32 length = 1;
+                if (repeatLength >= MIN_MATCH && repeatLength + 1 >= bestLength) {
+                    length = repeatLength;
+                    tokens.push_back(makeMatch(length, repeats[0]));
+                } else if (bestLength > HASH_MATCH || (bestLength == HASH_MATCH && bestOffset <= FAST_FAR_OFFSET)) {
+                    length = bestLength;
+                    tokens.push_back(makeMatch(length, bestOffset));
+                    repeats = {bestOffset, repeats[0], repeats[1]};
+                } else {
+                    tokens.push_back(0);
+                }
+
+                c_u32 matchEnd = position + length;
+                for (; position < matchEnd; position++) {
+                    finder.insert(position);
+                }
+            }
+        }
+
+
+        /// fills model with the code lengths the path would get, unused symbols are guessed long
+        void updateModel(CostModel& model, const std::vector<u32>& path, std::array<u32, 3> repeats,
+                         c_u8* frame, c_u32 frameSize) {
+            thread_local std::vector<Symbol> t_symbols;
+            symbolize(path.data(), frameSize, repeats, t_symbols, frame);
+
+            std::array<u32, MAIN_SYMBOLS> mainFreqs{};
+            std::array<u32, LENGTH_SYMBOLS> lengthFreqs{};
+            for (const Symbol& symbol : t_symbols) {
+                mainFreqs[symbol.main]++;
+                if (symbol.main >= NUM_CHARS && (symbol.main & 7) == NUM_PRIMARY_LENGTHS) {
+                    lengthFreqs[symbol.lengthFooter]++;
+                }
+            }
+            std::array<u8, MAIN_SYMBOLS> mainLens{};
+            std::array<u8, LENGTH_SYMBOLS> lengthLens{};
+            buildLengths(mainFreqs.data(), MAIN_SYMBOLS, MAX_CODE_BITS, mainLens.data());
+            buildLengths(lengthFreqs.data(), LENGTH_SYMBOLS, MAX_CODE_BITS, lengthLens.data());
+            for (u32 sym = 0; sym < MAIN_SYMBOLS; sym++) {
+                model.main[sym] = mainLens[sym] != 0 ? mainLens[sym] : 13;
+            }
+            for (u32 sym = 0; sym < LENGTH_SYMBOLS; sym++) {
+                model.length[sym] = lengthLens[sym] != 0 ? lengthLens[sym] : 10;
+            }
+        }
+
+
+        void parseOptimal(ParseScratch& scratch, c_u8* data, c_u32 start, c_u32 end,
+                          std::array<u32, 3>& repeats, std::vector<u32>& tokens) {
+            c_u32 size = end - start;
+            MatchFinder& finder = scratch.finder;
+
+            // every match longer than the ones before it, at each position
+            scratch.matches.clear();
+            scratch.matchStart.resize(size + 1);
+            u32 skipUntil = start;
+            for (u32 position = start; position < end; position++) {
+                scratch.matchStart[position - start] = static_cast<u32>(scratch.matches.size());
+                c_u32 maxLength = std::min(MAX_MATCH, end - position);
+                if (position >= skipUntil && maxLength >= HASH_MATCH) {
+                    c_u8* current = data + position;
+                    u32 bestLength = HASH_MATCH - 1;
+                    finder.search(position, OPTIMAL_DEPTH, [&](c_u32 offset) {
+                        if (current[bestLength] != (current - offset)[bestLength]) { return true; }
+                        c_u32 length = matchLength(current, current - offset, maxLength);
+                        if (length > bestLength) {
+                            bestLength = length;
+                            scratch.matches.push_back(makeMatch(length, offset));
+                        }
+                        return length < std::min(OPTIMAL_NICE, maxLength);
+                    });
+                    // the positions a long match covers are not worth searching
+                    if (bestLength >= OPTIMAL_NICE) {
+                        skipUntil = position + bestLength;
+                    }
+                }
+                finder.insert(position);
+            }
+            scratch.matchStart[size] = static_cast<u32>(scratch.matches.size());
+
+            scratch.cost.resize(size + 1);
+            scratch.via.resize(size + 1);
+            scratch.repeats.resize(size + 1);
+            scratch.model.setDefaults();
+
+            c_u8* frame = data + start;
+            for (u32 pass = 0; pass < OPTIMAL_PASSES; pass++) {
+                const CostModel& model = scratch.model;
+                u32* cost = scratch.cost.data();
+                u32* via = scratch.via.data();
+                auto* nodeRepeats = scratch.repeats.data();
+
+                std::fill_n(cost, size + 1, UINT32_MAX);
+                cost[0] = 0;
+                nodeRepeats[0] = repeats;
+
+                auto relax = [&](c_u32 to, c_u32 newCost, c_u32 token, const std::array<u32, 3>& newRepeats) {
+                    if (newCost < cost[to]) {
+                        cost[to] = newCost;
+                        via[to] = token;
+                        nodeRepeats[to] = newRepeats;
+                    }
+                };
+
+                for (u32 index = 0; index < size; index++) {
+                    c_u32 base = cost[index];
+                    const std::array<u32, 3> current = nodeRepeats[index];
+                    c_u32 position = start + index;
+                    relax(index + 1, base + model.main[frame[index]], 0, current);
+
+                    c_u32 maxLength = std::min(MAX_MATCH, size - index);
+                    if (maxLength < MIN_MATCH) { continue; }
+
+                    u32 longest = 0;
+                    for (u32 slot = 0; slot < 3; slot++) {
+                        c_u32 offset = current[slot];
+                        if (offset > position || (slot != 0 && offset == current[0])
+                            || (slot == 2 && offset == current[1])) { continue; }
+                        c_u32 length = matchLength(frame + index, frame + index - offset, maxLength);
+                        if (length < MIN_MATCH) { continue; }
+                        longest = std::max(longest, length);
+
+                        std::array<u32, 3> next = current;
+                        std::swap(next[0], next[slot]);
+                        c_u32 first = length >= OPTIMAL_NICE ? length : MIN_MATCH;
+                        for (u32 l = first; l <= length; l++) {
+                            relax(index + l, base + model.matchCost(slot, l), makeMatch(l, offset), next);
+                        }
+                    }
+
+                    u32 previous = HASH_MATCH - 1;
+                    c_u32 matchEnd = scratch.matchStart[index + 1];
+                    for (u32 m = scratch.matchStart[index]; m < matchEnd; m++) {
+                        c_u32 length = tokenLength(scratch.matches[m]);
+                        c_u32 offset = tokenOffset(scratch.matches[m]);
+                        c_u32 slot = positionSlot(offset + 2);
+                        c_u32 extra = base + EXTRA_BITS[slot];
+                        const std::array<u32, 3> next = {offset, current[0], current[1]};
+                        c_u32 first = length >= OPTIMAL_NICE ? length : previous + 1;
+                        for (u32 l = first; l <= length; l++) {
+                            relax(index + l, extra + model.matchCost(slot, l), makeMatch(l, offset), next);
+                        }
+                        previous = length;
+                    }
+
+                    // a long match is taken whole, the positions it covers are not expanded
+                    longest = std::max(longest, previous);
+                    if (longest >= OPTIMAL_NICE) {
+                        index += longest - 1;
+                    }
+                }
+
+                // walk back from the end of the frame
+                scratch.path.clear();
+                for (u32 index = size; index > 0; index -= tokenLength(via[index])) {
+                    scratch.path.push_back(via[index]);
+                }
+                std::ranges::reverse(scratch.path);
+
+                if (pass + 1 < OPTIMAL_PASSES) {
+                    updateModel(scratch.model, scratch.path, repeats, frame, size);
+                }
+            }
+
+            tokens.insert(tokens.end(), scratch.path.begin(), scratch.path.end());
+            repeats = scratch.repeats[size];
+        }
+
+
+    } // namespace
+
+
+    // #####################################################
+    // #               LzxCompressor
+    // #####################################################
+
+
+    struct LzxCompressor::State {
+        struct Segment {
+            std::vector<u32> tokens;
+            bool parsed = false;
+        };
+
+        std::span<const u8> data;
+        eXCompressLevel level;
+        /// the input with E8 translation applied, what data points to when it is used
+        std::vector<u8> translated;
+        i32 e8FileSize = 0;
+        std::vector<Segment> segments;
+        u32 nextSegment = 0;
+
+        // what the decoder holds between frames
+        std::array<u8, MAIN_SYMBOLS> mainLens{};
+        std::array<u8, LENGTH_SYMBOLS> lengthLens{};
+        std::array<u32, 3> repeats = INITIAL_REPEATS;
+        bool headerWritten = false;
+        /// an odd-sized uncompressed block is followed by a pad byte, at the start of the next frame
+        bool padPending = false;
+
+        void writeFrame(u32 frameStart, const u32*& token, std::vector<u8>& out);
+    };
+
+
+    /// the inverse of lzx_intel_e8: turns the relative targets of E8 calls into absolute ones
+    static void translateE8(std::span<const u8> dataIn, c_i32 fileSize, std::vector<u8>& out) {
+        out.assign(dataIn.begin(), dataIn.end());
+        c_auto size = static_cast<u32>(out.size());
+        // the decoder stops translating after 32768 frames
+        for (u32 frameStart = 0, frame = 0; frameStart < size && frame < 32768; frameStart += FRAME_SIZE, frame++) {
+            c_u32 frameEnd = std::min(size, frameStart + FRAME_SIZE);
+            if (frameEnd - frameStart <= 10) { break; }
+            for (u32 pos = frameStart; pos < frameEnd - 10; pos++) {
+                if (out[pos] != 0xE8) { continue; }
+                c_i32 curpos = static_cast<i32>(pos);
+                i32 rel;
+                std::memcpy(&rel, &out[pos + 1], 4);
+                if (rel >= -curpos && rel < fileSize) {
+                    c_i32 abs = rel < fileSize - curpos ? rel + curpos : rel - fileSize;
+                    std::memcpy(&out[pos + 1], &abs, 4);
+                }
+                pos += 4;
+            }
+        }
+    }
+
+
+    LzxCompressor::LzxCompressor(const std::span<const u8> dataIn, const eXCompressLevel level, c_u32 e8FileSize)
+        : m_state(std::make_unique<State>()) {
+        m_state->data = dataIn;
+        m_state->level = level;
+        if (e8FileSize != 0) {
+            m_state->e8FileSize = static_cast<i32>(e8FileSize);
+            translateE8(dataIn, m_state->e8FileSize, m_state->translated);
+            m_state->data = m_state->translated;
+        }
+        m_state->segments.resize((dataIn.size() + SEGMENT_SIZE - 1) / SEGMENT_SIZE);
+    }
+
+
+    LzxCompressor::~LzxCompressor() = default;
+
+
+    u32 LzxCompressor::segmentCount() const {
+        return static_cast<u32>(m_state->segments.size());
+    }
+
+
+    void LzxCompressor::parseSegment(const u32 index) {
+        thread_local ParseScratch t_scratch;
+        State::Segment& segment = m_state->segments[index];
+        c_u8* data = m_state->data.data();
+        c_auto size = static_cast<u32>(m_state->data.size());
+
+        c_u32 segmentStart = index * SEGMENT_SIZE;
+        c_u32 segmentEnd = std::min(size, segmentStart + SEGMENT_SIZE);
+        c_u32 windowStart = segmentStart > MAX_OFFSET ? segmentStart - MAX_OFFSET : 0;
+
+        MatchFinder& finder = t_scratch.finder;
+        finder.reset(data, size, windowStart, segmentEnd);
+        for (u32 position = windowStart; position < segmentStart; position++) {
+            finder.insert(position);
+        }
+
+        // the history the decoder really has is only known when writing, this is a guess
+        std::array<u32, 3> repeats = INITIAL_REPEATS;
+        segment.tokens.clear();
+        segment.tokens.reserve(segmentEnd - segmentStart);
+        for (u32 frameStart = segmentStart; frameStart < segmentEnd; frameStart += FRAME_SIZE) {
+            c_u32 frameEnd = std::min(segmentEnd, frameStart + FRAME_SIZE);
+            if (m_state->level == eXCompressLevel::OPTIMAL) {
+                parseOptimal(t_scratch, data, frameStart, frameEnd, repeats, segment.tokens);
+            } else {
+                parseFast(finder, data, frameStart, frameEnd, repeats, segment.tokens);
+            }
+        }
+        segment.parsed = true;
+    }
+
+
+    int LzxCompressor::writeSegment(const u32 index, std::vector<u8>& out) {
+        if (index != m_state->nextSegment || index >= m_state->segments.size()
+            || !m_state->segments[index].parsed) {
+            return COMPRESS;
+        }
+
+        State::Segment& segment = m_state->segments[index];
+        c_u32 segmentStart = index * SEGMENT_SIZE;
+        c_u32 segmentEnd = std::min(static_cast<u32>(m_state->data.size()), segmentStart + SEGMENT_SIZE);
+        const u32* token = segment.tokens.data();
+        for (u32 frameStart = segmentStart; frameStart < segmentEnd; frameStart += FRAME_SIZE) {
+            m_state->writeFrame(frameStart, token, out);
+        }
+
+        segment.tokens = {};
+        m_state->nextSegment++;
+        return SUCCESS;
+    }
+
+
+    void LzxCompressor::State::writeFrame(c_u32 frameStart, const u32*& token, std::vector<u8>& out) {
+        thread_local WriteScratch t_scratch;
+        c_u32 frameSize = std::min(static_cast<u32>(data.size()) - frameStart, FRAME_SIZE);
+        c_u8* frame = data.data() + frameStart;
+        c_bool isLast = frameStart + frameSize == data.size();
+
+        std::vector<Symbol>& symbols = t_scratch.symbols;
+        std::array<u32, 3> newRepeats = repeats;
+        token = symbolize(token, frameSize, newRepeats, symbols, frame);
+
+        std::array<u32, MAIN_SYMBOLS> mainFreqs{};
+        std::array<u32, LENGTH_SYMBOLS> lengthFreqs{};
+        std::array<u32, ALIGNED_SYMBOLS> alignedFreqs{};
+        for (const Symbol& symbol : symbols) {
+            mainFreqs[symbol.main]++;
+            if (symbol.main < NUM_CHARS) { continue; }
+            if ((symbol.main & 7) == NUM_PRIMARY_LENGTHS) {
+                lengthFreqs[symbol.lengthFooter]++;
+            }
+            if (EXTRA_BITS[symbol.slot] >= 3) {
+                alignedFreqs[symbol.footer & 7]++;
+            }
+        }
+
+        std::array<u8, MAIN_SYMBOLS> newMainLens{};
+        std::array<u8, LENGTH_SYMBOLS> newLengthLens{};
+        std::array<u8, ALIGNED_SYMBOLS> alignedLens{};
+        buildLengths(mainFreqs.data(), MAIN_SYMBOLS, MAX_CODE_BITS, newMainLens.data());
+        buildLengths(lengthFreqs.data(), LENGTH_SYMBOLS, MAX_CODE_BITS, newLengthLens.data());
+        buildLengths(alignedFreqs.data(), ALIGNED_SYMBOLS, MAX_ALIGNED_BITS, alignedLens.data());
+
+        // aligned blocks trade 3 verbatim bits of each far offset for a Huffman code, plus the tree
+        i64 alignedSaving = -static_cast<i64>(ALIGNED_SYMBOLS * 3);
+        for (u32 sym = 0; sym < ALIGNED_SYMBOLS; sym++) {
+            alignedSaving += static_cast<i64>(alignedFreqs[sym]) * (3 - static_cast<i64>(alignedLens[sym]));
+        }
+        c_u32 blockType = alignedSaving > 0 ? BLOCK_ALIGNED : BLOCK_VERBATIM;
+
+        std::array<u16, MAIN_SYMBOLS> mainCodes{};
+        std::array<u16, LENGTH_SYMBOLS> lengthCodes{};
+        std::array<u16, ALIGNED_SYMBOLS> alignedCodes{};
+        buildCodes(newMainLens.data(), MAIN_SYMBOLS, mainCodes.data());
+        buildCodes(newLengthLens.data(), LENGTH_SYMBOLS, lengthCodes.data());
+        buildCodes(alignedLens.data(), ALIGNED_SYMBOLS, alignedCodes.data());
+
+        // a literal takes at most 16 bits, a match of 2 or more bytes at most 16 + 16 + 17
+        std::vector<u8>& scratch = t_scratch.frame;
+        scratch.resize(FRAME_SIZE * 4);
+
+        u32 prefix = padPending ? 1 : 0;
+        scratch[0] = 0;
+        BitWriter writer(scratch.data() + prefix);
+        auto writeBlockHeader = [&](c_u32 type) {
+            if (!headerWritten) {
+                writer.put(e8FileSize != 0, 1);
+                if (e8FileSize != 0) {
+                    writer.put(static_cast<u32>(e8FileSize) >> 16, 16);
+                    writer.put(static_cast<u32>(e8FileSize) & 0xFFFF, 16);
+                }
+            }
+            writer.put(type, 3);
+            writer.put(frameSize >> 8, 16);
+            writer.put(frameSize & 0xFF, 8);
+        };
+
+        writeBlockHeader(blockType);
+        if (blockType == BLOCK_ALIGNED) {
+            for (c_u8 length : alignedLens) {
+                writer.put(length, 3);
+            }
+        }
+        writeLengths(writer, newMainLens.data(), mainLens.data(), NUM_CHARS);
+        writeLengths(writer, newMainLens.data() + NUM_CHARS, mainLens.data() + NUM_CHARS, MAIN_SYMBOLS - NUM_CHARS);
+        writeLengths(writer, newLengthLens.data(), lengthLens.data(), LENGTH_SYMBOLS);
+
+        for (const Symbol& symbol : symbols) {
+            writer.put(mainCodes[symbol.main], newMainLens[symbol.main]);
+            if (symbol.main < NUM_CHARS) { continue; }
+
+            if ((symbol.main & 7) == NUM_PRIMARY_LENGTHS) {
+                writer.put(lengthCodes[symbol.lengthFooter], newLengthLens[symbol.lengthFooter]);
+            }
+            c_u32 extra = EXTRA_BITS[symbol.slot];
+            if (blockType == BLOCK_ALIGNED && extra >= 3) {
+                if (extra > 3) {
+                    writer.put(symbol.footer >> 3, extra - 3);
+                }
+                c_u32 aligned = symbol.footer & 7;
+                writer.put(alignedCodes[aligned], alignedLens[aligned]);
+            } else if (extra != 0) {
+                writer.put(symbol.footer, extra);
+            }
+        }
+        writer.align();
+
+        // 4 bytes of header at most, then the offset history and the bytes themselves
+        u32 compressedSize = prefix + writer.size();
+        if (compressedSize < prefix + 4 + 12 + frameSize) {
+            mainLens = newMainLens;
+            lengthLens = newLengthLens;
+            repeats = newRepeats;
+            padPending = false;
+        } else {
+            writer = BitWriter(scratch.data() + prefix);
+            writeBlockHeader(BLOCK_UNCOMPRESSED);
+            // 1 to 16 bits of padding align the bytes that follow
+            writer.put(0, writer.pending() == 0 ? 16 : 16 - writer.pending());
+            for (c_u32 repeat : repeats) {
+                writer.putLE32(repeat);
+            }
+            writer.putBytes(frame, frameSize);
+            compressedSize = prefix + writer.size();
+            padPending = (frameSize & 1) != 0;
+        }
+        headerWritten = true;
+
+        if (isLast) {
+            out.push_back(0xFF);
+            out.push_back(static_cast<u8>(frameSize >> 8));
+            out.push_back(static_cast<u8>(frameSize));
+        }
+        out.push_back(static_cast<u8>(compressedSize >> 8));
+        out.push_back(static_cast<u8>(compressedSize));
+        out.insert(out.end(), scratch.begin(), scratch.begin() + compressedSize);
+    }
+
+
+    // #####################################################
+    // #               XCompress
+    // #####################################################
+
+
+    int XCompress(const std::span<const u8> dataIn, Buffer& bufferOut, const eXCompressLevel level) {
+        if (dataIn.empty()) { return COMPRESS; }
+
+        thread_local std::vector<u8> t_output;
+        t_output.clear();
+
+        LzxCompressor compressor(dataIn, level);
+        for (u32 index = 0; index < compressor.segmentCount(); index++) {
+            compressor.parseSegment(index);
+            if (c_int status = compressor.writeSegment(index, t_output); status != SUCCESS) {
+                return status;
+            }
+        }
+
+        // dataIn may be bufferOut, so it is only replaced now
+        bufferOut = Buffer(std::make_unique_for_overwrite<u8[]>(t_output.size()), static_cast<u32>(t_output.size()));
+        std::memcpy(bufferOut.data(), t_output.data(), t_output.size());
+        return SUCCESS;
+    }
+
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "include/lce/processor.hpp"
+
+#include "../data/buffer.hpp"
+
+
+namespace codec {
+
+    enum class eXCompressLevel : u8 {
+        /// greedy parsing over short hash chains
+        FAST,
+        /// a cost-based parse over every match length, several times slower
+        OPTIMAL,
+    };
+
+
+    /// the level used when a call does not name one, FAST unless changed
+    MU ND eXCompressLevel getXCompressLevel();
+
+    /// switches every later call that does not name a level, safe to call from any thread
+    MU void setXCompressLevel(eXCompressLevel level);
+
+
+    /**
+     * Writes the framed LZX stream that XDecompress reads, as XMemCompress does:
+     * 32 KB frames, each with a 2-byte compressed size, and a last frame that starts
+     * with 0xFF and its own decompressed size. Every frame holds one block of its own,
+     * verbatim, aligned or uncompressed, whichever is smallest.
+     * \n\n
+     * The input is split into segments of a few frames. Finding the matches of a segment
+     * only reads the input, so segments can be parsed on any number of threads at once;
+     * writing them out is cheap and has to happen in order, since the offset history
+     * and the code lengths of one frame carry on into the next.
+     * \n\n
+     * A single call of XCompress is enough for chunks, larger data can be parsed in parallel:
+     * @code
+     * LzxCompressor compressor(data, level);
+     * parallel_for(compressor.segmentCount(), [&](size_t i) { compressor.parseSegment(i); });
+     * for (u32 i = 0; i < compressor.segmentCount(); i++) { compressor.writeSegment(i, out); }
+     * @endcode
+     */
+    class LzxCompressor {
+        struct State;
+        std::unique_ptr<State> m_state;
+
+    public:
+        /**
+         * @param dataIn must outlive the compressor
+         * @param e8FileSize when not 0, the stream asks the decoder for E8 call translation
+         * with this file size; consoles do not use it, XDecompress does support it
+         */
+        LzxCompressor(std::span<const u8> dataIn, eXCompressLevel level = getXCompressLevel(), u32 e8FileSize = 0);
+        ~LzxCompressor();
+
+        LzxCompressor(const LzxCompressor&) = delete;
+        LzxCompressor& operator=(const LzxCompressor&) = delete;
+
+        ND u32 segmentCount() const;
+
+        /// finds the matches of one segment, different segments may be parsed at the same time
+        void parseSegment(u32 index);
+
+        /**
+         * Appends the frames of a parsed segment to out and frees its matches.
+         * Segments must be written in order, each one exactly once.
+         * @return SUCCESS, or COMPRESS if the segment is out of order or was not parsed
+         */
+        ND int writeSegment(u32 index, std::vector<u8>& out);
+    };
+
+
+    /// the most XCompress can write for sizeIn bytes, when every frame is stored
+    constexpr u32 XCompressBound(c_u32 sizeIn) { return sizeIn + (sizeIn / 0x8000 + 1) * 24; }
+
+
+    /**
+     * Compresses dataIn on the calling thread, into the format XDecompress reads.
+     *
+     * @param dataIn the data to compress, it may be bufferOut itself
+     * @param bufferOut set to the compressed data
+     * @param level how hard to look for matches
+     * @return SUCCESS, or COMPRESS if dataIn is empty, which the format cannot hold
+     */
+    ND int XCompress(std::span<const u8> dataIn, Buffer& bufferOut, eXCompressLevel level = getXCompressLevel());
+
+}
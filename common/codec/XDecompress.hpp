@@ -45,67 +45,84 @@ namespace codec {
 
         ND lzx_state* get() const noexcept { return ptr; }
         explicit operator bool() const noexcept { return ptr != nullptr; }
+
+        /// readies the state for a new stream, the window and tables are kept
+        void reset() const noexcept { lzx_reset(ptr); }
+
+        /// the decompressor of the calling thread, allocated once and reset for every stream
+        static LzxDecompressor& forThread() {
+            thread_local LzxDecompressor t_lzx;
+            return t_lzx;
+        }
     private:
         lzx_state* ptr{};
     };
 
 
+    /**
+     * Decompresses XMemCompress output: 32 KB frames, each with a 2-byte compressed size,
+     * and a last frame that starts with 0xFF and its own decompressed size.
+     * The frames are decoded straight into dataOut, which also serves as the LZX window,
+     * unless the stream uses E8 translation, which keeps the window apart.
+     *
+     * @param sizeOut the capacity of dataOut, set to the decompressed size, 0 on failure
+     */
     ND static XmemErr XDecompress(const u8* dataIn, u32 sizeIn, u8* dataOut, u32* sizeOut) {
-        static constexpr int32_t CHUNK_SIZE = 0x8000;
+        static constexpr u32 CHUNK_SIZE = 0x8000;
 
-        DataReader reader(dataIn, sizeIn);
-        DataWriter writer(*sizeOut);
+        c_u32 capacity = *sizeOut;
+        *sizeOut = 0;
 
-        u8 dst[CHUNK_SIZE] = {0};
-        u8 src[CHUNK_SIZE * 2] = {0};
-
-        LzxDecompressor lzx;
+        LzxDecompressor& lzx = LzxDecompressor::forThread();
         if (!lzx) {
-            *sizeOut = 0;
             return XmemErr::LzxInit;
         }
+        lzx.reset();
 
-        auto bail = [&](XmemErr e){ *sizeOut = 0; return e; };
+        DataReader reader(dataIn, sizeIn);
+        u32 written = 0;
 
         bool last = false;
         while (!last) {
-            int dst_size = CHUNK_SIZE;
+            u32 dst_size = CHUNK_SIZE;
 
+            if (!reader.canRead(1))
+                return XmemErr::Overflow;
             if EXPECT_FALSE(reader.peek() == 0xFF) {
                 if (!reader.canRead(3))
-                    return bail(XmemErr::Overflow);
+                    return XmemErr::Overflow;
                 reader.read<u8>(); // consume the 0xFF byte
                 dst_size = reader.read<u16>();
                 last = true;
             }
 
             if (!reader.canRead(2))
-                return bail(XmemErr::Overflow);
+                return XmemErr::Overflow;
 
-            int src_size = reader.read<u16>();
+            c_u32 src_size = reader.read<u16>();
 
             // validate dst_size and src_size
             if (src_size == 0 || src_size > CHUNK_SIZE * 2 ||
                 dst_size == 0 || dst_size > CHUNK_SIZE) {
-                return bail(XmemErr::BadData);
+                return XmemErr::BadData;
             }
-
-            // read data into the buffer,
             if (!reader.canRead(src_size))
-                return bail(XmemErr::Overflow);
-            reader.readBytes(src_size, src);
-
-            // then decompress the data.
-            c_int lzx_error = lzx_decompress(lzx.get(), src, dst, src_size, dst_size);
-            if (lzx_error == 0) {
-                writer.writeBytes(dst, dst_size);
-            } else {
-                return bail(XmemErr::LzxRun);
+                return XmemErr::Overflow;
+            if (dst_size > capacity - written)
+                return XmemErr::BufferTooSmall;
+
+            // lzx only reads the input, and never past src_size
+            c_int lzx_error = lzx_decompress_flat(lzx.get(), const_cast<u8*>(reader.ptr()), static_cast<int>(src_size),
+                                                  dataOut, static_cast<int>(written), static_cast<int>(dst_size),
+                                                  static_cast<int>(capacity));
+            if (lzx_error != 0) {
+                return XmemErr::LzxRun;
             }
+            reader.skip(src_size);
+            written += dst_size;
         }
 
-        std::memcpy(dataOut, writer.data(), writer.size());
-        *sizeOut = writer.tell();
+        *sizeOut = written;
         return XmemErr::Ok;
     }
 }
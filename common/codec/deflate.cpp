@@ -0,0 +1,96 @@
+#include "deflate.hpp"
+
+#include <cstring>
+#include <vector>
+
+#include "include/zlib-1.2.12/zlib.h"
+
+#include "common/error_status.hpp"
+
+
+namespace codec {
+
+
+    namespace {
+
+        /// a deflate state and its output scratch, reused by every call on one thread
+        class DeflateContext {
+            z_stream m_stream{};
+            bool m_ready = false;
+
+        public:
+            std::vector<u8> scratch;
+
+            /// @param windowBits 15 for a zlib stream, -15 for raw deflate data
+            explicit DeflateContext(c_int windowBits) {
+                m_ready = deflateInit2(&m_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                       windowBits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+            }
+
+            ~DeflateContext() {
+                if (m_ready) { deflateEnd(&m_stream); }
+            }
+
+            DeflateContext(const DeflateContext&) = delete;
+            DeflateContext& operator=(const DeflateContext&) = delete;
+
+            /// deflates dataIn into scratch, leaving 4 bytes after it free, @return the bytes written or -1
+            i64 run(const std::span<const u8> dataIn) {
+                if (!m_ready || deflateReset(&m_stream) != Z_OK) { return -1; }
+
+                c_auto bound = deflateBound(&m_stream, static_cast<uLong>(dataIn.size()));
+                if (scratch.size() < bound + 4) {
+                    scratch.resize(bound + 4);
+                }
+
+                m_stream.next_in = const_cast<Bytef*>(dataIn.data());
+                m_stream.avail_in = static_cast<uInt>(dataIn.size());
+                m_stream.next_out = scratch.data();
+                m_stream.avail_out = static_cast<uInt>(bound);
+                if (deflate(&m_stream, Z_FINISH) != Z_STREAM_END) { return -1; }
+                return static_cast<i64>(m_stream.total_out);
+            }
+        };
+
+    } // namespace
+
+
+    int deflateWithContext(const std::span<const u8> dataIn, const eDeflateFormat format, Buffer& bufferOut) {
+        i64 size;
+        DeflateContext* context;
+
+        switch (format) {
+            case eDeflateFormat::ZLIB: {
+                thread_local DeflateContext t_zlib(15);
+                context = &t_zlib;
+                size = context->run(dataIn);
+                break;
+            }
+            case eDeflateFormat::ZLIB_NO_HEADER: {
+                // raw deflate data, so there is no header to cut off afterwards
+                thread_local DeflateContext t_raw(-15);
+                context = &t_raw;
+                size = context->run(dataIn);
+                if (size < 0) { break; }
+                c_u32 adler = adler32(adler32(0, nullptr, 0), dataIn.data(), static_cast<uInt>(dataIn.size()));
+                u8* trailer = context->scratch.data() + size;
+                trailer[0] = static_cast<u8>(adler >> 24);
+                trailer[1] = static_cast<u8>(adler >> 16);
+                trailer[2] = static_cast<u8>(adler >> 8);
+                trailer[3] = static_cast<u8>(adler);
+                size += 4;
+                break;
+            }
+            default:
+                return COMPRESS;
+        }
+        if (size < 0) { return COMPRESS; }
+
+        // only the exact result is allocated, and it is not zeroed first
+        bufferOut = Buffer(std::make_unique_for_overwrite<u8[]>(size), static_cast<u32>(size));
+        std::memcpy(bufferOut.data(), context->scratch.data(), static_cast<size_t>(size));
+        return SUCCESS;
+    }
+
+
+}
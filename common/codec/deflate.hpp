@@ -0,0 +1,33 @@
+#pragma once
+
+#include <span>
+
+#include "include/lce/processor.hpp"
+
+#include "../data/buffer.hpp"
+
+
+namespace codec {
+
+    enum class eDeflateFormat : u8 {
+        /// what compress() writes: 2-byte header, deflate data, big-endian Adler-32
+        ZLIB,
+        /// the ZLIB format without its header, as PS3 chunks store it
+        ZLIB_NO_HEADER,
+    };
+
+
+    /**
+     * Deflates with the default level, like compress(), but with a deflate state that
+     * belongs to the calling thread. The state is reset between calls instead of being
+     * allocated for each one, and the output goes through a scratch buffer the thread
+     * keeps, so only the exact result is allocated.
+     *
+     * @param dataIn the data to compress
+     * @param format the framing around the deflate data
+     * @param bufferOut set to the compressed data
+     * @return SUCCESS or COMPRESS
+     */
+    ND int deflateWithContext(std::span<const u8> dataIn, eDeflateFormat format, Buffer& bufferOut);
+
+}
@@ -0,0 +1,580 @@
+#include "inflate.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+
+#include "include/tinf/tinf.h"
+#include "include/zlib-1.2.12/zlib.h"
+
+#include "common/error_status.hpp"
+
+
+/**
+ * The FAST backend is a single-shot decoder, it always has the whole input and a
+ * fixed output buffer, so it never has to stop in the middle of a symbol:
+ * - a 64-bit bit buffer is refilled 8 bytes at a time, which covers every bit of
+ *   one length and distance pair, so a symbol is decoded without further checks
+ * - the Huffman tables resolve up to 11 bits in one lookup, and where two short
+ *   literal codes fit in those bits one lookup yields both literals
+ * - matches are copied 8 bytes at a time when they do not overlap that closely,
+ *   runs of one byte use memset
+ */
+namespace codec {
+
+
+    static std::atomic<eInflateBackend> s_backend{eInflateBackend::FAST};
+
+
+    eInflateBackend getInflateBackend() {
+        return s_backend.load(std::memory_order_relaxed);
+    }
+
+
+    void setInflateBackend(const eInflateBackend backend) {
+        s_backend.store(backend, std::memory_order_relaxed);
+    }
+
+
+    namespace {
+
+
+        // #####################################################
+        // #               Table entries
+        // #####################################################
+
+        /*
+         * A table entry is a u32:
+         *  bits  0- 4  code bits to consume
+         *  bits  5- 7  kind
+         *  bits  8-11  extra bits of a length or distance, or the index bits of a subtable
+         *  bits 16-31  literal(s), length or distance base, or subtable offset
+         */
+
+        enum : u32 {
+            KIND_LITERAL = 0,
+            /// two literals in one lookup, the first in the low byte of the value
+            KIND_DOUBLE,
+            /// a length or a distance, value is the base and extra bits follow
+            KIND_BASE,
+            KIND_END,
+            KIND_SUBTABLE,
+            KIND_INVALID,
+        };
+
+        constexpr u32 entry(c_u32 kind, c_u32 bits, c_u32 extra, c_u32 value) {
+            return bits | kind << 5 | extra << 8 | value << 16;
+        }
+
+        constexpr u32 entryBits(c_u32 e) { return e & 31; }
+        constexpr u32 entryKind(c_u32 e) { return e >> 5 & 7; }
+        constexpr u32 entryExtra(c_u32 e) { return e >> 8 & 15; }
+        constexpr u32 entryValue(c_u32 e) { return e >> 16; }
+
+        constexpr u32 INVALID_ENTRY = entry(KIND_INVALID, 0, 0, 0);
+
+
+        constexpr u32 LITLEN_TABLE_BITS = 11;
+        constexpr u32 DIST_TABLE_BITS = 8;
+        constexpr u32 CODELEN_TABLE_BITS = 7;
+        constexpr u32 MAX_CODE_BITS = 15;
+
+        // the primary table plus the worst case of subtables, every long code in its own
+        constexpr u32 LITLEN_TABLE_SIZE = (1 << LITLEN_TABLE_BITS) + 288 * (1 << (MAX_CODE_BITS - LITLEN_TABLE_BITS));
+        constexpr u32 DIST_TABLE_SIZE = (1 << DIST_TABLE_BITS) + 32 * (1 << (MAX_CODE_BITS - DIST_TABLE_BITS));
+        constexpr u32 CODELEN_TABLE_SIZE = 1 << CODELEN_TABLE_BITS;
+
+
+        constexpr u16 LENGTH_BASE[29] = {
+                3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        constexpr u8 LENGTH_EXTRA[29] = {
+                0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        constexpr u16 DIST_BASE[30] = {
+                1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        constexpr u8 DIST_EXTRA[30] = {
+                0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+        constexpr u8 CODELEN_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+
+        u32 litlenSymbol(c_u32 symbol) {
+            if (symbol < 256) { return entry(KIND_LITERAL, 0, 0, symbol); }
+            if (symbol == 256) { return entry(KIND_END, 0, 0, 0); }
+            if (symbol < 286) {
+                return entry(KIND_BASE, 0, LENGTH_EXTRA[symbol - 257], LENGTH_BASE[symbol - 257]);
+            }
+            return INVALID_ENTRY;
+        }
+
+        u32 distSymbol(c_u32 symbol) {
+            if (symbol < 30) { return entry(KIND_BASE, 0, DIST_EXTRA[symbol], DIST_BASE[symbol]); }
+            return INVALID_ENTRY;
+        }
+
+        u32 codelenSymbol(c_u32 symbol) {
+            return entry(KIND_LITERAL, 0, 0, symbol);
+        }
+
+
+        u32 reverseBits(u32 code, c_u32 length) {
+            u32 reversed = 0;
+            for (u32 bit = 0; bit < length; bit++) {
+                reversed = reversed << 1 | (code & 1);
+                code >>= 1;
+            }
+            return reversed;
+        }
+
+
+        /**
+         * Fills table with the canonical code described by lengths.
+         * Over-subscribed codes are rejected, and so are incomplete ones, except for a
+         * code without symbols or with a single one bit long symbol, as tinf allows.
+         *
+         * @param lengths the code length of each symbol, 0 if it is unused
+         * @param count how many symbols there are
+         * @param tableBits the bits resolved by the primary table
+         * @param table room for the primary table and its subtables
+         * @param symbolEntry what an entry for a symbol holds, without its code bits
+         * @return false if lengths is not a usable code
+         */
+        bool buildTable(c_u8* lengths, c_u32 count, c_u32 tableBits, u32* table, u32 (*symbolEntry)(u32)) {
+            u32 counts[MAX_CODE_BITS + 1] = {};
+            for (u32 symbol = 0; symbol < count; symbol++) {
+                counts[lengths[symbol]]++;
+            }
+            counts[0] = 0;
+
+            u32 maxLength = 0;
+            int left = 1;
+            for (u32 length = 1; length <= MAX_CODE_BITS; length++) {
+                left = (left << 1) - static_cast<int>(counts[length]);
+                if (left < 0) { return false; }
+                if (counts[length] != 0) { maxLength = length; }
+            }
+            if (left > 0 && maxLength > 1) { return false; }
+
+            c_u32 primarySize = 1U << tableBits;
+            std::fill_n(table, primarySize, INVALID_ENTRY);
+            if (maxLength == 0) { return true; }
+
+            u32 nextCode[MAX_CODE_BITS + 1];
+            u32 code = 0;
+            for (u32 length = 1; length <= MAX_CODE_BITS; length++) {
+                code = (code + counts[length - 1]) << 1;
+                nextCode[length] = code;
+            }
+
+            // codes are read from the least significant bit, so tables are indexed by reversed codes
+            struct LongCode { u16 symbol; u16 reversed; u8 length; };
+            LongCode longCodes[288];
+            u32 longCount = 0;
+            u8 subtableBits[1 << LITLEN_TABLE_BITS] = {};
+
+            for (u32 symbol = 0; symbol < count; symbol++) {
+                c_u32 length = lengths[symbol];
+                if (length == 0) { continue; }
+                c_u32 reversed = reverseBits(nextCode[length]++, length);
+
+                if (length <= tableBits) {
+                    c_u32 value = symbolEntry(symbol) | length;
+                    for (u32 index = reversed; index < primarySize; index += 1U << length) {
+                        table[index] = value;
+                    }
+                } else {
+                    c_u32 prefix = reversed & (primarySize - 1);
+                    subtableBits[prefix] = std::max<u8>(subtableBits[prefix], length - tableBits);
+                    longCodes[longCount++] = {static_cast<u16>(symbol), static_cast<u16>(reversed),
+                                              static_cast<u8>(length)};
+                }
+            }
+
+            u32 used = primarySize;
+            for (u32 prefix = 0; prefix < primarySize; prefix++) {
+                if (subtableBits[prefix] == 0) { continue; }
+                table[prefix] = entry(KIND_SUBTABLE, tableBits, subtableBits[prefix], used);
+                std::fill_n(table + used, 1U << subtableBits[prefix], INVALID_ENTRY);
+                used += 1U << subtableBits[prefix];
+            }
+
+            for (u32 index = 0; index < longCount; index++) {
+                const LongCode& longCode = longCodes[index];
+                c_u32 pointer = table[longCode.reversed & (primarySize - 1)];
+                c_u32 length = longCode.length - tableBits;
+                c_u32 value = symbolEntry(longCode.symbol) | length;
+                u32* subtable = table + entryValue(pointer);
+                for (u32 sub = longCode.reversed >> tableBits; sub < 1U << entryExtra(pointer); sub += 1U << length) {
+                    subtable[sub] = value;
+                }
+            }
+            return true;
+        }
+
+
+        /// merges pairs of literals whose codes fit in one primary lookup into KIND_DOUBLE entries
+        void pairLiterals(u32* table) {
+            constexpr u32 PRIMARY_SIZE = 1 << LITLEN_TABLE_BITS;
+            u32 single[PRIMARY_SIZE];
+            std::memcpy(single, table, sizeof(single));
+
+            for (u32 index = 0; index < PRIMARY_SIZE; index++) {
+                c_u32 first = single[index];
+                if (entryKind(first) != KIND_LITERAL) { continue; }
+                c_u32 firstBits = entryBits(first);
+                if (firstBits >= LITLEN_TABLE_BITS) { continue; }
+
+                // the rest of the index is the start of the next code, zero filled
+                c_u32 second = single[index >> firstBits];
+                if (entryKind(second) != KIND_LITERAL
+                    || entryBits(second) > LITLEN_TABLE_BITS - firstBits) { continue; }
+                table[index] = entry(KIND_DOUBLE, firstBits + entryBits(second), 0,
+                                     entryValue(first) | entryValue(second) << 8);
+            }
+        }
+
+
+        struct Tables {
+            u32 litlen[LITLEN_TABLE_SIZE];
+            u32 dist[DIST_TABLE_SIZE];
+        };
+
+
+        /// the tables of the fixed code, built on first use
+        const Tables& fixedTables() {
+            static const Tables tables = [] {
+                Tables fixed{};
+                u8 lengths[288];
+                std::fill_n(lengths, 144, 8);
+                std::fill_n(lengths + 144, 112, 9);
+                std::fill_n(lengths + 256, 24, 7);
+                std::fill_n(lengths + 280, 8, 8);
+                buildTable(lengths, 288, LITLEN_TABLE_BITS, fixed.litlen, litlenSymbol);
+                pairLiterals(fixed.litlen);
+                std::fill_n(lengths, 32, 5);
+                buildTable(lengths, 32, DIST_TABLE_BITS, fixed.dist, distSymbol);
+                return fixed;
+            }();
+            return tables;
+        }
+
+
+        // #####################################################
+        // #               Bit reader
+        // #####################################################
+
+
+        class BitReader {
+            c_u8* m_in;
+            c_u8* m_end;
+            u64 m_bits = 0;
+            u32 m_count = 0;
+            /// zero bytes fed in past the end of the input
+            u32 m_overrun = 0;
+
+        public:
+            BitReader(c_u8* in, c_u32 size) : m_in(in), m_end(in + size) {}
+
+            /// tops the buffer up to at least 56 bits, past the end of the input with zeros
+            void refill() {
+                if (m_end - m_in >= 8) {
+                    u64 word;
+                    std::memcpy(&word, m_in, 8);
+                    if constexpr (std::endian::native == std::endian::big) {
+                        word = std::byteswap(word);
+                    }
+                    m_bits |= word << m_count;
+                    m_in += (63 - m_count) >> 3;
+                    m_count |= 56;
+                    return;
+                }
+                while (m_count <= 56) {
+                    if (m_in < m_end) {
+                        m_bits |= static_cast<u64>(*m_in++) << m_count;
+                    } else {
+                        m_overrun++;
+                    }
+                    m_count += 8;
+                }
+            }
+
+            ND u64 peek() const { return m_bits; }
+
+            void consume(c_u32 bits) {
+                m_bits >>= bits;
+                m_count -= bits;
+            }
+
+            /// reads bits, at most as many as are buffered
+            u32 read(c_u32 bits) {
+                c_u32 value = static_cast<u32>(m_bits & ((1ULL << bits) - 1));
+                consume(bits);
+                return value;
+            }
+
+            /// whether bits past the end of the input have been consumed
+            ND bool overran() const { return m_overrun * 8 > m_count; }
+
+            /// drops the bits up to the next byte, and returns the unread input to byte-wise reading
+            bool alignToByte(c_u8*& in) {
+                consume(m_count & 7);
+                c_u32 buffered = m_count >> 3;
+                if (m_overrun > buffered) { return false; }
+                in = m_in - (buffered - m_overrun);
+                return true;
+            }
+
+            /// continues reading at in, after alignToByte
+            void restart(c_u8* in) {
+                m_in = in;
+                m_bits = 0;
+                m_count = 0;
+                m_overrun = 0;
+            }
+
+            ND c_u8* end() const { return m_end; }
+        };
+
+
+        /// decodes one symbol, the buffer must hold at least 15 bits
+        inline u32 decodeSymbol(BitReader& reader, const u32* table, c_u32 tableBits) {
+            u32 e = table[reader.peek() & ((1U << tableBits) - 1)];
+            if (entryKind(e) == KIND_SUBTABLE) {
+                reader.consume(tableBits);
+                e = table[entryValue(e) + (reader.peek() & ((1U << entryExtra(e)) - 1))];
+            }
+            reader.consume(entryBits(e));
+            return e;
+        }
+
+
+        // #####################################################
+        // #               Decoder
+        // #####################################################
+
+
+        /// copies a match of length bytes from dist bytes back, out has room for length bytes
+        inline void copyMatch(u8* out, c_u32 dist, c_u32 length, c_u8* outEnd) {
+            c_u8* src = out - dist;
+            if (dist >= 8 && static_cast<size_t>(outEnd - out) >= length + 8) {
+                // every word read was written before, the last word may spill into room not yet used
+                u8* const end = out + length;
+                do {
+                    std::memcpy(out, src, 8);
+                    out += 8;
+                    src += 8;
+                } while (out < end);
+            } else if (dist == 1) {
+                std::memset(out, *src, length);
+            } else {
+                for (u32 index = 0; index < length; index++) {
+                    out[index] = src[index];
+                }
+            }
+        }
+
+
+        /// reads the code lengths of a dynamic block and builds its tables
+        bool readDynamicTables(BitReader& reader, Tables& tables) {
+            reader.refill();
+            c_u32 hlit = reader.read(5) + 257;
+            c_u32 hdist = reader.read(5) + 1;
+            c_u32 hclen = reader.read(4) + 4;
+            if (hlit > 286 || hdist > 30) { return false; }
+
+            u8 codelenLengths[19] = {};
+            for (u32 index = 0; index < hclen; index++) {
+                if (index % 8 == 0) { reader.refill(); }
+                codelenLengths[CODELEN_ORDER[index]] = static_cast<u8>(reader.read(3));
+            }
+            u32 codelenTable[CODELEN_TABLE_SIZE];
+            if (!buildTable(codelenLengths, 19, CODELEN_TABLE_BITS, codelenTable, codelenSymbol)) {
+                return false;
+            }
+
+            u8 lengths[286 + 30] = {};
+            for (u32 index = 0; index < hlit + hdist;) {
+                reader.refill();
+                c_u32 e = decodeSymbol(reader, codelenTable, CODELEN_TABLE_BITS);
+                if (entryKind(e) == KIND_INVALID) { return false; }
+                c_u32 symbol = entryValue(e);
+
+                if (symbol < 16) {
+                    lengths[index++] = static_cast<u8>(symbol);
+                    continue;
+                }
+                u8 value = 0;
+                u32 repeat;
+                if (symbol == 16) {
+                    if (index == 0) { return false; }
+                    value = lengths[index - 1];
+                    repeat = 3 + reader.read(2);
+                } else if (symbol == 17) {
+                    repeat = 3 + reader.read(3);
+                } else {
+                    repeat = 11 + reader.read(7);
+                }
+                if (repeat > hlit + hdist - index) { return false; }
+                std::memset(lengths + index, value, repeat);
+                index += repeat;
+            }
+            if (reader.overran()) { return false; }
+            // without an end of block code, the block cannot end
+            if (lengths[256] == 0) { return false; }
+
+            if (!buildTable(lengths, hlit, LITLEN_TABLE_BITS, tables.litlen, litlenSymbol)) { return false; }
+            pairLiterals(tables.litlen);
+            return buildTable(lengths + hlit, hdist, DIST_TABLE_BITS, tables.dist, distSymbol);
+        }
+
+
+        /// the body of a stored block, after the header bits
+        int copyStored(BitReader& reader, u8*& out, c_u8* outEnd) {
+            c_u8* in;
+            if (!reader.alignToByte(in)) { return TINF_DATA_ERROR; }
+            if (reader.end() - in < 4) { return TINF_DATA_ERROR; }
+
+            c_u32 length = in[0] | in[1] << 8;
+            c_u32 inverse = in[2] | in[3] << 8;
+            in += 4;
+            if (length != (~inverse & 0xFFFF)) { return TINF_DATA_ERROR; }
+            if (static_cast<size_t>(reader.end() - in) < length) { return TINF_DATA_ERROR; }
+            if (static_cast<size_t>(outEnd - out) < length) { return TINF_BUF_ERROR; }
+
+            std::memcpy(out, in, length);
+            out += length;
+            reader.restart(in + length);
+            return TINF_OK;
+        }
+
+
+        /// the body of a Huffman coded block
+        int decodeHuffman(BitReader& reader, const Tables& tables, c_u8* outStart, u8*& outRef, c_u8* outEnd) {
+            u8* out = outRef;
+            while (true) {
+                // 56 bits cover the longest symbol: 15 + 5 length bits, 15 + 13 distance bits
+                reader.refill();
+                u32 e = decodeSymbol(reader, tables.litlen, LITLEN_TABLE_BITS);
+
+                switch (entryKind(e)) {
+                    case KIND_LITERAL:
+                        if (out == outEnd) { return TINF_BUF_ERROR; }
+                        *out++ = static_cast<u8>(entryValue(e));
+                        continue;
+                    case KIND_DOUBLE:
+                        if (outEnd - out < 2) { return TINF_BUF_ERROR; }
+                        out[0] = static_cast<u8>(entryValue(e));
+                        out[1] = static_cast<u8>(entryValue(e) >> 8);
+                        out += 2;
+                        continue;
+                    case KIND_END:
+                        outRef = out;
+                        return TINF_OK;
+                    case KIND_BASE:
+                        break;
+                    default:
+                        return TINF_DATA_ERROR;
+                }
+
+                c_u32 length = entryValue(e) + reader.read(entryExtra(e));
+                e = decodeSymbol(reader, tables.dist, DIST_TABLE_BITS);
+                if (entryKind(e) != KIND_BASE) { return TINF_DATA_ERROR; }
+                c_u32 dist = entryValue(e) + reader.read(entryExtra(e));
+
+                if (dist > static_cast<size_t>(out - outStart)) { return TINF_DATA_ERROR; }
+                if (length > static_cast<size_t>(outEnd - out)) { return TINF_BUF_ERROR; }
+                copyMatch(out, dist, length, outEnd);
+                out += length;
+            }
+        }
+
+
+        /// the FAST backend, with the same results as tinf_uncompress
+        int fastUncompress(u8* dataOut, u32* sizeOut, c_u8* dataIn, c_u32 sizeIn) {
+            c_u8* outEnd = dataOut + *sizeOut;
+            u8* out = dataOut;
+            BitReader reader(dataIn, sizeIn);
+            // dynamic tables are too large for the stack of worker threads
+            thread_local Tables t_dynamic;
+
+            bool isFinal;
+            do {
+                reader.refill();
+                isFinal = reader.read(1) != 0;
+                c_u32 type = reader.read(2);
+
+                int status;
+                switch (type) {
+                    case 0:
+                        status = copyStored(reader, out, outEnd);
+                        break;
+                    case 1:
+                        status = decodeHuffman(reader, fixedTables(), dataOut, out, outEnd);
+                        break;
+                    case 2:
+                        status = readDynamicTables(reader, t_dynamic)
+                                 ? decodeHuffman(reader, t_dynamic, dataOut, out, outEnd)
+                                 : TINF_DATA_ERROR;
+                        break;
+                    default:
+                        status = TINF_DATA_ERROR;
+                        break;
+                }
+                if (status != TINF_OK) { return status; }
+                if (reader.overran()) { return TINF_DATA_ERROR; }
+            } while (!isFinal);
+
+            *sizeOut = static_cast<u32>(out - dataOut);
+            return TINF_OK;
+        }
+
+
+    } // namespace
+
+
+    int inflateRaw(c_u8* dataIn, c_u32 sizeIn, u8* dataOut, u32* sizeOut, const eInflateBackend backend) {
+        int result;
+        if (backend == eInflateBackend::TINF) {
+            unsigned int size = *sizeOut;
+            result = tinf_uncompress(dataOut, &size, dataIn, sizeIn);
+            *sizeOut = size;
+        } else {
+            result = fastUncompress(dataOut, sizeOut, dataIn, sizeIn);
+        }
+        return result == TINF_OK ? SUCCESS : DECOMPRESS;
+    }
+
+
+    int inflateZlib(c_u8* dataIn, c_u32 sizeIn, u8* dataOut, u32* sizeOut, const eInflateBackend backend) {
+        if (backend == eInflateBackend::TINF) {
+            unsigned int size = *sizeOut;
+            c_int result = tinf_zlib_uncompress(dataOut, &size, dataIn, sizeIn);
+            *sizeOut = size;
+            return result == TINF_OK ? SUCCESS : DECOMPRESS;
+        }
+
+        // the same checks as tinf_zlib_uncompress
+        if (sizeIn < 6) { return DECOMPRESS; }
+        c_u32 cmf = dataIn[0];
+        c_u32 flg = dataIn[1];
+        if ((cmf << 8 | flg) % 31 != 0 || (cmf & 15) != 8 || cmf >> 4 > 7 || (flg & 0x20) != 0) {
+            return DECOMPRESS;
+        }
+
+        if (fastUncompress(dataOut, sizeOut, dataIn + 2, sizeIn - 6) != TINF_OK) {
+            return DECOMPRESS;
+        }
+
+        c_u8* trailer = dataIn + sizeIn - 4;
+        c_u32 expected = static_cast<u32>(trailer[0]) << 24 | trailer[1] << 16 | trailer[2] << 8 | trailer[3];
+        if (adler32(adler32(0, nullptr, 0), dataOut, *sizeOut) != expected) {
+            return DECOMPRESS;
+        }
+        return SUCCESS;
+    }
+
+
+} // namespace codec
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "include/lce/processor.hpp"
+
+
+namespace codec {
+
+    enum class eInflateBackend : u8 {
+        /// the vendored reference decoder, compact but slow
+        TINF,
+        /// the editor's own single-shot decoder, see inflate.cpp
+        FAST,
+    };
+
+
+    /// the backend used when a call does not name one, FAST unless changed
+    MU ND eInflateBackend getInflateBackend();
+
+    /// switches every later call that does not name a backend, safe to call from any thread
+    MU void setInflateBackend(eInflateBackend backend);
+
+
+    /**
+     * Inflates raw deflate data, bytes after the final block are ignored.
+     *
+     * @param dataIn the compressed data
+     * @param sizeIn its size
+     * @param dataOut where the data is inflated to
+     * @param sizeOut the capacity of dataOut, set to the inflated size
+     * @param backend the decoder to use
+     * @return SUCCESS or DECOMPRESS
+     */
+    ND int inflateRaw(c_u8* dataIn, u32 sizeIn, u8* dataOut, u32* sizeOut,
+                      eInflateBackend backend = getInflateBackend());
+
+    /**
+     * Inflates a zlib stream: a 2-byte header, deflate data, and the Adler-32 of the
+     * inflated data in the last 4 bytes of dataIn, which is checked.
+     * @see inflateRaw
+     */
+    ND int inflateZlib(c_u8* dataIn, u32 sizeIn, u8* dataOut, u32* sizeOut,
+                       eInflateBackend backend = getInflateBackend());
+
+}
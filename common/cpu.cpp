@@ -0,0 +1,110 @@
+#include "cpu.hpp"
+
+#if CPU_X86_SIMD
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+
+namespace cmn {
+
+
+    namespace detail {
+        // scalar until the CPU has been asked, so kernels run before then are still correct
+        std::atomic<eSimdLevel> g_simdLevel{eSimdLevel::SCALAR};
+    }
+
+
+#if CPU_X86_SIMD
+    static void cpuid(c_u32 leaf, c_u32 subLeaf, u32 regs[4]) {
+#if defined(_MSC_VER)
+        int values[4];
+        __cpuidex(values, static_cast<int>(leaf), static_cast<int>(subLeaf));
+        for (int i = 0; i < 4; i++) { regs[i] = static_cast<u32>(values[i]); }
+#else
+        __cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+
+    /// the register state the OS saves on a context switch
+    static u64 xcr0() {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        u32 low, high;
+        __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+        return static_cast<u64>(high) << 32 | low;
+#endif
+    }
+#endif
+
+
+    eSimdLevel detectSimdLevel() {
+#if CPU_X86_SIMD
+        u32 regs[4];
+        cpuid(0, 0, regs);
+        c_u32 maxLeaf = regs[0];
+
+        cpuid(1, 0, regs);
+        c_u32 ecx1 = regs[2];
+        c_bool hasSSSE3 = ecx1 >> 9 & 1;
+        c_bool hasSSE42 = ecx1 >> 20 & 1;
+        c_bool hasXSave = ecx1 >> 27 & 1;
+        c_bool hasAVX = ecx1 >> 28 & 1;
+
+        // the CPU may have AVX while the OS does not preserve the ymm/zmm registers
+        c_u64 state = hasXSave ? xcr0() : 0;
+        c_bool osYmm = (state & 0x06) == 0x06;
+        c_bool osZmm = (state & 0xE6) == 0xE6;
+
+        u32 ebx7 = 0;
+        if (maxLeaf >= 7) {
+            cpuid(7, 0, regs);
+            ebx7 = regs[1];
+        }
+        c_bool hasAVX2 = ebx7 >> 5 & 1;
+        c_bool hasAVX512F = ebx7 >> 16 & 1;
+        c_bool hasAVX512BW = ebx7 >> 30 & 1;
+
+        if (!hasSSSE3) { return eSimdLevel::SSE2; }
+        if (!hasSSE42) { return eSimdLevel::SSSE3; }
+        if (!(hasAVX && hasAVX2 && osYmm)) { return eSimdLevel::SSE42; }
+        if (!(hasAVX512F && hasAVX512BW && osZmm)) { return eSimdLevel::AVX2; }
+        return eSimdLevel::AVX512;
+#else
+        return eSimdLevel::SCALAR;
+#endif
+    }
+
+
+    void setSimdLevel(const eSimdLevel level) {
+        c_auto detected = detectSimdLevel();
+        detail::g_simdLevel.store(level < detected ? level : detected, std::memory_order_relaxed);
+    }
+
+
+    const char* simdLevelName(const eSimdLevel level) {
+        switch (level) {
+            case eSimdLevel::SCALAR: return "scalar";
+            case eSimdLevel::SSE2: return "SSE2";
+            case eSimdLevel::SSSE3: return "SSSE3";
+            case eSimdLevel::SSE42: return "SSE4.2";
+            case eSimdLevel::AVX2: return "AVX2";
+            case eSimdLevel::AVX512: return "AVX-512";
+        }
+        return "unknown";
+    }
+
+
+    /// runs during static initialization, before main
+    MU static const bool s_detected = [] {
+        detail::g_simdLevel.store(detectSimdLevel(), std::memory_order_relaxed);
+        return true;
+    }();
+
+
+}
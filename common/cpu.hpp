@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+
+#include "include/lce/processor.hpp"
+
+
+/**
+ * Runtime selection of the vectorized kernels.
+ * \n\n
+ * SSE2 is part of every x86-64 CPU and is used directly. Kernels that gain from
+ * SSSE3, AVX2 or AVX-512 come in one function per instruction set, compiled with
+ * the matching CPU_TARGET_* attribute, and pick one with cmn::simdLevel() at the
+ * call. The level is detected with cpuid once, when the program starts.
+ */
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CPU_X86_SIMD 1
+#else
+#define CPU_X86_SIMD 0
+#endif
+
+#if CPU_X86_SIMD && (defined(__GNUC__) || defined(__clang__))
+#define CPU_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#define CPU_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#else
+// MSVC compiles every intrinsic without being asked
+#define CPU_TARGET_SSSE3
+#define CPU_TARGET_AVX2
+#define CPU_TARGET_AVX512
+#endif
+
+
+namespace cmn {
+
+    enum class eSimdLevel : u8 {
+        SCALAR,
+        SSE2,
+        SSSE3,
+        SSE42,
+        AVX2,
+        /// AVX-512 F and BW
+        AVX512,
+    };
+
+
+    namespace detail {
+        extern std::atomic<eSimdLevel> g_simdLevel;
+    }
+
+
+    /// the level the kernels use, what this CPU supports unless lowered with setSimdLevel
+    FORCEINLINE eSimdLevel simdLevel() noexcept {
+        return detail::g_simdLevel.load(std::memory_order_relaxed);
+    }
+
+    /// the best level this CPU and OS support
+    MU ND eSimdLevel detectSimdLevel();
+
+    /// lowers (or restores) the level every kernel uses, capped at detectSimdLevel()
+    MU void setSimdLevel(eSimdLevel level);
+
+    MU ND const char* simdLevelName(eSimdLevel level);
+
+}
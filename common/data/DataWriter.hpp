@@ -15,23 +15,24 @@ class DataWriter {
     Endian _end = Endian::Big;
     bool _external = false;
 
-    void grow(const std::size_t minExtra) {
+    void grow(const std::size_t minCap) {
         if (_external)
             throw std::length_error("DataWriter overflow (external buffer)");
         std::size_t newCap = _cap ? _cap * 2 : 256;
-        while (newCap < _pos + minExtra) newCap *= 2;
+        while (newCap < minCap) newCap *= 2;
         auto newBuf = std::unique_ptr<uint8_t[], void(*)(uint8_t*)>(new uint8_t[newCap], kDeleteArr);
-        if (_buf) std::memcpy(newBuf.get(), _buf.get(), _pos);
+        // copy past the cursor too, writers seek back to fill in headers
+        if (_buf) std::memcpy(newBuf.get(), _buf.get(), _cap);
         _buf = std::move(newBuf);
         _cap = newCap;
     }
     
     void need(const std::size_t n) {
-        if (_pos + n > _cap) grow(n);
+        if (_pos + n > _cap) grow(_pos + n);
     }
     
     void needAt(const std::size_t off, const std::size_t n) {
-        if (off + n > _cap) grow(off + n - _cap);
+        if (off + n > _cap) grow(off + n);
     }
 
 public:
@@ -62,6 +62,10 @@
     uint16_t tbl##_table[(1 << LZX_##tbl##_TABLEBITS) + (LZX_##tbl##_MAXSYMBOLS << 1)]; \
     uint8_t tbl##_len[LZX_##tbl##_MAXSYMBOLS + LZX_LENTABLE_SAFETY]
 
+/* the trees read for every symbol also get a table of symbol | length << 12,
+ * so a short code takes one lookup instead of two; 0 means "use the slow path" */
+#define LZX_DECLARE_FAST_TABLE(tbl) uint16_t tbl##_fast[1 << LZX_##tbl##_TABLEBITS]
+
 struct lzx_state {
     uint8_t* window;          /* the actual decoding window              */
     uint32_t window_size;     /* window size (32Kb through 2Mb)          */
@@ -82,6 +86,8 @@ struct lzx_state {
     LZX_DECLARE_TABLE(MAINTREE);
     LZX_DECLARE_TABLE(LENGTH);
     LZX_DECLARE_TABLE(ALIGNED);
+    LZX_DECLARE_FAST_TABLE(MAINTREE);
+    LZX_DECLARE_FAST_TABLE(LENGTH);
 };
 
 /* LZX decruncher */
@@ -240,33 +246,44 @@ void lzx_reset(struct lzx_state* pState) {
  *
  * These bit access routines work by using the area beyond the MSB and the
  * LSB as a free source of zeroes. This avoids having to mask any bits.
- * So we have to know the bit width of the bitbuffer variable. This is
- * sizeof(uint32_t) * 8, also defined as uint32_t_BITS
+ * So we have to know the bit width of the bitbuffer variable, BITBUF_BITS.
+ *
+ * The buffer is 64 bits wide and ENSURE_BITS tops it up to at least 49 bits
+ * at once, so most symbols are decoded without touching the input. Words
+ * past endinp read as zero and are counted in overrun instead of reading
+ * beyond the input, BITS_OVERRUN tells whether any of them were consumed.
  */
-
- /* number of bits in uint32_t. Note: This must be at multiple of 16, and at
-  * least 32 for the bitbuffer code to work (ie, it must be able to ensure
-  * up to 17 bits - that's adding 16 bits when there's one bit left, or
-  * adding 32 bits when there are no bits left. The code should work fine
-  * for machines where uint32_t >= 32 bits.
-  */
-#define uint32_t_BITS (sizeof(uint32_t) << 3)
+#define BITBUF_BITS 64
+#define BITBUF_FILL (BITBUF_BITS - 16)
 
 #define INIT_BITSTREAM \
     do {               \
         bitsleft = 0;  \
         bitbuf = 0;    \
+        overrun = 0;   \
     } while (0)
 
-#define ENSURE_BITS(n)                                                             \
-    while (bitsleft < (n)) {                                                       \
-        bitbuf |= ((inpos[1] << 8) | inpos[0]) << (uint32_t_BITS - 16 - bitsleft); \
-        bitsleft += 16;                                                            \
-        inpos += 2;                                                                \
+#define FILL_BITS                                                                          \
+    do {                                                                                   \
+        if (endinp - inpos >= 2) {                                                         \
+            bitbuf |= (uint64_t)((inpos[1] << 8) | inpos[0]) << (BITBUF_FILL - bitsleft);  \
+            inpos += 2;                                                                    \
+        }                                                                                  \
+        else {                                                                             \
+            inpos = endinp;                                                                \
+            overrun++;                                                                     \
+        }                                                                                  \
+        bitsleft += 16;                                                                    \
+    } while (bitsleft <= BITBUF_FILL)
+
+#define ENSURE_BITS(n)         \
+    if (bitsleft < (n)) {      \
+        FILL_BITS;             \
     }
 
-#define PEEK_BITS(n) (bitbuf >> (uint32_t_BITS - (n)))
+#define PEEK_BITS(n) ((uint32_t)(bitbuf >> (BITBUF_BITS - (n))))
 #define REMOVE_BITS(n) ((bitbuf <<= (n)), (bitsleft -= (n)))
+#define BITS_OVERRUN (overrun * 16 > bitsleft)
 
 #define READ_BITS(v, n)     \
     do {                    \
@@ -292,20 +309,27 @@ void lzx_reset(struct lzx_state* pState) {
         return DECR_ILLEGALDATA;                                                            \
     }
 
+#define FASTTABLE(tbl) (pState->tbl##_fast)
+
+#define BUILD_FAST_TABLE(tbl)                                                               \
+    BUILD_TABLE(tbl);                                                                       \
+    make_fast_table(MAXSYMBOLS(tbl), TABLEBITS(tbl), LENTABLE(tbl), SYMTABLE(tbl), FASTTABLE(tbl))
+
  /* READ_HUFFSYM(tablename, var) decodes one huffman symbol from the
-  * bitstream using the stated table and puts it in var.
+  * bitstream using the stated table and puts it in var. Codes longer
+  * than the table bits walk the tree stored after the table, one bit at a time.
   */
 #define READ_HUFFSYM(tbl, var)                                             \
     do {                                                                   \
         ENSURE_BITS(16);                                                   \
         hufftbl = SYMTABLE(tbl);                                           \
         if ((i = hufftbl[PEEK_BITS(TABLEBITS(tbl))]) >= MAXSYMBOLS(tbl)) { \
-            j = 1 << (uint32_t_BITS - TABLEBITS(tbl));                     \
+            uint64_t hufbit = (uint64_t)1 << (BITBUF_BITS - TABLEBITS(tbl)); \
             do {                                                           \
-                j >>= 1;                                                   \
+                hufbit >>= 1;                                              \
                 i <<= 1;                                                   \
-                i |= (bitbuf & j) ? 1 : 0;                                 \
-                if (!j) {                                                  \
+                i |= (bitbuf & hufbit) ? 1 : 0;                            \
+                if (!hufbit) {                                             \
                     return DECR_ILLEGALDATA;                               \
                 }                                                          \
             } while ((i = hufftbl[i]) >= MAXSYMBOLS(tbl));                 \
@@ -314,6 +338,21 @@ void lzx_reset(struct lzx_state* pState) {
         REMOVE_BITS(j);                                                    \
     } while (0)
 
+  /* READ_HUFFSYM_FAST(tablename, var) is READ_HUFFSYM for a tree built
+   * with BUILD_FAST_TABLE, codes longer than the table bits take the slow path.
+   */
+#define READ_HUFFSYM_FAST(tbl, var)                                 \
+    do {                                                            \
+        ENSURE_BITS(16);                                            \
+        if ((i = FASTTABLE(tbl)[PEEK_BITS(TABLEBITS(tbl))]) != 0) { \
+            (var) = i & 0xFFF;                                      \
+            REMOVE_BITS(i >> 12);                                   \
+        }                                                           \
+        else {                                                      \
+            READ_HUFFSYM(tbl, var);                                 \
+        }                                                           \
+    } while (0)
+
   /* READ_LENGTHS(tablename, first, last) reads in code lengths for symbols
    * first to last in the given table. The code lengths are stored in their
    * own special LZX way.
@@ -323,12 +362,15 @@ void lzx_reset(struct lzx_state* pState) {
         lb.bb = bitbuf;                                                   \
         lb.bl = bitsleft;                                                 \
         lb.ip = inpos;                                                    \
+        lb.ep = endinp;                                                   \
+        lb.ov = overrun;                                                  \
         if (lzx_read_lens(pState, LENTABLE(tbl), (first), (last), &lb)) { \
             return DECR_ILLEGALDATA;                                      \
         }                                                                 \
         bitbuf = lb.bb;                                                   \
         bitsleft = lb.bl;                                                 \
         inpos = lb.ip;                                                    \
+        overrun = lb.ov;                                                  \
     } while (0)
 
    /* make_decode_table(nsyms, nbits, length[], table[])
@@ -343,6 +385,9 @@ void lzx_reset(struct lzx_state* pState) {
     * table  = The table to fill up with decoded symbols and pointers.
     *
     * Returns 0 for OK or 1 for error
+    *
+    * The symbols are sorted by code length first, so each length visits
+    * only its own symbols rather than all nsyms of them.
     */
 static int make_decode_table(uint32_t nsyms, uint32_t nbits, const uint8_t * length, uint16_t* table) {
     uint16_t sym;
@@ -353,13 +398,29 @@ static int make_decode_table(uint32_t nsyms, uint32_t nbits, const uint8_t * len
     uint32_t table_mask = 1 << nbits;
     uint32_t bit_mask = table_mask >> 1; /* don't do 0 length codes */
     uint32_t next_symbol = bit_mask;     /* base of allocation for long codes */
+    uint16_t sorted[LZX_MAINTREE_MAXSYMBOLS];
+    uint32_t first[18] = { 0 }; /* sorted[first[n]] is the first symbol of length n */
+    uint32_t k;
+
+    for (sym = 0; sym < nsyms; sym++) {
+        if (length[sym] <= 16)
+            first[length[sym] + 1]++;
+    }
+    for (k = 1; k < 18; k++)
+        first[k] += first[k - 1];
+    for (sym = 0; sym < nsyms; sym++) {
+        if (length[sym] <= 16)
+            sorted[first[length[sym]]++] = sym;
+    }
+    /* the placement above moved every first[n] to the start of length n + 1 */
+    for (k = 17; k > 0; k--)
+        first[k] = first[k - 1];
+    first[0] = 0;
 
     /* fill entries for codes short enough for a direct mapping */
     while (bit_num <= nbits) {
-        for (sym = 0; sym < nsyms; sym++) {
-            if (length[sym] != bit_num) {
-                continue;
-            }
+        for (k = first[bit_num]; k < first[bit_num + 1]; k++) {
+            sym = sorted[k];
             leaf = pos;
 
             if ((pos += bit_mask) > table_mask)
@@ -388,10 +449,8 @@ static int make_decode_table(uint32_t nsyms, uint32_t nbits, const uint8_t * len
         bit_mask = 1 << 15;
 
         while (bit_num <= 16) {
-            for (sym = 0; sym < nsyms; sym++) {
-                if (length[sym] != bit_num) {
-                    continue;
-                }
+            for (k = first[bit_num]; k < first[bit_num + 1]; k++) {
+                sym = sorted[k];
                 leaf = pos >> 16;
                 for (fill = 0; fill < bit_num - nbits; fill++) {
                     /* if this path hasn't been taken yet, 'allocate' two entries */
@@ -427,10 +486,29 @@ static int make_decode_table(uint32_t nsyms, uint32_t nbits, const uint8_t * len
     return 0;
 }
 
+/* make_fast_table(nsyms, nbits, length[], table[], fast[])
+ *
+ * Fills fast with symbol | length << 12 for every table entry that decodes
+ * a code of nbits or less, and 0 for entries that point into the tree.
+ */
+static void make_fast_table(uint32_t nsyms, uint32_t nbits, const uint8_t * length, const uint16_t* table,
+                            uint16_t* fast) {
+    uint32_t pos, sym;
+    for (pos = 0; pos < (1U << nbits); pos++) {
+        sym = table[pos];
+        if (sym < nsyms && length[sym] != 0 && length[sym] <= nbits)
+            fast[pos] = (uint16_t)(sym | (length[sym] << 12));
+        else
+            fast[pos] = 0;
+    }
+}
+
 struct lzx_bits {
-    uint32_t bb;
+    uint64_t bb;
     int bl;
     uint8_t* ip;
+    uint8_t* ep;
+    int ov;
 };
 
 static int lzx_read_lens(struct lzx_state* pState, uint8_t* lens, uint32_t first, uint32_t last,
@@ -438,9 +516,11 @@ static int lzx_read_lens(struct lzx_state* pState, uint8_t* lens, uint32_t first
     uint32_t i, j, x, y;
     int z;
 
-    uint32_t bitbuf = lb->bb;
+    uint64_t bitbuf = lb->bb;
     int bitsleft = lb->bl;
     uint8_t* inpos = lb->ip;
+    uint8_t* endinp = lb->ep;
+    int overrun = lb->ov;
     uint16_t* hufftbl;
 
     for (x = 0; x < 20; x++) {
@@ -484,24 +564,63 @@ static int lzx_read_lens(struct lzx_state* pState, uint8_t* lens, uint32_t first
     lb->bb = bitbuf;
     lb->bl = bitsleft;
     lb->ip = inpos;
+    lb->ov = overrun;
     return 0;
 }
 
-int lzx_decompress(struct lzx_state* pState, unsigned char* inpos, unsigned char* outpos, int inlen,
-    int outlen) {
+/* lzx_copy_match(dest, src, length, limit)
+ *
+ * Copies a match that may overlap itself. Matches at least 8 bytes back are
+ * copied 8 bytes at a time when there is room up to limit for the last word
+ * to spill over, runs of a single byte are filled, anything else goes byte
+ * by byte. A NULL limit allows no spill, as in the ring window, where the
+ * bytes ahead of the match are still history.
+ */
+static void lzx_copy_match(uint8_t* dest, const uint8_t* src, int length, const uint8_t* limit) {
+    if (dest - src >= 8 && limit && dest + length + 8 <= limit) {
+        do {
+            memcpy(dest, src, 8);
+            dest += 8;
+            src += 8;
+            length -= 8;
+        } while (length > 0);
+    }
+    else if (dest - src >= length) {
+        memcpy(dest, src, (size_t)length);
+    }
+    else if (dest - src == 1) {
+        memset(dest, *src, (size_t)length);
+    }
+    else {
+        while (length-- > 0)
+            *dest++ = *src++;
+    }
+}
+
+/* lzx_decode(pState, inpos, inlen, window, posn, window_end, limit, outlen, flat)
+ *
+ * Decodes one frame of outlen bytes. In the ring window of the state
+ * (flat = 0) positions wrap at the window size. With flat = 1, window is
+ * the caller's output, holding every earlier frame of the stream, and the
+ * frame is decoded in place at *posn with no wrap around and no copy.
+ * window_end is where decoding must stop, limit the end of memory that may
+ * be written as scratch. *posn is advanced on success.
+ */
+static inline int lzx_decode(struct lzx_state* pState, uint8_t* inpos, int inlen, uint8_t* window,
+                             uint32_t* posn, uint32_t window_end, const uint8_t* limit,
+                             int outlen, int flat) {
     uint8_t* endinp = inpos + inlen;
-    uint8_t* window = pState->window;
+    uint32_t window_posn = *posn;
     uint8_t* runsrc, * rundest;
     uint16_t* hufftbl; /* used in READ_HUFFSYM macro as chosen decoding table */
 
-    uint32_t window_posn = pState->window_posn;
     uint32_t window_size = pState->window_size;
     uint32_t R0 = pState->R0;
     uint32_t R1 = pState->R1;
     uint32_t R2 = pState->R2;
 
-    uint32_t bitbuf;
-    int bitsleft;
+    uint64_t bitbuf;
+    int bitsleft, overrun;
     uint32_t match_offset, i, j, k; /* ijk used in READ_HUFFSYM macro */
     struct lzx_bits lb;             /* used in READ_LENGTHS macro */
 
@@ -549,24 +668,38 @@ int lzx_decompress(struct lzx_state* pState, unsigned char* inpos, unsigned char
             case LZX_BLOCKTYPE_VERBATIM:
                 READ_LENGTHS(MAINTREE, 0, 256);
                 READ_LENGTHS(MAINTREE, 256, pState->main_elements);
-                BUILD_TABLE(MAINTREE);
+                BUILD_FAST_TABLE(MAINTREE);
                 if (LENTABLE(MAINTREE)[0xE8] != 0)
                     pState->intel_started = 1;
 
                 READ_LENGTHS(LENGTH, 0, LZX_NUM_SECONDARY_LENGTHS);
-                BUILD_TABLE(LENGTH);
+                BUILD_FAST_TABLE(LENGTH);
                 break;
 
             case LZX_BLOCKTYPE_UNCOMPRESSED:
                 pState->intel_started = 1; /* because we can't assume otherwise */
-                ENSURE_BITS(16);           /* get up to 16 pad bits into the buffer */
-                if (bitsleft > 16)
-                    inpos -= 2; /* and align the bitstream! */
-                R0 = inpos[0] | (inpos[1] << 8) | (inpos[2] << 16) | (inpos[3] << 24);
+                /* 1 to 16 pad bits align the bitstream, then the buffered words are given back */
+                if (bitsleft == 0) {
+                    /* the pad word is still in the input */
+                    if (endinp - inpos < 2)
+                        return DECR_ILLEGALDATA;
+                    inpos += 2;
+                    k = 0;
+                }
+                else {
+                    /* whole buffered words, less the pad word when aligned already */
+                    k = (bitsleft >> 4) - ((bitsleft & 15) == 0);
+                }
+                if ((int)k < overrun)
+                    return DECR_ILLEGALDATA;
+                inpos -= 2 * (k - overrun);
+                if (endinp - inpos < 12)
+                    return DECR_ILLEGALDATA;
+                R0 = inpos[0] | (inpos[1] << 8) | (inpos[2] << 16) | ((uint32_t)inpos[3] << 24);
                 inpos += 4;
-                R1 = inpos[0] | (inpos[1] << 8) | (inpos[2] << 16) | (inpos[3] << 24);
+                R1 = inpos[0] | (inpos[1] << 8) | (inpos[2] << 16) | ((uint32_t)inpos[3] << 24);
                 inpos += 4;
-                R2 = inpos[0] | (inpos[1] << 8) | (inpos[2] << 16) | (inpos[3] << 24);
+                R2 = inpos[0] | (inpos[1] << 8) | (inpos[2] << 16) | ((uint32_t)inpos[3] << 24);
                 inpos += 4;
                 break;
 
@@ -575,19 +708,9 @@ int lzx_decompress(struct lzx_state* pState, unsigned char* inpos, unsigned char
             }
         }
 
-        /* buffer exhaustion check */
-        if (inpos > endinp) {
-            /* it's possible to have a file where the next run is less than
-             * 16 bits in size. In this case, the READ_HUFFSYM() macro used
-             * in building the tables will exhaust the buffer, so we should
-             * allow for this, but not allow those accidentally readBytes bits to
-             * be used (so we check that there are at least 16 bits
-             * remaining - in this boundary case they aren't really part of
-             * the compressed data)
-             */
-            if (inpos > (endinp + 2) || bitsleft < 16)
-                return DECR_ILLEGALDATA;
-        }
+        /* buffer exhaustion check: the zero words read past the end must not be used */
+        if (BITS_OVERRUN)
+            return DECR_ILLEGALDATA;
 
         while ((this_run = pState->block_remaining) > 0 && togo > 0) {
             if (this_run > togo)
@@ -595,109 +718,52 @@ int lzx_decompress(struct lzx_state* pState, unsigned char* inpos, unsigned char
             togo -= this_run;
             pState->block_remaining -= this_run;
 
-            /* apply 2^x-1 mask */
-            window_posn &= window_size - 1;
+            if (!flat) {
+                /* apply 2^x-1 mask */
+                window_posn &= window_size - 1;
+            }
             /* runs can't straddle the window wraparound */
-            if ((window_posn + this_run) > window_size)
+            if ((window_posn + this_run) > window_end)
                 return DECR_DATAFORMAT;
 
             switch (pState->block_type) {
             case LZX_BLOCKTYPE_VERBATIM:
+            case LZX_BLOCKTYPE_ALIGNED:
                 while (this_run > 0) {
-                    READ_HUFFSYM(MAINTREE, main_element);
+                    READ_HUFFSYM_FAST(MAINTREE, main_element);
 
                     if (main_element < LZX_NUM_CHARS) {
                         /* literal: 0 to LZX_NUM_CHARS-1 */
                         window[window_posn++] = main_element;
                         this_run--;
+                        continue;
                     }
-                    else {
-                        /* match: LZX_NUM_CHARS + ((slot<<3) | length_header (3 bits)) */
-                        main_element -= LZX_NUM_CHARS;
-
-                        match_length = main_element & LZX_NUM_PRIMARY_LENGTHS;
-                        if (match_length == LZX_NUM_PRIMARY_LENGTHS) {
-                            READ_HUFFSYM(LENGTH, length_footer);
-                            match_length += length_footer;
-                        }
-                        match_length += LZX_MIN_MATCH;
 
-                        match_offset = main_element >> 3;
+                    /* match: LZX_NUM_CHARS + ((slot<<3) | length_header (3 bits)) */
+                    main_element -= LZX_NUM_CHARS;
+
+                    match_length = main_element & LZX_NUM_PRIMARY_LENGTHS;
+                    if (match_length == LZX_NUM_PRIMARY_LENGTHS) {
+                        READ_HUFFSYM_FAST(LENGTH, length_footer);
+                        match_length += length_footer;
+                    }
+                    match_length += LZX_MIN_MATCH;
 
-                        if (match_offset > 2) {
-                            /* not repeated offset */
+                    match_offset = main_element >> 3;
+
+                    if (match_offset > 2) {
+                        /* not repeated offset */
+                        extra = extra_bits[match_offset];
+                        if (pState->block_type == LZX_BLOCKTYPE_VERBATIM) {
                             if (match_offset != 3) {
-                                extra = extra_bits[match_offset];
                                 READ_BITS(verbatim_bits, extra);
                                 match_offset = position_base[match_offset] - 2 + verbatim_bits;
                             }
                             else {
                                 match_offset = 1;
                             }
-
-                            /* update repeated offset LRU queue */
-                            R2 = R1;
-                            R1 = R0;
-                            R0 = match_offset;
-                        }
-                        else if (match_offset == 0) {
-                            match_offset = R0;
-                        }
-                        else if (match_offset == 1) {
-                            match_offset = R1;
-                            R1 = R0;
-                            R0 = match_offset;
-                        }
-                        else /* match_offset == 2 */ {
-                            match_offset = R2;
-                            R2 = R0;
-                            R0 = match_offset;
-                        }
-
-                        rundest = window + window_posn;
-                        runsrc = rundest - match_offset;
-                        window_posn += match_length;
-                        if (window_posn > window_size)
-                            return DECR_ILLEGALDATA;
-                        this_run -= match_length;
-
-                        /* copy any wrapped around source data */
-                        while ((runsrc < window) && (match_length-- > 0)) {
-                            *rundest++ = *(runsrc + window_size);
-                            runsrc++;
                         }
-                        /* copy match data - no worries about destination wraps */
-                        while (match_length-- > 0)
-                            *rundest++ = *runsrc++;
-                    }
-                }
-                break;
-
-            case LZX_BLOCKTYPE_ALIGNED:
-                while (this_run > 0) {
-                    READ_HUFFSYM(MAINTREE, main_element);
-
-                    if (main_element < LZX_NUM_CHARS) {
-                        /* literal: 0 to LZX_NUM_CHARS-1 */
-                        window[window_posn++] = main_element;
-                        this_run--;
-                    }
-                    else {
-                        /* match: LZX_NUM_CHARS + ((slot<<3) | length_header (3 bits)) */
-                        main_element -= LZX_NUM_CHARS;
-
-                        match_length = main_element & LZX_NUM_PRIMARY_LENGTHS;
-                        if (match_length == LZX_NUM_PRIMARY_LENGTHS) {
-                            READ_HUFFSYM(LENGTH, length_footer);
-                            match_length += length_footer;
-                        }
-                        match_length += LZX_MIN_MATCH;
-
-                        match_offset = main_element >> 3;
-
-                        if (match_offset > 2) {
-                            /* not repeated offset */
-                            extra = extra_bits[match_offset];
+                        else {
                             match_offset = position_base[match_offset] - 2;
                             if (extra > 3) {
                                 /* verbatim and aligned bits */
@@ -713,7 +779,7 @@ int lzx_decompress(struct lzx_state* pState, unsigned char* inpos, unsigned char
                                 match_offset += aligned_bits;
                             }
                             else if (extra > 0) { /* extra==1, extra==2 */
-                             /* verbatim bits only */
+                                /* verbatim bits only */
                                 READ_BITS(verbatim_bits, extra);
                                 match_offset += (uint32_t)verbatim_bits;
                             }
@@ -721,42 +787,49 @@ int lzx_decompress(struct lzx_state* pState, unsigned char* inpos, unsigned char
                                 /* ??? */
                                 match_offset = 1;
                             }
-
-                            /* update repeated offset LRU queue */
-                            R2 = R1;
-                            R1 = R0;
-                            R0 = match_offset;
-                        }
-                        else if (match_offset == 0) {
-                            match_offset = R0;
-                        }
-                        else if (match_offset == 1) {
-                            match_offset = R1;
-                            R1 = R0;
-                            R0 = match_offset;
-                        }
-                        else /* match_offset == 2 */ {
-                            match_offset = R2;
-                            R2 = R0;
-                            R0 = match_offset;
                         }
 
-                        rundest = window + window_posn;
-                        runsrc = rundest - match_offset;
-                        window_posn += (uint32_t)match_length;
-                        if (window_posn > window_size)
-                            return DECR_ILLEGALDATA;
-                        this_run -= match_length;
+                        /* update repeated offset LRU queue */
+                        R2 = R1;
+                        R1 = R0;
+                        R0 = match_offset;
+                    }
+                    else if (match_offset == 0) {
+                        match_offset = R0;
+                    }
+                    else if (match_offset == 1) {
+                        match_offset = R1;
+                        R1 = R0;
+                        R0 = match_offset;
+                    }
+                    else /* match_offset == 2 */ {
+                        match_offset = R2;
+                        R2 = R0;
+                        R0 = match_offset;
+                    }
 
-                        /* copy any wrapped around source data */
-                        while ((runsrc < window) && (match_length-- > 0)) {
-                            *rundest++ = *(runsrc + window_size);
-                            runsrc++;
-                        }
-                        /* copy match data - no worries about destination wraps */
-                        while (match_length-- > 0)
+                    rundest = window + window_posn;
+                    window_posn += match_length;
+                    if (window_posn > window_end)
+                        return DECR_ILLEGALDATA;
+                    this_run -= match_length;
+
+                    if (match_offset > (uint32_t)(rundest - window)) {
+                        /* only the ring window has data before its start */
+                        if (flat || match_offset > window_size)
+                            return DECR_ILLEGALDATA;
+                        /* copy the wrapped around source data first */
+                        runsrc = rundest + window_size - match_offset;
+                        k = match_offset - (uint32_t)(rundest - window);
+                        if ((int)k > match_length)
+                            k = match_length;
+                        match_length -= k;
+                        while (k-- > 0)
                             *rundest++ = *runsrc++;
+                        if (match_length == 0)
+                            continue;
                     }
+                    lzx_copy_match(rundest, rundest - match_offset, match_length, limit);
                 }
                 break;
 
@@ -774,16 +847,18 @@ int lzx_decompress(struct lzx_state* pState, unsigned char* inpos, unsigned char
         }
     }
 
-    if (togo != 0)
+    if (togo != 0 || BITS_OVERRUN)
         return DECR_ILLEGALDATA;
-    memcpy(outpos, window + ((!window_posn) ? window_size : window_posn) - outlen, (size_t)outlen);
 
-    pState->window_posn = window_posn;
+    *posn = window_posn;
     pState->R0 = R0;
     pState->R1 = R1;
     pState->R2 = R2;
+    return DECR_OK;
+}
 
-    /* intel E8 decoding */
+/* intel E8 decoding of a frame that was just written to outpos */
+static void lzx_intel_e8(struct lzx_state* pState, uint8_t* outpos, int outlen) {
     if ((pState->frames_read++ < 32768) && pState->intel_filesize != 0) {
         if (outlen <= 6 || !pState->intel_started) {
             pState->intel_curpos += outlen;
@@ -802,7 +877,7 @@ int lzx_decompress(struct lzx_state* pState, unsigned char* inpos, unsigned char
                     curpos++;
                     continue;
                 }
-                abs_off = data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
+                abs_off = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
                 if ((abs_off >= -curpos) && (abs_off < filesize)) {
                     rel_off = (abs_off >= 0) ? abs_off - curpos : abs_off + filesize;
                     data[0] = (uint8_t)rel_off;
@@ -815,6 +890,60 @@ int lzx_decompress(struct lzx_state* pState, unsigned char* inpos, unsigned char
             }
         }
     }
+}
+
+int lzx_decompress(struct lzx_state* pState, unsigned char* inpos, unsigned char* outpos, int inlen,
+    int outlen) {
+    uint32_t window_size = pState->window_size;
+    uint32_t window_posn = pState->window_posn;
+    int err = lzx_decode(pState, inpos, inlen, pState->window, &window_posn, window_size, NULL, outlen, 0);
+    if (err != DECR_OK)
+        return err;
+
+    memcpy(outpos, pState->window + ((!window_posn) ? window_size : window_posn) - outlen, (size_t)outlen);
+    pState->window_posn = window_posn;
+
+    lzx_intel_e8(pState, outpos, outlen);
     return DECR_OK;
 }
 
+/* copies the last window_size bytes of the total bytes of flat output to where
+ * the ring window would hold them, so decoding can carry on with lzx_decompress */
+static void lzx_seed_window(struct lzx_state* pState, const uint8_t* outbase, uint32_t total) {
+    uint32_t window_size = pState->window_size;
+    uint32_t start = (total > window_size) ? total - window_size : 0;
+    uint32_t posn = start & (window_size - 1);
+    uint32_t first = total - start;
+
+    if (first > window_size - posn)
+        first = window_size - posn;
+    memcpy(pState->window + posn, outbase + start, (size_t)first);
+    memcpy(pState->window, outbase + start + first, (size_t)(total - start - first));
+    pState->window_posn = total & (window_size - 1);
+}
+
+int lzx_decompress_flat(struct lzx_state* pState, unsigned char* inpos, int inlen, unsigned char* outbase,
+    int outpos, int outlen, int outcap) {
+    uint32_t window_posn = (uint32_t)outpos;
+    int err;
+
+    if (outpos < 0 || outlen < 0 || outcap - outpos < outlen)
+        return DECR_DATAFORMAT;
+
+    /* E8 translation rewrites the output, which must not become the history of
+     * later matches: such streams keep their history in the ring window instead */
+    if (pState->header_read && pState->intel_filesize != 0)
+        return lzx_decompress(pState, inpos, outbase + outpos, inlen, outlen);
+
+    err = lzx_decode(pState, inpos, inlen, outbase, &window_posn, (uint32_t)(outpos + outlen),
+                     outbase + outcap, outlen, 1);
+    if (err != DECR_OK)
+        return err;
+
+    /* the header was in this frame, the ring window takes over from here */
+    if (pState->intel_filesize != 0)
+        lzx_seed_window(pState, outbase, window_posn);
+
+    lzx_intel_e8(pState, outbase + outpos, outlen);
+    return DECR_OK;
+}
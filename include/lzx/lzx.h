@@ -51,6 +51,13 @@ extern "C" {
     /* decompress an LZX compressed block */
     int lzx_decompress(struct lzx_state* pState, unsigned char* inpos, unsigned char* outpos, int inlen, int outlen);
 
+    /* decompress an LZX compressed block straight into outbase + outpos, where
+     * outbase holds all earlier output of the stream and serves as the window;
+     * outcap is the size of outbase, bytes after the block may be overwritten;
+     * streams with E8 translation are decoded through the ring window instead */
+    int lzx_decompress_flat(struct lzx_state* pState, unsigned char* inpos, int inlen, unsigned char* outbase,
+                            int outpos, int outlen, int outcap);
+
 #ifdef __cplusplus
 }
 #endif
@@ -115,7 +115,7 @@ int main(int argc, char* argv[]) {
     log(eLog::detail,
              "Supports reading  [ Xbox360, PS3, RPCS3, PSVITA, PS4, WiiU/Cemu, Switch, Windurango ]\n");
     log(eLog::detail,
-             "Supports writing  [ -------  ---  RPCS3, PSVITA, ---  WiiU/Cemu  ------, ---------- ]\n\n");
+             "Supports writing  [ Xbox360, ---  RPCS3, PSVITA, ---  WiiU/Cemu  ------, ---------- ]\n\n");
 
     fs::path exePath = fs::path(argv[0]).parent_path();
     fs::path defaultOutDir = exePath / "out";
@@ -280,6 +280,21 @@ int main(int argc, char* argv[]) {
 
 
 
+    // optional tuning of the region conversion pipeline, 0 picks the default
+    auto pipelineConfig = outputConfig.value("pipeline", nlohmann::json::object());
+    if (!pipelineConfig.empty()) {
+        editor::RegionPipelineSettings& pipeline = writeSettings.m_regionPipeline;
+        pipeline.maxInFlight = pipelineConfig.value("maxInFlight", pipeline.maxInFlight);
+        pipeline.memoryBudget = pipelineConfig.value("memoryBudget", pipeline.memoryBudget);
+        pipeline.ioThreads = pipelineConfig.value("ioThreads", pipeline.ioThreads);
+        pipeline.decodeThreads = pipelineConfig.value("decodeThreads", pipeline.decodeThreads);
+        pipeline.transformThreads = pipelineConfig.value("transformThreads", pipeline.transformThreads);
+        pipeline.encodeThreads = pipelineConfig.value("encodeThreads", pipeline.encodeThreads);
+        pipeline.queueCapacity = pipelineConfig.value("queueCapacity", pipeline.queueCapacity);
+        log(eLog::info, "Using pipeline: maxInFlight=\"{}\"\n", pipeline.maxInFlight);
+    }
+    writeSettings.m_listingThreads = outputConfig.value("listingThreads", writeSettings.m_listingThreads);
+
     const std::string consoleStr = consoleToStr(consoleOutput);
     const fs::path outputPath = getOutputPath(jsonConfig, consoleStr, defaultOutDir);
     if (!outputPath.empty() && !fs::exists(outputPath)) {
@@ -329,7 +344,12 @@ int main(int argc, char* argv[]) {
         saveProject.printDetails();
 
 
-        editor::convert(saveProject, writeSettings);
+        try {
+            editor::convert(saveProject, writeSettings);
+        } catch (const std::exception& e) {
+            log(eLog::error, "Converting {} failed: {}\n", filePath.string(), e.what());
+            continue;
+        }
 
         saveProject.printDetails();
 
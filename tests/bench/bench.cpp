@@ -0,0 +1,647 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+
+#include "common/data/ghc/fs_std.hpp"
+#include "include/lce/processor.hpp"
+#include "include/nlohmann/json.hpp"
+
+#include "include/zlib-1.2.12/zlib.h"
+
+#include "common/RLE/rle.hpp"
+#include "common/RLE/rle_nsxps4.hpp"
+#include "common/RLE/rle_vita.hpp"
+#include "common/codec/XCompress.hpp"
+#include "common/codec/XDecompress.hpp"
+#include "common/codec/inflate.hpp"
+#include "common/cpu.hpp"
+#include "common/nbt.hpp"
+
+#include "code/Chunk/chunkData.hpp"
+#include "code/Chunk/chunkDataPool.hpp"
+#include "code/Chunk/helpers.hpp"
+#include "code/Chunk/v11.hpp"
+#include "code/Chunk/v12.hpp"
+#include "code/LCEFile/LCEFile.hpp"
+#include "code/Region/Region.hpp"
+#include "code/SaveFile/SaveGenerator.hpp"
+#include "code/SaveFile/SaveProject.hpp"
+#include "code/threaded.hpp"
+
+#include "tests/bench/harness.hpp"
+
+
+/**
+ * LegacyEditorBench
+ * \n\n
+ * Microbenchmarks for the codecs, chunk formats and region files. Everything runs
+ * on chunks from SaveGenerator with a fixed seed, so numbers are comparable between
+ * builds. --world also generates a whole save of the given width in chunks, and a
+ * real save can be added with --save to cover formats the editor cannot write yet
+ * (V13 chunks).
+ * \n\n
+ * --simd caps the instruction set the kernels pick at runtime, to compare levels
+ * on one binary: scalar, sse2, ssse3, sse4.2, avx2 or avx512.
+ * \n\n
+ * usage: LegacyEditorBench [--min-time seconds] [--filter text] [--out file.json]
+ *                          [--console name] [--chunks count] [--seed n]
+ *                          [--world chunks] [--save path] [--simd level]
+ */
+
+
+using namespace editor;
+
+
+struct Options {
+    double minTime = 0.5;
+    std::string filter;
+    std::string outPath;
+    lce::CONSOLE console = lce::CONSOLE::WIIU;
+    u32 chunkCount = 256;
+    u32 seed = 1;
+    u32 worldChunks = 0;
+    std::string savePath;
+};
+
+
+// #####################################################
+// #               Synthetic Data
+// #####################################################
+
+
+/// entities and tile entities in the shape the game writes them
+static NBTBase makeEntityNBT(const Options& options, c_int entityCount) {
+    GeneratorSettings settings;
+    settings.seed = options.seed;
+    settings.entityDensity = entityCount;
+    settings.tileEntityDensity = entityCount / 2;
+    const SaveGenerator generator(settings);
+
+    return makeCompound({{"", makeCompound({
+            {"Entities", generator.makeEntities(0, 0)},
+            {"TileEntities", generator.makeTileEntities(0, 0)}
+    })}});
+}
+
+
+static Buffer toBuffer(const DataWriter& writer) {
+    Buffer buffer(static_cast<u32>(writer.tell()));
+    std::memcpy(buffer.data(), writer.data(), buffer.size());
+    return buffer;
+}
+
+
+static Buffer writePayload(chunk::ChunkData& chunkData) {
+    DataWriter writer;
+    writer.write<u16>(chunkData.lastVersion);
+    if (chunkData.lastVersion == chunk::V_12) {
+        chunk::ChunkV12(&chunkData).writeChunk(writer);
+    } else {
+        chunk::ChunkV11(&chunkData).writeChunk(writer);
+    }
+    return toBuffer(writer);
+}
+
+
+/// a region where every chunk is encoded and compressed for the console
+static void makeRegion(const std::vector<chunk::ChunkData>& templates, c_u32 chunkCount,
+                       const lce::CONSOLE console, Region& region) {
+    region.m_console = console;
+    for (u32 i = 0; i < chunkCount; i++) {
+        ChunkManager& chunk = region.m_chunks[i];
+        chunk.chunkData = chunk::ChunkDataPool::instance().acquire();
+        *chunk.chunkData = templates[i % templates.size()];
+        chunk.chunkData->chunkX = static_cast<i32>(i % 32);
+        chunk.chunkData->chunkZ = static_cast<i32>(i / 32);
+        chunk.chunkHeader.setZipCompressed(0);
+        chunk.chunkHeader.setRLECompressed(0);
+        chunk.chunkHeader.setTimestamp(i);
+        chunk.writeChunk(console);
+    }
+}
+
+
+// #####################################################
+// #               Benchmarks
+// #####################################################
+
+
+static void benchCodecs(bench::Harness& harness, const Buffer& payload, const Buffer& regionFile) {
+    c_u32 size = payload.size();
+
+    // RLE used inside every chunk
+    Buffer rle(codec::RLE_compressBound(size));
+    u32 rleSize = 0;
+    harness.run("rle/compress", size, 1, [&] {
+        rleSize = rle.size();
+        codec::RLE_compress(payload.data(), size, rle.data(), rleSize);
+        bench::doNotOptimize(rleSize);
+    });
+    rleSize = rle.size();
+    codec::RLE_compress(payload.data(), size, rle.data(), rleSize);
+
+    Buffer decoded(size);
+    harness.run("rle/decompress", rleSize, 1, [&] {
+        u32 decodedSize = decoded.size();
+        codec::RLE_decompress(rle.data(), rleSize, decoded.data(), decodedSize);
+        bench::doNotOptimize(decodedSize);
+    });
+
+    // zero runs of new-gen region files
+    Buffer zeroRuns(codec::RLE_NSXPS4_compressBound(regionFile.size()));
+    u32 zeroRunsSize = 0;
+    harness.run("rle_nsxps4/compress", regionFile.size(), 0, [&] {
+        zeroRunsSize = codec::RLE_NSXPS4_COMPRESS(regionFile.data(), regionFile.size(),
+                                                  zeroRuns.data(), zeroRuns.size());
+        bench::doNotOptimize(zeroRunsSize);
+    });
+    *zeroRuns.size_ptr() = codec::RLE_NSXPS4_COMPRESS(regionFile.data(), regionFile.size(),
+                                                      zeroRuns.data(), zeroRuns.size());
+    Buffer regionOut(regionFile.size());
+    harness.run("rle_nsxps4/decompress", zeroRuns.size(), 0, [&] {
+        bench::doNotOptimize(codec::RLE_NSX_OR_PS4_DECOMPRESS(
+                zeroRuns.data(), zeroRuns.size(), regionOut.data(), regionOut.size()));
+    });
+
+    // vita
+    Buffer vita(codec::RLEVITA_compressBound(size));
+    u32 vitaSize = 0;
+    harness.run("rle_vita/compress", size, 1, [&] {
+        vitaSize = codec::RLEVITA_COMPRESS(payload.data(), size, vita.data(), vita.size());
+        bench::doNotOptimize(vitaSize);
+    });
+    vitaSize = codec::RLEVITA_COMPRESS(payload.data(), size, vita.data(), vita.size());
+    harness.run("rle_vita/decompress", vitaSize, 1, [&] {
+        bench::doNotOptimize(codec::RLEVITA_DECOMPRESS(vita.data(), vitaSize, decoded.data(), size));
+    });
+
+    // deflate, on the RLE output like ensureCompressed does
+    uLongf bound = compressBound(rleSize);
+    Buffer zipped(static_cast<u32>(bound));
+    uLongf zippedSize = bound;
+    harness.run("zlib/compress", rleSize, 1, [&] {
+        zippedSize = bound;
+        bench::doNotOptimize(compress(zipped.data(), &zippedSize, rle.data(), rleSize));
+    });
+    zippedSize = bound;
+    compress(zipped.data(), &zippedSize, rle.data(), rleSize);
+
+    Buffer inflated(rleSize);
+    for (c_auto backend : {codec::eInflateBackend::TINF, codec::eInflateBackend::FAST}) {
+        const std::string prefix = backend == codec::eInflateBackend::TINF ? "tinf" : "inflate_fast";
+        harness.run(prefix + "/zlib_uncompress", static_cast<u64>(zippedSize), 1, [&] {
+            u32 outSize = inflated.size();
+            bench::doNotOptimize(codec::inflateZlib(zipped.data(), static_cast<u32>(zippedSize),
+                                                    inflated.data(), &outSize, backend));
+        });
+        // PS3 chunks are the same stream without the 2-byte zlib header
+        harness.run(prefix + "/uncompress", static_cast<u64>(zippedSize) - 2, 1, [&] {
+            u32 outSize = inflated.size();
+            bench::doNotOptimize(codec::inflateRaw(zipped.data() + 2, static_cast<u32>(zippedSize) - 2,
+                                                   inflated.data(), &outSize, backend));
+        });
+    }
+
+    // the backends must agree, a faster wrong answer is no use
+    Buffer reference(rleSize);
+    u32 referenceSize = reference.size();
+    u32 inflatedSize = inflated.size();
+    c_int referenceStatus = codec::inflateZlib(zipped.data(), static_cast<u32>(zippedSize), reference.data(),
+                                               &referenceSize, codec::eInflateBackend::TINF);
+    c_int inflatedStatus = codec::inflateZlib(zipped.data(), static_cast<u32>(zippedSize), inflated.data(),
+                                              &inflatedSize, codec::eInflateBackend::FAST);
+    if (referenceStatus != inflatedStatus || referenceSize != inflatedSize
+        || std::memcmp(reference.data(), inflated.data(), referenceSize) != 0) {
+        printf("inflate_fast MISMATCH: differs from tinf\n");
+        harness.note("MISMATCH with tinf");
+        return;
+    }
+    harness.note("vendored zlib only ships deflate, compare with zlib/compress");
+
+    // LZX, on the RLE output like ensureCompressed does for Xbox 360
+    for (c_auto level : {codec::eXCompressLevel::FAST, codec::eXCompressLevel::OPTIMAL}) {
+        const std::string name = level == codec::eXCompressLevel::FAST ? "fast" : "optimal";
+        Buffer lzx;
+        harness.run("xcompress/" + name, rleSize, 1, [&] {
+            bench::doNotOptimize(codec::XCompress(std::span(rle.data(), rleSize), lzx, level));
+        });
+        if (codec::XCompress(std::span(rle.data(), rleSize), lzx, level) != SUCCESS) {
+            printf("xcompress/%s FAILED\n", name.c_str());
+            harness.note("FAILED");
+            continue;
+        }
+        harness.note(std::to_string(lzx.size()) + " bytes, zlib " + std::to_string(zippedSize));
+
+        u32 lzxSize = inflated.size();
+        if (codec::XDecompress(lzx.data(), lzx.size(), inflated.data(), &lzxSize) != codec::XmemErr::Ok
+            || lzxSize != rleSize || std::memcmp(inflated.data(), rle.data(), rleSize) != 0) {
+            printf("xcompress/%s MISMATCH: does not decompress to its input\n", name.c_str());
+            harness.note("MISMATCH after XDecompress");
+            continue;
+        }
+        harness.run("xdecompress/" + name, lzx.size(), 1, [&] {
+            u32 outSize = inflated.size();
+            bench::doNotOptimize(codec::XDecompress(lzx.data(), lzx.size(), inflated.data(), &outSize));
+        });
+    }
+
+    // a whole region file as one stream, the way a listing is compressed, with segments parsed in parallel
+    std::vector<u8> stream;
+    harness.run("xcompress/fast_parallel", regionFile.size(), 0, [&] {
+        codec::LzxCompressor compressor(regionFile.span(), codec::eXCompressLevel::FAST);
+        parallel_for(compressor.segmentCount(), [&](const size_t index) {
+            compressor.parseSegment(static_cast<u32>(index));
+        });
+        stream.clear();
+        for (u32 index = 0; index < compressor.segmentCount(); index++) {
+            bench::doNotOptimize(compressor.writeSegment(index, stream));
+        }
+    });
+    harness.note(std::to_string(stream.size()) + " bytes, " +
+                 std::to_string(ThreadPool::instance().concurrency()) + " threads");
+
+    // calls to a few targets, which E8 translation turns into repeats; the decoder rewrites
+    // them after each frame, and later frames must still match against the bytes from before
+    std::vector<u8> calls(regionFile.data(), regionFile.data() + regionFile.size());
+    for (u32 pos = 0; pos + 5 <= calls.size(); pos += 97) {
+        c_i32 rel = static_cast<i32>(0x1000 * (pos % 4)) - static_cast<i32>(pos) - 5;
+        calls[pos] = 0xE8;
+        std::memcpy(&calls[pos + 1], &rel, 4);
+    }
+    std::vector<u8> e8Stream;
+    codec::LzxCompressor e8Compressor(calls, codec::eXCompressLevel::FAST, static_cast<u32>(calls.size()));
+    for (u32 index = 0; index < e8Compressor.segmentCount(); index++) {
+        e8Compressor.parseSegment(index);
+        (void) e8Compressor.writeSegment(index, e8Stream);
+    }
+    Buffer e8Out(static_cast<u32>(calls.size()));
+    u32 e8Size = e8Out.size();
+    if (codec::XDecompress(e8Stream.data(), e8Stream.size(), e8Out.data(), &e8Size) != codec::XmemErr::Ok
+        || e8Size != calls.size() || std::memcmp(e8Out.data(), calls.data(), e8Size) != 0) {
+        printf("xdecompress/e8 MISMATCH: does not decompress to its input\n");
+        harness.note("MISMATCH after XDecompress");
+        return;
+    }
+    harness.run("xdecompress/e8", e8Stream.size(), 0, [&] {
+        u32 outSize = e8Out.size();
+        bench::doNotOptimize(codec::XDecompress(e8Stream.data(), e8Stream.size(), e8Out.data(), &outSize));
+    });
+}
+
+
+static void benchChunks(bench::Harness& harness, const chunk::ChunkData& aquatic, const chunk::ChunkData& elytra) {
+    for (const chunk::ChunkData* source : {&elytra, &aquatic}) {
+        chunk::ChunkData chunkData = *source;
+        const std::string name = source->lastVersion == chunk::V_12 ? "chunk/v12" : "chunk/v11";
+        const Buffer payload = writePayload(chunkData);
+
+        auto write = [](chunk::ChunkData& data) {
+            DataWriter writer;
+            writer.write<u16>(data.lastVersion);
+            if (data.lastVersion == chunk::V_12) {
+                chunk::ChunkV12(&data).writeChunk(writer);
+            } else {
+                chunk::ChunkV11(&data).writeChunk(writer);
+            }
+            bench::doNotOptimize(writer.tell());
+        };
+
+        harness.run(name + "/write", payload.size(), 1, [&] { write(chunkData); });
+
+        chunk::ChunkData target;
+        harness.run(name + "/read", payload.size(), 1, [&] {
+            DataReader reader(payload.data(), payload.size());
+            c_u16 version = reader.read<u16>();
+            target.lastVersion = version;
+            if (version == chunk::V_12) {
+                chunk::ChunkV12(&target).readChunk(reader);
+            } else {
+                chunk::ChunkV11(&target).readChunk(reader);
+            }
+            bench::doNotOptimize(target.validChunk);
+        });
+
+        // a chunk that was read and had its blocks edited, its light is written back as read
+        harness.run(name + "/rewrite", payload.size(), 1, [&] { write(target); });
+    }
+    harness.skip("chunk/v13/write", "the editor cannot write V13 chunks, V13 reads need --save");
+
+    chunk::ChunkData chunkData;
+    harness.run("convert/old_to_aquatic", 65536 * 3 / 2, 1, [&] { chunkData = elytra; }, [&] {
+        chunkData.convertOldToAquatic();
+    });
+    harness.run("convert/aquatic_to_elytra", 65536 * 2, 1, [&] { chunkData = aquatic; }, [&] {
+        chunkData.convertAquaticToElytra();
+    });
+}
+
+
+static void benchNBT(bench::Harness& harness, const Options& options) {
+    const NBTBase nbt = makeEntityNBT(options, 256);
+    DataWriter sizeWriter;
+    nbt.write(sizeWriter);
+    const Buffer encoded = toBuffer(sizeWriter);
+
+    harness.run("nbt/write", encoded.size(), 0, [&] {
+        DataWriter writer;
+        nbt.write(writer);
+        bench::doNotOptimize(writer.tell());
+    });
+    harness.run("nbt/read", encoded.size(), 0, [&] {
+        DataReader reader(encoded.data(), encoded.size());
+        NBTBase read;
+        read.read(reader);
+        bench::doNotOptimize(read.getType());
+    });
+}
+
+
+static void benchRegions(bench::Harness& harness, const std::vector<chunk::ChunkData>& templates,
+                         const Options& options, const fs::path& tempFolder, Buffer& regionFileOut) {
+    const lce::CONSOLE console = options.console;
+    Region source;
+    makeRegion(templates, options.chunkCount, console, source);
+    Buffer regionBuffer = source.write(console);
+    c_u32 regionSize = regionBuffer.size();
+
+    LCEFile file(console, 0, tempFolder, "r.0.0.mcr");
+    file.setBuffer(std::move(regionBuffer));
+    regionFileOut = file.getBuffer();
+
+    std::unique_ptr<Region> region;
+    auto readRegion = [&] {
+        region = std::make_unique<Region>();
+        region->read(&file);
+    };
+    auto decodeRegion = [&](c_bool dirty) {
+        readRegion();
+        for (ChunkManager& chunk : region->m_chunks) {
+            if (chunk.empty()) { continue; }
+            chunk.readChunk(console);
+            if (dirty && chunk.chunkData != nullptr) { chunk.chunkData->markDirty(); }
+        }
+    };
+
+    harness.run("region/read", regionSize, options.chunkCount, [&] {
+        region = std::make_unique<Region>();
+        region->read(&file);
+        bench::doNotOptimize(region->m_chunks.data());
+    });
+    harness.run("region/read_decode", regionSize, options.chunkCount, [&] { decodeRegion(false); });
+    harness.run("region/write", regionSize, options.chunkCount, [&] { decodeRegion(true); }, [&] {
+        Buffer out = region->write(console);
+        bench::doNotOptimize(out.size());
+    });
+    harness.run("region/write_unmodified", regionSize, options.chunkCount, [&] { decodeRegion(false); }, [&] {
+        Buffer out = region->write(console);
+        bench::doNotOptimize(out.size());
+    });
+    region.reset();
+}
+
+
+/// a whole generated save, for scaling past what a single region shows
+static void benchWorld(bench::Harness& harness, GeneratorSettings settings, const Options& options,
+                       const fs::path& folder) {
+    settings.worldChunks = options.worldChunks;
+    const SaveGenerator generator(settings);
+    c_u64 chunkCount = static_cast<u64>(options.worldChunks) * options.worldChunks;
+
+    std::unique_ptr<SaveProject> project;
+    harness.run("world/generate", 0, chunkCount, [&] {
+        fs::remove_all(folder);
+        project = std::make_unique<SaveProject>();
+    }, [&] {
+        bench::doNotOptimize(generator.generate(*project, folder));
+    });
+    if (project == nullptr) { return; }
+
+    std::vector<const LCEFile*> regionFiles;
+    u64 fileBytes = 0;
+    for (const LCEFile& file : *project) {
+        if (file.isRegionType() || file.isTinyRegionType()) {
+            regionFiles.push_back(&file);
+            fileBytes += file.detectSize();
+        }
+    }
+
+    harness.run("world/read_decode", fileBytes, chunkCount, [&] {
+        for (const LCEFile* file : regionFiles) {
+            Region region;
+            region.read(file);
+            for (ChunkManager& chunk : region.m_chunks) {
+                if (!chunk.empty()) { chunk.readChunk(region.m_console); }
+            }
+        }
+    });
+    harness.note(std::to_string(regionFiles.size()) + " region files");
+    fs::remove_all(folder);
+}
+
+
+/// formats the editor cannot produce itself, taken from a real save
+static void benchSample(bench::Harness& harness, const Options& options) {
+    SaveProject project;
+    if (project.read(options.savePath) != SUCCESS) {
+        harness.skip("sample", "failed to read " + options.savePath);
+        return;
+    }
+
+    std::vector<const LCEFile*> regionFiles;
+    u64 fileBytes = 0;
+    for (const LCEFile& file : project) {
+        if (file.isRegionType() || file.isTinyRegionType()) {
+            regionFiles.push_back(&file);
+            fileBytes += file.detectSize();
+        }
+    }
+    if (regionFiles.empty()) {
+        harness.skip("sample", "no region files in " + options.savePath);
+        return;
+    }
+
+    std::vector<std::unique_ptr<Region>> regions;
+    auto readAll = [&] {
+        regions.clear();
+        for (const LCEFile* file : regionFiles) {
+            regions.push_back(std::make_unique<Region>());
+            regions.back()->read(file);
+        }
+    };
+    auto forEachChunk = [&](const std::function<void(ChunkManager&, lce::CONSOLE)>& func) {
+        for (const auto& region : regions) {
+            for (ChunkManager& chunk : region->m_chunks) {
+                if (!chunk.empty()) { func(chunk, region->m_console); }
+            }
+        }
+    };
+
+    readAll();
+    u64 chunkCount = 0, compressedBytes = 0, decompressedBytes = 0;
+    std::map<int, u64> versions;
+    forEachChunk([&](ChunkManager& chunk, const lce::CONSOLE console) {
+        chunkCount++;
+        compressedBytes += chunk.payloadSize();
+        chunk.ensureDecompress(console);
+        decompressedBytes += chunk.payloadSize();
+        versions[chunk.checkVersion()]++;
+    });
+
+    std::string versionNote;
+    for (const auto& [version, count] : versions) {
+        versionNote += "v" + std::to_string(version) + ": " + std::to_string(count) + " ";
+    }
+
+    c_bool isXbox360 = project.m_stateSettings.console() == lce::CONSOLE::XBOX360;
+    harness.run("sample/region/read", fileBytes, chunkCount, readAll);
+    harness.run(isXbox360 ? "xdecompress/sample" : "sample/chunk/decompress", compressedBytes, chunkCount,
+                readAll, [&] {
+        forEachChunk([](ChunkManager& chunk, const lce::CONSOLE console) { chunk.ensureDecompress(console); });
+    });
+    harness.run("sample/chunk/read", decompressedBytes, chunkCount, [&] {
+        readAll();
+        forEachChunk([](ChunkManager& chunk, const lce::CONSOLE console) { chunk.ensureDecompress(console); });
+    }, [&] {
+        forEachChunk([](ChunkManager& chunk, const lce::CONSOLE console) { chunk.readChunk(console); });
+    });
+    harness.note(versionNote);
+    regions.clear();
+}
+
+
+// #####################################################
+// #               Main
+// #####################################################
+
+
+static bool parseOptions(c_int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+        if (arg == "--min-time") {
+            options.minTime = std::stod(next());
+        } else if (arg == "--filter") {
+            options.filter = next();
+        } else if (arg == "--out") {
+            options.outPath = next();
+        } else if (arg == "--console") {
+            options.console = lce::strToConsole(next());
+        } else if (arg == "--chunks") {
+            options.chunkCount = std::clamp(std::stoi(next()), 1, 1024);
+        } else if (arg == "--seed") {
+            options.seed = static_cast<u32>(std::stoul(next()));
+        } else if (arg == "--world") {
+            options.worldChunks = static_cast<u32>(std::stoul(next()));
+        } else if (arg == "--save") {
+            options.savePath = next();
+        } else if (arg == "--simd") {
+            const std::string name = next();
+            bool found = false;
+            for (int level = 0; level <= static_cast<int>(cmn::eSimdLevel::AVX512); level++) {
+                c_auto simd = static_cast<cmn::eSimdLevel>(level);
+                std::string levelName = cmn::simdLevelName(simd);
+                std::erase(levelName, '-');
+                std::ranges::transform(levelName, levelName.begin(), ::tolower);
+                if (levelName == name) {
+                    cmn::setSimdLevel(simd);
+                    found = true;
+                }
+            }
+            if (!found) {
+                printf("unknown --simd level '%s'\n", name.c_str());
+                return false;
+            }
+        } else {
+            printf("unknown argument '%s'\n", arg.c_str());
+            return false;
+        }
+    }
+    if (getChunkCodec(options.console) == eChunkCodec::NONE) {
+        printf("--console must be an old-gen console the editor can compress chunks for\n");
+        return false;
+    }
+    return true;
+}
+
+
+int main(c_int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            return -1;
+        }
+    } catch (const std::exception& e) {
+        printf("%s\n", e.what());
+        return -1;
+    }
+
+    bench::Harness harness;
+    harness.minSeconds = options.minTime;
+    harness.filter = options.filter;
+
+    GeneratorSettings settings;
+    settings.console = options.console;
+    settings.seed = options.seed;
+    settings.submergedRatio = 0.02;
+    const SaveGenerator generator(settings);
+
+    // a handful of distinct chunks, regions cycle through them
+    std::vector<chunk::ChunkData> templates(8);
+    for (size_t i = 0; i < templates.size(); i++) {
+        generator.makeChunk(static_cast<i32>(i), 0, templates[i]);
+    }
+    chunk::ChunkData elytra = templates[0];
+    elytra.convertAquaticToElytra();
+    chunk::ChunkData aquatic = templates[0];
+    const Buffer payload = writePayload(aquatic);
+
+    const fs::path tempFolder = fs::temp_directory_path() / "LegacyEditorBench";
+    fs::create_directories(tempFolder);
+
+    Buffer regionFile;
+    benchRegions(harness, templates, options, tempFolder, regionFile);
+    benchCodecs(harness, payload, regionFile);
+    benchChunks(harness, aquatic, elytra);
+    benchNBT(harness, options);
+    if (options.worldChunks != 0) {
+        benchWorld(harness, settings, options, tempFolder / "world");
+    } else {
+        harness.skip("world", "needs --world");
+    }
+    if (!options.savePath.empty()) {
+        benchSample(harness, options);
+    } else {
+        harness.skip("xdecompress/sample", "needs --save with an Xbox 360 save");
+        harness.skip("sample/chunk/read", "needs --save, covers V13 chunks");
+    }
+
+    fs::remove_all(tempFolder);
+
+    const nlohmann::json report = {
+            {"benchmark", "LegacyEditorBench"},
+            {"console", lce::consoleToStr(options.console)},
+            {"chunks", options.chunkCount},
+            {"seed", options.seed},
+            {"world_chunks", options.worldChunks},
+            {"min_time_s", options.minTime},
+            {"simd", cmn::simdLevelName(cmn::simdLevel())},
+            {"results", harness.toJson()}
+    };
+
+    if (options.outPath.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    } else {
+        std::ofstream out(options.outPath);
+        out << report.dump(2) << std::endl;
+        printf("wrote %s\n", options.outPath.c_str());
+    }
+    return 0;
+}
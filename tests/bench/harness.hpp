@@ -0,0 +1,176 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "include/lce/processor.hpp"
+#include "include/nlohmann/json.hpp"
+
+
+/**
+ * A small benchmark harness for LegacyEditorBench.
+ * \n\n
+ * Each benchmark is a function that is called repeatedly until a minimum amount
+ * of time has passed. An optional setup function runs before every call and is
+ * not timed, so benchmarks that consume their input (decompressing a chunk in
+ * place, writing a region) can rebuild it between calls.
+ */
+namespace bench {
+
+
+    /// keeps the compiler from optimizing away a result
+    template<typename T>
+    inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static const void* volatile sink;
+        sink = &value;
+#endif
+    }
+
+
+    struct Result {
+        std::string name;
+        u64 iterations = 0;
+        double seconds = 0;
+        double minSeconds = 0;
+        /// input bytes processed by one call, used for MB/s
+        u64 bytes = 0;
+        /// chunks processed by one call, used for chunks/s
+        u64 chunks = 0;
+        bool skipped = false;
+        std::string note;
+
+        ND double meanSeconds() const { return iterations ? seconds / static_cast<double>(iterations) : 0; }
+
+        ND double mbPerSecond() const {
+            return seconds > 0 ? static_cast<double>(bytes * iterations) / seconds / 1'000'000.0 : 0;
+        }
+
+        ND double chunksPerSecond() const {
+            return seconds > 0 ? static_cast<double>(chunks * iterations) / seconds : 0;
+        }
+
+        ND nlohmann::json toJson() const {
+            nlohmann::json json = {{"name", name}};
+            if (skipped) {
+                json["skipped"] = true;
+                json["note"] = note;
+                return json;
+            }
+            json["iterations"] = iterations;
+            json["mean_ns"] = meanSeconds() * 1e9;
+            json["min_ns"] = minSeconds * 1e9;
+            if (bytes != 0) {
+                json["bytes"] = bytes;
+                json["mb_per_s"] = mbPerSecond();
+            }
+            if (chunks != 0) {
+                json["chunks"] = chunks;
+                json["chunks_per_s"] = chunksPerSecond();
+            }
+            if (!note.empty()) {
+                json["note"] = note;
+            }
+            return json;
+        }
+    };
+
+
+    class Harness {
+        using Clock = std::chrono::steady_clock;
+
+        std::vector<Result> m_results;
+
+    public:
+        /// each benchmark runs at least this long
+        double minSeconds = 0.5;
+        /// and at least this many times
+        u64 minIterations = 3;
+        /// only benchmarks whose name contains this run
+        std::string filter;
+
+        ND bool enabled(const std::string& name) const {
+            return filter.empty() || name.find(filter) != std::string::npos;
+        }
+
+
+        /**
+         * Times func until minSeconds and minIterations are both reached.
+         * @param name e.g. "rle/compress"
+         * @param bytes input bytes per call
+         * @param chunks chunks per call
+         * @param setup untimed, runs before every call
+         * @param func the timed part
+         */
+        void run(const std::string& name, c_u64 bytes, c_u64 chunks,
+                 const std::function<void()>& setup, const std::function<void()>& func) {
+            if (!enabled(name)) { return; }
+
+            Result result;
+            result.name = name;
+            result.bytes = bytes;
+            result.chunks = chunks;
+            result.minSeconds = 1e30;
+
+            // warm up caches and the chunk data pool
+            if (setup) { setup(); }
+            func();
+
+            while (result.seconds < minSeconds || result.iterations < minIterations) {
+                if (setup) { setup(); }
+                const auto start = Clock::now();
+                func();
+                const auto stop = Clock::now();
+                c_auto elapsed = std::chrono::duration<double>(stop - start).count();
+                result.seconds += elapsed;
+                result.minSeconds = std::min(result.minSeconds, elapsed);
+                result.iterations++;
+            }
+
+            printf("%-40s %10.1f us %10.1f MB/s %12.1f chunks/s\n", name.c_str(),
+                   result.meanSeconds() * 1e6, result.mbPerSecond(), result.chunksPerSecond());
+            m_results.push_back(std::move(result));
+        }
+
+
+        void run(const std::string& name, c_u64 bytes, c_u64 chunks, const std::function<void()>& func) {
+            run(name, bytes, chunks, nullptr, func);
+        }
+
+
+        /// records a benchmark that could not run, so it still shows up in the report
+        void skip(const std::string& name, const std::string& reason) {
+            if (!enabled(name)) { return; }
+            Result result;
+            result.name = name;
+            result.skipped = true;
+            result.note = reason;
+            printf("%-40s skipped: %s\n", name.c_str(), reason.c_str());
+            m_results.push_back(std::move(result));
+        }
+
+
+        /// attaches a note to the most recent result
+        void note(const std::string& text) {
+            if (!m_results.empty()) { m_results.back().note = text; }
+        }
+
+
+        ND const std::vector<Result>& results() const { return m_results; }
+
+
+        ND nlohmann::json toJson() const {
+            nlohmann::json list = nlohmann::json::array();
+            for (const Result& result : m_results) {
+                list.push_back(result.toJson());
+            }
+            return list;
+        }
+    };
+
+
+} // namespace bench
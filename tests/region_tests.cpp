@@ -0,0 +1,343 @@
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "common/data/ghc/fs_std.hpp"
+#include "include/lce/processor.hpp"
+
+#include "code/LCEFile/LCEFile.hpp"
+#include "code/Region/Region.hpp"
+#include "code/Region/RegionCache.hpp"
+#include "code/Region/RegionPipeline.hpp"
+#include "code/SaveFile/SaveProject.hpp"
+
+
+/**
+ * LegacyEditorTests
+ * \n\n
+ * Regression tests for reading and writing region files. Every test prints the
+ * checks that failed, the exit code is the number of failed tests.
+ * \n\n
+ * usage: LegacyEditorTests [savefiles folder]
+ */
+
+
+using namespace editor;
+
+
+static int s_failedChecks = 0;
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            printf("    %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            s_failedChecks++;                                                         \
+        }                                                                             \
+    } while (false)
+
+
+// #####################################################
+// #               Helpers
+// #####################################################
+
+
+/// a region file kept in memory, the way SaveProject holds the files of a save
+static LCEFile makeFile(const lce::CONSOLE console, const lce::FILETYPE type, Buffer contents) {
+    LCEFile file(console);
+    file.setType(type);
+    c_auto owner = std::make_shared<const Buffer>(std::move(contents));
+    file.setView(owner, owner->span());
+    return file;
+}
+
+
+static std::vector<u8> copyContents(const LCEFile& file) {
+    const FileContents contents = file.getContents();
+    return {contents.data.begin(), contents.data.end()};
+}
+
+
+/// everything a chunk reader fills in, light expanded so it compares by value
+struct ChunkSnapshot {
+    i32 chunkX = 0, chunkZ = 0;
+    i64 lastUpdate = 0, inhabitedTime = 0;
+    i16 terrainPopulated = 0;
+    u8_vec blocks, blockData, skyLight, blockLight, heightMap, biomes;
+    NBTBase entities, tileEntities;
+
+    explicit ChunkSnapshot(chunk::ChunkData& data) :
+          chunkX(data.chunkX), chunkZ(data.chunkZ),
+          lastUpdate(data.lastUpdate), inhabitedTime(data.inhabitedTime),
+          terrainPopulated(data.terrainPopulated),
+          blocks(data.oldBlocks), blockData(data.blockData),
+          skyLight(data.skyLight.data(), data.skyLight.data() + chunk::LightData::SIZE),
+          blockLight(data.blockLight.data(), data.blockLight.data() + chunk::LightData::SIZE),
+          heightMap(data.heightMap), biomes(data.biomes),
+          entities(data.entities), tileEntities(data.tileEntities) {}
+
+    ND bool operator==(const ChunkSnapshot& other) const {
+        return chunkX == other.chunkX && chunkZ == other.chunkZ &&
+               lastUpdate == other.lastUpdate && inhabitedTime == other.inhabitedTime &&
+               terrainPopulated == other.terrainPopulated &&
+               blocks == other.blocks && blockData == other.blockData &&
+               skyLight == other.skyLight && blockLight == other.blockLight &&
+               heightMap == other.heightMap && biomes == other.biomes &&
+               entities.equals(other.entities) && tileEntities.equals(other.tileEntities);
+    }
+};
+
+
+// #####################################################
+// #               ChunkV11
+// #####################################################
+
+
+/**
+ * Reads the regions of a real V11 save, re-encodes every chunk through the V11 writer,
+ * and checks that reading the written region gives back the same chunks.
+ */
+static void testV11RoundTrip(const fs::path& saveFolder) {
+    // Switch save from 2018, its regions only hold V11 chunks
+    const fs::path savePath = saveFolder / "SWITCH" / "180827120249.dat";
+    constexpr auto consoleOut = lce::CONSOLE::WIIU;
+
+    SaveProject saveProject;
+    CHECK(saveProject.read(savePath) == SUCCESS);
+
+    int v11Chunks = 0;
+    for (LCEFile& file : saveProject) {
+        if (!file.isTinyRegionType()) { continue; }
+
+        Region region;
+        CHECK(region.read(&file) == SUCCESS);
+
+        std::vector<std::pair<size_t, ChunkSnapshot>> expected;
+        for (size_t i = 0; i < region.m_chunks.size(); i++) {
+            ChunkManager& chunk = region.m_chunks[i];
+            if (chunk.empty()) { continue; }
+            chunk.readChunk(region.m_console);
+            if (!chunk.isValidChunk() || chunk.chunkData->lastVersion != chunk::V_11) { continue; }
+            expected.emplace_back(i, ChunkSnapshot(*chunk.chunkData));
+            // force the writer to re-encode instead of reusing the original bytes
+            chunk.chunkData->markDirty();
+        }
+        v11Chunks += static_cast<int>(expected.size());
+
+        LCEFile written(consoleOut);
+        written.setType(lce::FILETYPE::OLD_REGION_OVERWORLD);
+        c_auto owner = std::make_shared<const Buffer>(region.write(consoleOut));
+        written.setView(owner, owner->span());
+
+        Region reread;
+        CHECK(reread.read(&written) == SUCCESS);
+        for (auto& [index, snapshot] : expected) {
+            ChunkManager& chunk = reread.m_chunks[index];
+            chunk.readChunk(consoleOut);
+            CHECK(chunk.isValidChunk());
+            if (!chunk.isValidChunk()) { continue; }
+            CHECK(chunk.chunkData->lastVersion == chunk::V_11);
+            CHECK(ChunkSnapshot(*chunk.chunkData) == snapshot);
+        }
+    }
+    CHECK(v11Chunks > 0);
+}
+
+
+// #####################################################
+// #               RegionCache
+// #####################################################
+
+
+/// first region of the Switch save rewritten as an old-gen WiiU region, in memory
+static Buffer makeOldGenRegion(const fs::path& saveFolder) {
+    SaveProject saveProject;
+    CHECK(saveProject.read(saveFolder / "SWITCH" / "180827120249.dat") == SUCCESS);
+    for (LCEFile& file : saveProject) {
+        if (!file.isTinyRegionType()) { continue; }
+        Region region;
+        CHECK(region.read(&file) == SUCCESS);
+        if (region.getNonEmptyChunk() == nullptr) { continue; }
+        return region.write(lce::CONSOLE::WIIU);
+    }
+    throw std::runtime_error("no region with chunks in the Switch save");
+}
+
+
+static ChunkManager* firstDecodedChunk(Region& region) {
+    for (ChunkManager& chunk : region.m_chunks) {
+        if (chunk.empty()) { continue; }
+        chunk.readChunk(region.m_console);
+        if (chunk.isValidChunk()) { return &chunk; }
+    }
+    return nullptr;
+}
+
+
+/// reads the file again, outside the cache
+static i64 readInhabitedTime(const LCEFile& file, const size_t index) {
+    Region region;
+    CHECK(region.read(&file) == SUCCESS);
+    ChunkManager& chunk = region.m_chunks[index];
+    chunk.readChunk(region.m_console);
+    return chunk.isValidChunk() ? chunk.chunkData->inhabitedTime : -1;
+}
+
+
+/// edited chunks are written back without markDirty(), and stay decoded so later edits are kept
+static void testCacheWritesBackChunkEdits(const fs::path& saveFolder) {
+    LCEFile file = makeFile(lce::CONSOLE::WIIU, lce::FILETYPE::OLD_REGION_OVERWORLD, makeOldGenRegion(saveFolder));
+    RegionCache cache;
+
+    Region* region = cache.get(file);
+    CHECK(region != nullptr);
+    if (region == nullptr) { return; }
+    ChunkManager* chunk = firstDecodedChunk(*region);
+    CHECK(chunk != nullptr);
+    if (chunk == nullptr) { return; }
+    c_auto index = static_cast<size_t>(chunk - region->m_chunks.data());
+
+    // reading alone leaves the region clean, so the file is not rewritten
+    c_auto before = file.getContents().owner;
+    CHECK(cache.flush() == SUCCESS);
+    CHECK(file.getContents().owner == before);
+
+    for (const i64 inhabitedTime : {1234, 5678}) {
+        chunk->chunkData->inhabitedTime = inhabitedTime;
+        chunk->chunkData->markDirty();
+        CHECK(cache.flush() == SUCCESS);
+
+        CHECK(!chunk->chunkHeader.isZipCompressed());
+        CHECK(chunk->isValidChunk());
+        CHECK(!chunk->isDirty());
+        CHECK(readInhabitedTime(file, index) == inhabitedTime);
+    }
+
+    // rewriting the region for another reason keeps the written edit, not the bytes first read
+    CHECK(cache.markDirty(file) == SUCCESS);
+    CHECK(cache.flush() == SUCCESS);
+    CHECK(readInhabitedTime(file, index) == 5678);
+}
+
+
+/// a region whose file cannot be written is kept cached through eviction, and written once it can be
+static void testCacheKeepsRegionsThatFailToWriteBack(const fs::path& saveFolder) {
+    const fs::path folder = fs::temp_directory_path() / "LegacyEditorTests_RegionCache";
+    fs::remove_all(folder);
+    fs::create_directories(folder);
+
+    LCEFile onDisk(lce::CONSOLE::WIIU, 0, folder, "");
+    onDisk.setType(lce::FILETYPE::OLD_REGION_OVERWORLD);
+    onDisk.setRegionX(0);
+    onDisk.setRegionZ(0);
+    onDisk.setFileName("r.0.0.mcr");
+    onDisk.setBuffer(makeOldGenRegion(saveFolder));
+    LCEFile inMemory = makeFile(lce::CONSOLE::WIIU, lce::FILETYPE::OLD_REGION_OVERWORLD, makeOldGenRegion(saveFolder));
+    inMemory.setRegionX(1);
+    inMemory.setRegionZ(0);
+
+    // a budget of one byte evicts every region but the last one used
+    RegionCache cache(1);
+    Region* region = cache.get(onDisk);
+    CHECK(region != nullptr);
+    if (region == nullptr) { return; }
+    ChunkManager* chunk = firstDecodedChunk(*region);
+    CHECK(chunk != nullptr);
+    if (chunk == nullptr) { return; }
+    c_auto index = static_cast<size_t>(chunk - region->m_chunks.data());
+    chunk->chunkData->inhabitedTime = 4321;
+    chunk->chunkData->markDirty();
+
+    fs::remove_all(folder);
+    CHECK(cache.get(inMemory) != nullptr);
+    CHECK(cache.find(onDisk) == region);
+    CHECK(cache.size() == 2);
+    CHECK(cache.setBudget(1) != SUCCESS);
+    CHECK(cache.clear() != SUCCESS);
+    CHECK(cache.find(onDisk) == region);
+
+    fs::create_directories(folder);
+    CHECK(cache.clear() == SUCCESS);
+    CHECK(cache.size() == 0);
+    CHECK(readInhabitedTime(onDisk, index) == 4321);
+    fs::remove_all(folder);
+}
+
+
+// #####################################################
+// #               RegionPipeline
+// #####################################################
+
+
+/// a region that cannot be read stops the pipeline, and no file is replaced by an empty region
+static void testPipelineKeepsUnreadableRegions() {
+    constexpr auto console = lce::CONSOLE::PS3;
+
+    // new-gen region whose RLE claims 16 bytes but holds 64
+    Buffer badRle(4 + 64);
+    c_u32 claimedSize = 16;
+    std::memcpy(badRle.data(), &claimedSize, 4);
+    std::memset(badRle.data() + 4, 0x11, 64);
+
+    // old-gen region whose first chunk lies past the end of the file
+    Buffer badSectors(0x2000);
+    std::memset(badSectors.data(), 0, badSectors.size());
+    badSectors.data()[2] = 0x40;
+    badSectors.data()[3] = 0x01;
+
+    std::vector<std::pair<lce::FILETYPE, Buffer*>> cases = {
+            {lce::FILETYPE::NEW_REGION_OVERWORLD, &badRle},
+            {lce::FILETYPE::OLD_REGION_OVERWORLD, &badSectors},
+    };
+    for (auto& [type, contents] : cases) {
+        LCEFile file = makeFile(console, type, std::move(*contents));
+        const std::vector<u8> before = copyContents(file);
+
+        bool threw = false;
+        try {
+            RegionPipeline().run({&file}, lce::CONSOLE::WIIU, false, {});
+        } catch (const std::exception&) {
+            threw = true;
+        }
+        CHECK(threw);
+        CHECK(copyContents(file) == before);
+        CHECK(file.m_console == console);
+    }
+}
+
+
+// #####################################################
+// #               main
+// #####################################################
+
+
+int main(int argc, char* argv[]) {
+    const fs::path saveFolder = argc > 1 ? fs::path(argv[1]) : fs::path("savefiles");
+
+    const std::vector<std::pair<const char*, std::function<void()>>> tests = {
+            {"pipeline keeps unreadable regions", testPipelineKeepsUnreadableRegions},
+            {"V11 chunks survive a round trip", [&saveFolder] { testV11RoundTrip(saveFolder); }},
+            {"cache writes back chunk edits", [&saveFolder] { testCacheWritesBackChunkEdits(saveFolder); }},
+            {"cache keeps regions that fail to write back",
+             [&saveFolder] { testCacheKeepsRegionsThatFailToWriteBack(saveFolder); }},
+    };
+
+    int failedTests = 0;
+    for (const auto& [name, test] : tests) {
+        c_int failedBefore = s_failedChecks;
+        printf("%s\n", name);
+        try {
+            test();
+        } catch (const std::exception& e) {
+            printf("    threw: %s\n", e.what());
+            s_failedChecks++;
+        }
+        if (s_failedChecks != failedBefore) { failedTests++; }
+    }
+
+    printf("%d of %zu tests failed\n", failedTests, tests.size());
+    return failedTests;
+}